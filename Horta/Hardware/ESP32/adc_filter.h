@@ -0,0 +1,59 @@
+/*
+    Filtro de leituras do ADC (mediana móvel)
+
+    Guarda as últimas ADC_FILTER_WINDOW leituras de um canal num buffer
+    circular. Cada leitura já chega como média de várias conversões
+    (sobreamostragem no ADC contínuo), e a mediana da janela descarta os
+    picos que a média deixa passar (rajadas do Wi-Fi, contato ruim):
+
+        AdcFilter soil;
+        soil.push(rawMean);          // a cada quadro do ADC
+        int value = soil.median();   // leitura usada pelo controle
+
+    Não depende do Arduino: compila também no host.
+*/
+
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#define ADC_FILTER_WINDOW 9         // Ímpar: a mediana é uma leitura real
+
+class AdcFilter {
+public:
+    void push(int value) {
+        ring_[head_] = value;
+        head_ = (head_ + 1) % ADC_FILTER_WINDOW;
+        if (count_ < ADC_FILTER_WINDOW) count_++;
+    }
+
+    bool empty() const { return count_ == 0; }
+    int count() const { return count_; }
+
+    int median() const {
+        int sorted[ADC_FILTER_WINDOW];
+        // Ordenação por inserção: janela pequena, sem alocação
+        for (int i = 0; i < count_; i++) {
+            int value = ring_[i];
+            int j = i;
+            while (j > 0 && sorted[j - 1] > value) {
+                sorted[j] = sorted[j - 1];
+                j--;
+            }
+            sorted[j] = value;
+        }
+        return count_ > 0 ? sorted[count_ / 2] : 0;
+    }
+
+    int mean() const {
+        long sum = 0;
+        for (int i = 0; i < count_; i++) sum += ring_[i];
+        return count_ > 0 ? (int)(sum / count_) : 0;
+    }
+
+private:
+    int ring_[ADC_FILTER_WINDOW] = {0};
+    int head_ = 0;
+    int count_ = 0;
+};
+
+#endif // ADC_FILTER_H
@@ -0,0 +1,113 @@
+/*
+    Amostragem contínua do ADC1 por DMA (ESP32, Arduino)
+
+    Em vez de um analogRead() bloqueante por loop(), o ADC converte os
+    pinos registrados em segundo plano (modo contínuo, DMA). A cada quadro
+    o driver entrega a média de ADC_STREAM_OVERSAMPLE conversões por pino.
+    poll(), chamado por uma tarefa periódica curta (~100 ms), põe o quadro
+    no AdcFilter do pino; read() só devolve a mediana dos últimos quadros,
+    sem amostrar e sem esperar:
+
+        AdcStream adc;
+        const int pins[] = {35, 34};
+        adc.begin(pins, 2);
+        adc.poll();                      // tarefa periódica
+        int soil;
+        if (adc.read(35, &soil)) { ... }
+
+    Assim a mediana cobre quadros seguidos, não as últimas leituras de
+    quem consome (que podem estar a segundos uma da outra).
+
+    Usa a API analogContinuous() do Arduino-ESP32 3.x (ESP-IDF 5). No 2.x
+    cada poll() faz um analogRead() por pino, com o mesmo filtro; begin()
+    faz o primeiro, para read() já ter valor.
+    O modo contínuo só atende o ADC1 (GPIO 32-39).
+*/
+
+#ifndef ADC_STREAM_H
+#define ADC_STREAM_H
+
+#include <Arduino.h>
+#include <esp_idf_version.h>
+#include "adc_filter.h"
+
+#define ADC_STREAM_MAX_PINS 4
+#define ADC_STREAM_OVERSAMPLE 64    // Conversões por pino em cada quadro
+#define ADC_STREAM_RATE_HZ 20000    // Taxa total do ADC (todos os pinos)
+
+class AdcStream {
+public:
+    // Registra os pinos e inicia a conversão contínua
+    bool begin(const int *pins, int count) {
+        if (count > ADC_STREAM_MAX_PINS) count = ADC_STREAM_MAX_PINS;
+        count_ = count;
+        uint8_t pins8[ADC_STREAM_MAX_PINS];
+        for (int i = 0; i < count; i++) {
+            pins_[i] = pins[i];
+            pins8[i] = (uint8_t)pins[i];
+        }
+#if ESP_IDF_VERSION_MAJOR >= 5
+        continuous_ = analogContinuous(pins8, count, ADC_STREAM_OVERSAMPLE, ADC_STREAM_RATE_HZ, onFrame) &&
+                      analogContinuousStart();
+#else
+        (void)pins8;
+        continuous_ = false;
+#endif
+        if (!continuous_) poll();
+        return continuous_;
+    }
+
+    // Consome o quadro pronto, se houver; nunca espera. Único ponto que
+    // amostra: chamar só da tarefa periódica
+    void poll() {
+#if ESP_IDF_VERSION_MAJOR >= 5
+        if (continuous_) {
+            if (!frameReady_) return;
+            frameReady_ = false;
+            adc_continuous_data_t *frame = NULL;
+            if (analogContinuousRead(&frame, 0)) {
+                for (int i = 0; i < count_; i++) {
+                    int index = indexOf(frame[i].pin);
+                    if (index >= 0) filters_[index].push(frame[i].avg_read_raw);
+                }
+            }
+            return;
+        }
+#endif
+        for (int i = 0; i < count_; i++) {
+            filters_[i].push(::analogRead(pins_[i]));
+        }
+    }
+
+    // Mediana filtrada do pino; false se o pino não é amostrado aqui ou
+    // se nenhum quadro chegou ainda
+    bool read(int pin, int *value) const {
+        int index = indexOf(pin);
+        if (index < 0) return false;
+        if (filters_[index].empty()) return false;
+        *value = filters_[index].median();
+        return true;
+    }
+
+    bool continuous() const { return continuous_; }
+
+private:
+    static void ARDUINO_ISR_ATTR onFrame() { frameReady_ = true; }
+
+    int indexOf(int pin) const {
+        for (int i = 0; i < count_; i++) {
+            if (pins_[i] == pin) return i;
+        }
+        return -1;
+    }
+
+    int pins_[ADC_STREAM_MAX_PINS];
+    AdcFilter filters_[ADC_STREAM_MAX_PINS];
+    int count_ = 0;
+    bool continuous_ = false;
+    static volatile bool frameReady_;
+};
+
+volatile bool AdcStream::frameReady_ = false;
+
+#endif // ADC_STREAM_H
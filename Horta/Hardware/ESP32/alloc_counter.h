@@ -0,0 +1,82 @@
+/*
+    Contador de alocações do heap (build de depuração)
+
+    O laço de controle roda por semanas; cada malloc() no caminho quente
+    fragmenta o heap do ESP32. Com CONTROLLER_COUNT_ALLOCS o esp32IA.cpp
+    lê `heapAllocations` antes e depois de cada loop() e guarda quantas
+    alocações o ciclo fez:
+
+        unsigned long before = heapAllocations;
+        scheduler.runDue(hal.millis());
+        loopAllocations = heapAllocations - before;    // esperado: 0
+
+    - ESP32: gancho do heap do ESP-IDF (CONFIG_HEAP_USE_HOOKS no
+      sdkconfig). Conta só as alocações da tarefa registrada com
+      allocCounterAttach() (o laço de controle); a pilha do Wi-Fi e o
+      núcleo de rede ficam de fora.
+    - Host (glibc): substitui malloc/calloc/realloc e repassa para o
+      alocador da glibc; conta tudo (o programa de host tem uma thread).
+      O operator new do C++ passa pelo malloc() e também é contado.
+
+    Incluir uma vez só, no arquivo que tem o loop().
+*/
+
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <stddef.h>
+
+volatile unsigned long heapAllocations = 0;
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+#if !CONFIG_HEAP_USE_HOOKS
+#error "CONTROLLER_COUNT_ALLOCS precisa de CONFIG_HEAP_USE_HOOKS=y no sdkconfig"
+#endif
+
+static TaskHandle_t volatile allocCounterTask = NULL;
+
+// Passa a contar as alocações da tarefa que chamou
+inline void allocCounterAttach() { allocCounterTask = xTaskGetCurrentTaskHandle(); }
+
+extern "C" void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    (void)ptr;
+    (void)size;
+    (void)caps;
+    if (allocCounterTask != NULL && xTaskGetCurrentTaskHandle() == allocCounterTask) heapAllocations++;
+}
+
+#else
+#include <stdlib.h>
+
+// Mesmas assinaturas do <stdlib.h> da glibc (noexcept no C++)
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size) noexcept {
+    heapAllocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+    heapAllocations++;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept {
+    heapAllocations++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) noexcept { __libc_free(ptr); }
+}
+
+inline void allocCounterAttach() {}
+#endif
+
+#endif // ALLOC_COUNTER_H
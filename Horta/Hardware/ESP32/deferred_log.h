@@ -0,0 +1,249 @@
+/*
+    Log binário adiado, com nível definido na compilação
+
+    O laço de controle não formata texto nem espera a UART (115200 baud,
+    ~87 µs por caractere). Cada LOG_*() grava num anel em RAM um registro
+    de tamanho fixo: o endereço do formato (o literal fica na flash e serve
+    de identificador) e os argumentos crus. Uma tarefa de baixa prioridade
+    formata e imprime depois:
+
+        LOG_INFO("Umidade do solo: %.2f %%\n", umidadeSolo);  // só copia 32 bytes
+        ...
+        logDrain(hal);                                         // tarefa "log"
+
+    - Níveis abaixo de LOG_LEVEL (padrão LOG_LEVEL_INFO) não geram código:
+      os argumentos nem são avaliados.
+    - O compilador confere o formato como num printf.
+    - %s só com texto de vida estática (literais, getModeText()): o
+      registro guarda o ponteiro, não o texto.
+    - Cada argumento ocupa 32 bits: %lu do host é truncado, %f perde a
+      precisão de double. Sem '*' na largura ou na precisão.
+    - Um anel SPSC por núcleo: controle e rede gravam sem trava. Em cada
+      núcleo só uma tarefa pode registrar.
+    - Anel cheio: o registro é descartado e contado; logDrain() avisa.
+    - Enquanto logImmediateOutput != NULL (setup(), antes de qualquer
+      outra tarefa existir), cada registro é impresso na hora, na ordem
+      dos hal.printf(). Desligue antes de criar as tarefas: o anel só
+      admite um consumidor.
+
+    Incluir uma vez só, no arquivo que tem o loop().
+*/
+
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include "hal.h"
+#include "spsc_ring.h"
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_MAX_ARGS 6
+#define LOG_RING_SIZE 64            // Registros por núcleo (potência de 2)
+#define LOG_CORES 2
+
+union LogArg {
+    int32_t i;
+    uint32_t u;
+    float f;
+    const char *s;
+};
+
+struct LogRecord {
+    const char *format;             // Identifica a mensagem
+    uint8_t argc;
+    LogArg args[LOG_MAX_ARGS];
+};
+
+SpscRing<LogRecord, LOG_RING_SIZE> logRings[LOG_CORES];
+std::atomic<unsigned long> logDropped[LOG_CORES];       // Só o produtor de cada núcleo escreve
+unsigned long logDroppedReported[LOG_CORES];            // Só logDrain() lê e escreve
+Hal *logImmediateOutput = NULL;
+
+inline int logCore() {
+#if defined(ARDUINO) && !CONFIG_FREERTOS_UNICORE
+    return xPortGetCoreID();
+#else
+    return 0;
+#endif
+}
+
+// ======= CAPTURA =======
+inline LogArg logArg(int value) { LogArg arg; arg.i = value; return arg; }
+inline LogArg logArg(long value) { LogArg arg; arg.i = (int32_t)value; return arg; }
+inline LogArg logArg(unsigned value) { LogArg arg; arg.u = value; return arg; }
+inline LogArg logArg(unsigned long value) { LogArg arg; arg.u = (uint32_t)value; return arg; }
+inline LogArg logArg(double value) { LogArg arg; arg.f = (float)value; return arg; }
+inline LogArg logArg(const char *value) { LogArg arg; arg.s = value; return arg; }
+
+inline void logPack(LogRecord &, int) {}
+
+template <typename T, typename... Rest>
+inline void logPack(LogRecord &record, int index, T value, Rest... rest) {
+    record.args[index] = logArg(value);
+    logPack(record, index + 1, rest...);
+}
+
+unsigned logDrain(Hal &out);
+
+template <typename... Args>
+inline void logWrite(const char *format, Args... args) {
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Argumentos demais para um registro de log");
+    LogRecord record;
+    record.format = format;
+    record.argc = sizeof...(Args);
+    logPack(record, 0, args...);
+    const int core = logCore();
+    if (!logRings[core].push(record)) logDropped[core].fetch_add(1, std::memory_order_relaxed);
+    if (logImmediateOutput != NULL) logDrain(*logImmediateOutput);
+}
+
+// Nunca chamada: só faz o compilador conferir o formato
+inline void logCheckFormat(const char *, ...) __attribute__((format(printf, 1, 2)));
+inline void logCheckFormat(const char *, ...) {}
+
+#define LOG_AT(...)                                  \
+    do {                                             \
+        if (false) logCheckFormat(__VA_ARGS__);      \
+        logWrite(__VA_ARGS__);                       \
+    } while (0)
+
+// Nível desligado: nenhum código gerado, mas o formato continua conferido
+// e as variáveis usadas só no log não viram avisos
+#define LOG_OFF(...)                                 \
+    do {                                             \
+        if (false) logCheckFormat(__VA_ARGS__);      \
+    } while (0)
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(__VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) LOG_AT(__VA_ARGS__)
+#else
+#define LOG_WARN(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LOG_AT(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_OFF(__VA_ARGS__)
+#endif
+
+// ======= FORMATAÇÃO (tarefa de log) =======
+// Percorre o formato e passa cada especificação ao snprintf com o tipo que
+// a conversão pede; devolve o tamanho do texto
+inline size_t logFormat(const LogRecord &record, char *out, size_t size) {
+    size_t length = 0;
+    int next = 0;
+    const char *p = record.format;
+    while (*p != '\0' && length + 1 < size) {
+        if (*p != '%') {
+            out[length++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[length++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // %[flags][largura][.precisão][h|l]conversão
+        const char *start = p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL) p++;
+        bool isLong = false;
+        while (*p == 'h' || *p == 'l') isLong |= (*p++ == 'l');
+        const char conversion = *p;
+        if (conversion != '\0') p++;
+
+        char spec[16];
+        const size_t specLength = p - start;
+        if (specLength >= sizeof(spec) || next >= record.argc) {
+            // Sem argumento: copia a especificação como texto
+            for (const char *c = start; c < p && length + 1 < size; c++) out[length++] = *c;
+            continue;
+        }
+        memcpy(spec, start, specLength);
+        spec[specLength] = '\0';
+
+        const LogArg arg = record.args[next++];
+        char *dest = out + length;
+        const size_t room = size - length;
+        int written = 0;
+        switch (conversion) {
+            case 'd':
+            case 'i':
+            case 'c':
+                written = isLong ? snprintf(dest, room, spec, (long)arg.i) : snprintf(dest, room, spec, (int)arg.i);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                written = isLong ? snprintf(dest, room, spec, (unsigned long)arg.u)
+                                 : snprintf(dest, room, spec, (unsigned)arg.u);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+                written = snprintf(dest, room, spec, (double)arg.f);
+                break;
+            case 's':
+                written = snprintf(dest, room, spec, arg.s != NULL ? arg.s : "(null)");
+                break;
+        }
+        if (written > 0) length += (size_t)written < room ? (size_t)written : room - 1;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// Formata e imprime tudo o que os núcleos registraram; devolve quantos
+// registros saíram. Núcleo por núcleo: a ordem entre núcleos não é mantida
+unsigned logDrain(Hal &out) {
+    char line[HAL_PRINTF_BUFFER];
+    unsigned drained = 0;
+    LogRecord record;
+    for (int core = 0; core < LOG_CORES; core++) {
+        while (logRings[core].pop(&record)) {
+            logFormat(record, line, sizeof(line));
+            out.print(line);
+            drained++;
+        }
+        const unsigned long dropped = logDropped[core].load(std::memory_order_relaxed);
+        if (dropped != logDroppedReported[core]) {
+            out.printf("⚠️ Log: %lu registros descartados no núcleo %d (anel cheio)\n",
+                       dropped - logDroppedReported[core], core);
+            logDroppedReported[core] = dropped;
+        }
+    }
+    return drained;
+}
+
+#endif // DEFERRED_LOG_H
@@ -0,0 +1,171 @@
+/*
+    Leitura não bloqueante do DHT11/DHT22 (ESP32, Arduino)
+
+    A biblioteca DHT lê os 40 bits em espera ativa, com as interrupções
+    desligadas por ~5 ms, depois de um pulso de início de 18-20 ms com
+    delay(). Aqui a transação vira uma máquina de estados avançada por
+    poll(), que nunca espera:
+
+        IDLE ──(intervalo)──> START: linha em LOW (pulso de início)
+        START ──(20 ms)─────> RECEIVE: linha solta, interrupção CHANGE
+                                       grava o instante de cada borda
+        RECEIVE ──(bordas ou 10 ms)──> decodifica, confere o checksum,
+                                       volta para IDLE
+
+    Cada bit é um pulso em HIGH de ~27 us (0) ou ~70 us (1); a decodificação
+    usa os últimos 40 pulsos completos em HIGH. Leituras com checksum errado
+    ou incompletas são descartadas e a última amostra válida continua
+    disponível, com a idade em ms:
+
+        DhtAsync dht(4, DHT11);
+        dht.begin();
+        ...
+        unsigned long next = dht.poll();              // de novo em `next` ms
+        float t, h;
+        unsigned long age;
+        if (dht.sample(&t, &h, &age) && age < 10000) { ... }
+*/
+
+#ifndef DHT_ASYNC_H
+#define DHT_ASYNC_H
+
+#include <Arduino.h>
+
+#ifndef DHT11
+#define DHT11 11
+#endif
+#ifndef DHT22
+#define DHT22 22
+#endif
+
+#define DHT_ASYNC_INTERVAL_MS 2000      // DHT11: no máximo uma leitura a cada 1-2 s
+#define DHT_ASYNC_START_MS 20           // Pulso de início em LOW (mínimo 18 ms)
+#define DHT_ASYNC_TIMEOUT_MS 10         // Transação completa leva ~4-5 ms
+#define DHT_ASYNC_MAX_EDGES 96          // 2 da resposta + 80 dos bits + folga
+#define DHT_ASYNC_ONE_US 50             // Pulso em HIGH acima disso = bit 1
+
+class DhtAsync {
+public:
+    DhtAsync(uint8_t pin, uint8_t type) : pin_(pin), type_(type) {}
+
+    void begin() {
+        pinMode(pin_, INPUT_PULLUP);
+        lastStart_ = millis() - DHT_ASYNC_INTERVAL_MS;  // Primeira transação no próximo poll()
+    }
+
+    // Avança a transação; retorna rápido em todos os estados. Devolve em
+    // quantos ms a transação precisa de outro poll()
+    unsigned long poll() {
+        unsigned long now = millis();
+        switch (state_) {
+            case IDLE:
+                if (now - lastStart_ >= DHT_ASYNC_INTERVAL_MS) {
+                    lastStart_ = now;
+                    pinMode(pin_, OUTPUT);
+                    digitalWrite(pin_, LOW);
+                    state_ = START;
+                    return DHT_ASYNC_START_MS;
+                }
+                return DHT_ASYNC_INTERVAL_MS - (now - lastStart_);
+            case START:
+                if (now - lastStart_ >= DHT_ASYNC_START_MS) {
+                    edgeCount_ = 0;
+                    attachInterruptArg(digitalPinToInterrupt(pin_), onEdge, this, CHANGE);
+                    pinMode(pin_, INPUT_PULLUP);  // Solta a linha: o sensor responde
+                    receiveStart_ = now;
+                    state_ = RECEIVE;
+                    return DHT_ASYNC_TIMEOUT_MS;
+                }
+                return DHT_ASYNC_START_MS - (now - lastStart_);
+            case RECEIVE:
+                if (edgeCount_ >= DHT_ASYNC_MAX_EDGES || now - receiveStart_ >= DHT_ASYNC_TIMEOUT_MS) {
+                    detachInterrupt(digitalPinToInterrupt(pin_));
+                    if (decode()) {
+                        sampleTime_ = now;
+                        valid_ = true;
+                    } else {
+                        failures_++;
+                    }
+                    state_ = IDLE;
+                    return now - lastStart_ < DHT_ASYNC_INTERVAL_MS ? DHT_ASYNC_INTERVAL_MS - (now - lastStart_) : 0;
+                }
+                return DHT_ASYNC_TIMEOUT_MS - (now - receiveStart_);
+        }
+        return DHT_ASYNC_INTERVAL_MS;
+    }
+
+    // Última amostra válida e sua idade; false se nenhuma leitura deu certo ainda
+    bool sample(float *temperature, float *humidity, unsigned long *ageMs) const {
+        if (!valid_) return false;
+        *temperature = temperature_;
+        *humidity = humidity_;
+        *ageMs = millis() - sampleTime_;
+        return true;
+    }
+
+    unsigned long failures() const { return failures_; }
+
+private:
+    enum State { IDLE, START, RECEIVE };
+
+    static void IRAM_ATTR onEdge(void *arg) {
+        DhtAsync *self = (DhtAsync *)arg;
+        uint8_t n = self->edgeCount_;
+        if (n < DHT_ASYNC_MAX_EDGES) {
+            self->edgeTimes_[n] = micros();
+            self->edgeLevels_[n] = digitalRead(self->pin_);
+            self->edgeCount_ = n + 1;
+        }
+    }
+
+    // Converte os pulsos em HIGH nos 5 bytes e confere o checksum
+    bool decode() {
+        uint8_t count = edgeCount_;
+        uint32_t pulses[40];
+        int found = 0;
+        // De trás para frente: os últimos 40 pulsos completos em HIGH são os bits
+        for (int i = count - 1; i > 0 && found < 40; i--) {
+            if (edgeLevels_[i] == LOW && edgeLevels_[i - 1] == HIGH) {
+                pulses[39 - found] = edgeTimes_[i] - edgeTimes_[i - 1];
+                found++;
+            }
+        }
+        if (found < 40) return false;
+
+        uint8_t data[5] = {0, 0, 0, 0, 0};
+        for (int bit = 0; bit < 40; bit++) {
+            data[bit / 8] <<= 1;
+            if (pulses[bit] > DHT_ASYNC_ONE_US) data[bit / 8] |= 1;
+        }
+        if ((uint8_t)(data[0] + data[1] + data[2] + data[3]) != data[4]) return false;
+
+        if (type_ == DHT11) {
+            humidity_ = data[0] + data[1] * 0.1f;
+            temperature_ = data[2] + (data[3] & 0x0F) * 0.1f;
+            if (data[3] & 0x80) temperature_ = -temperature_;
+        } else {
+            humidity_ = ((data[0] << 8) | data[1]) * 0.1f;
+            temperature_ = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+            if (data[2] & 0x80) temperature_ = -temperature_;
+        }
+        return true;
+    }
+
+    uint8_t pin_;
+    uint8_t type_;
+    State state_ = IDLE;
+    unsigned long lastStart_ = 0;
+    unsigned long receiveStart_ = 0;
+
+    volatile uint8_t edgeCount_ = 0;
+    volatile uint32_t edgeTimes_[DHT_ASYNC_MAX_EDGES];
+    volatile uint8_t edgeLevels_[DHT_ASYNC_MAX_EDGES];
+
+    bool valid_ = false;
+    float temperature_ = NAN;
+    float humidity_ = NAN;
+    unsigned long sampleTime_ = 0;
+    unsigned long failures_ = 0;
+};
+
+#endif // DHT_ASYNC_H
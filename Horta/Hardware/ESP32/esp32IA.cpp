@@ -1,53 +1,101 @@
 /*
     Sistema de Irrigação Inteligente com ESP32, KNN e ThingsBoard
     Features: Temperatura, Umidade do Ar, Umidade do Solo + IoT
-    
+
     Sensores:
     - DHT11: Temperatura e Umidade do ar
     - FC-28: Umidade do solo
     - FC-37: Sensor precipitação
     - BMP280: Sensor de pressão atmosférica
     - Sensores de nível: Controle automático do tanque
-    
+
     IoT: ThingsBoard para monitoramento e controle remoto
+
+    Todo acesso ao hardware passa pela HAL (hal.h). Sem ARDUINO definido,
+    o arquivo compila no Linux contra host/hal_host.h, sem o callback RPC,
+    a NVS e a partição do modelo (ver host/controller_bench.cpp).
 */
 
-#include <DHT.h>
-#include <Wire.h>
-#include <Adafruit_BMP280.h>
-#include <WiFi.h>
-#include <PubSubClient.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "json_writer.h"
+#include "task_scheduler.h"
+#include "spsc_ring.h"
+#include "telemetry_deadband.h"
+// #define LOG_LEVEL LOG_LEVEL_DEBUG  // Também as linhas DEBUG do tanque e da verificação de umidade
+#include "deferred_log.h"
+#ifdef ARDUINO
 #include <ArduinoJson.h>
-#include "model_data.h"  // Header com os dados do modelo KNN
+#include "hal_esp32.h"
+#endif
+#define KNN_USE_KDTREE           // Busca exata pela KD-tree exportada em model_data.h
+// #define KNN_USE_QUANTIZED     // Alternativa: protótipos int16 (metade da flash)
+#include "knn.h"         // Inferência KNN + model_data.h (copiados de Hardware/IA)
+// #define KNN_USE_LUT           // Decisão pela tabela pré-calculada (model_lut.h) quando a entrada está na grade
+#ifdef KNN_USE_LUT
+#ifdef KNN_USE_QUANTIZED
+#error "model_lut.h reproduz a busca float (knn_lut_gen); com KNN_USE_QUANTIZED a grade e o resto decidiriam diferente"
+#endif
+#include "knn_lut.h"
+#endif
+// #define KNN_ONLINE_LEARNING   // Ajusta os protótipos (LVQ) com os comandos manuais do ThingsBoard
+#ifdef KNN_ONLINE_LEARNING
+#if defined(KNN_USE_LUT) || defined(KNN_USE_QUANTIZED)
+#error "KNN_ONLINE_LEARNING usa os protótipos float em RAM (incompatível com KNN_USE_LUT/KNN_USE_QUANTIZED)"
+#endif
+#include <Preferences.h>
+#include "knn_online.h"
+#endif
+// #define KNN_USE_BLOB          // Modelo lido da partição "model" (model.bin); model_data.h fica como reserva
+#ifdef KNN_USE_BLOB
+#if defined(KNN_USE_LUT) || defined(KNN_ONLINE_LEARNING)
+#error "KNN_USE_BLOB troca o modelo em tempo de execução (incompatível com KNN_USE_LUT/KNN_ONLINE_LEARNING)"
+#endif
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+#include "knn_model_blob.h"
+#endif
+#if !defined(ARDUINO) && (defined(KNN_ONLINE_LEARNING) || defined(KNN_USE_BLOB))
+#error "KNN_ONLINE_LEARNING e KNN_USE_BLOB dependem da NVS/partições do ESP32 (sem build de host)"
+#endif
+// #define INFERENCE_USE_TREE    // Decisão pela árvore de model_tree.h (knn_train --tree) no lugar do KNN
+#if defined(INFERENCE_USE_TREE) && (defined(KNN_USE_LUT) || defined(KNN_ONLINE_LEARNING) || defined(KNN_USE_BLOB))
+#error "INFERENCE_USE_TREE substitui o KNN (incompatível com KNN_USE_LUT/KNN_ONLINE_LEARNING/KNN_USE_BLOB)"
+#endif
+#include "inference_engine.h"  // InferenceEngine, KnnEngine, TreeEngine (+ model_tree.h)
+// #define CONTROLLER_COUNT_ALLOCS  // Depuração: conta as alocações do heap em cada loop() (alloc_counter.h)
+#ifdef CONTROLLER_COUNT_ALLOCS
+#include "alloc_counter.h"
+#endif
 
 // ======= CONFIGURAÇÃO WIFI / THINGSBOARD =======
 const char* ssid = "WIFI_NAME";
 const char* password = "WIFI_PASSWORD";
 const char* thingsboardServer = "demo.thingsboard.io";
 const char* accessToken = "TOKEN";
+const char* ntpServer = "pool.ntp.org";           // Hora UTC das amostras de telemetria
 
 // ======= DEFINIÇÕES DE PINOS  =======
 #define DHTTYPE DHT11                // Tipo do sensor DHT
 #define DHTPIN 4                    // GPIO 4 (Digital) - DHT11
-#define SOIL_MOISTURE_PIN 35        // GPIO 35 (ADC1_CH7) - FC-28 
+#define SOIL_MOISTURE_PIN 35        // GPIO 35 (ADC1_CH7) - FC-28
 #define RAIN_ANALOG_PIN 34          // GPIO 34 (ADC1_CH6) - FC-37
-#define LEVEL_SENSOR1_PIN 14        // GPIO 14 (Digital) - Nível baixo 
-#define LEVEL_SENSOR2_PIN 27        // GPIO 27 (Digital) - Nível alto 
+#define LEVEL_SENSOR1_PIN 14        // GPIO 14 (Digital) - Nível baixo
+#define LEVEL_SENSOR2_PIN 27        // GPIO 27 (Digital) - Nível alto
 #define PUMP_PIN 26                 // GPIO 26 (Output) - Bomba
 #define SOLENOIDE_PIN 25            // GPIO 25 (Output) - Válvula
 #define BMP_SDA 21                  // GPIO 21 (I2C SDA) - BMP280
 #define BMP_SCL 22                  // GPIO 22 (I2C SCL) - BMP280
 
-// ======= INICIALIZAÇÃO DOS SENSORES =======
-DHT dht(DHTPIN, DHTTYPE);
-Adafruit_BMP280 bmp;
-WiFiClient espClient;
-PubSubClient client(espClient);
-
-// ======= PARÂMETROS DO MODELO KNN =======
-#define N_FEATURES 3
-#define N_TRAIN_REDUCED 100
-#define N_NEIGHBORS 3
+// ======= HARDWARE =======
+#ifdef ARDUINO
+Esp32Hal esp32Hal(DHTPIN, DHTTYPE, BMP_SDA, BMP_SCL);
+Hal& hal = esp32Hal;
+#else
+extern Hal& hal;                    // Definido pelo programa de host
+#endif
 
 // ======= ESTADOS DO SISTEMA =======
 enum WaterSystemState {
@@ -66,33 +114,72 @@ enum IrrigationMode {
 // ======= VARIÁVEIS GLOBAIS =======
 WaterSystemState tankState = TANK_OK;
 IrrigationMode currentMode = MODE_AUTO;
-unsigned long lastTankCheck = 0;
-unsigned long lastTelemetry = 0;
-unsigned long tankFillStartTime = 0;
-unsigned long lastIrrigationCheck = 0;
-unsigned long lastIrrigationEnd = 0;
-unsigned long lastSensorRead = 0;
+HalMillis tankFillStartTime = 0;
+HalMillis lastIrrigationEnd = 0;
 bool irrigationBlocked = false;
 bool bmpAvailable = false;
 bool manualIrrigation = false;
 float minSoilHumidity = 30.0;
-unsigned long irrigationStartTime = 0;
+HalMillis irrigationStartTime = 0;
 bool irrigationActive = false;
-bool thingsboardConnected = false;
-unsigned long lastConnectionAttempt = 0;
-const unsigned long CONNECTION_RETRY_INTERVAL = 60000;
+std::atomic<bool> thingsboardConnected(false);       // Escrito pelo núcleo de rede, lido pelo de controle
+const HalMillis CONNECTION_RETRY_INTERVAL = 60000;
+
+// ======= NÚCLEOS E ESCALONADORES =======
+// Controle (sensores, bomba, tanque, IA) no loop() do Arduino; Wi-Fi, MQTT
+// e telemetria numa tarefa do FreeRTOS fixa no núcleo 0, junto da pilha do
+// Wi-Fi. Os dois lados só trocam dados pelas filas SPSC (sem mutex).
+#define NETWORK_CORE 0
+#define NETWORK_TASK_STACK 8192
+#define NETWORK_TASK_PRIORITY 2
+#define LOG_TASK_STACK 4096
+#define LOG_TASK_PRIORITY 1                           // Abaixo da rede: formata quando o núcleo 0 está livre
+#define LOG_DRAIN_INTERVAL 50                         // ms entre esvaziamentos do anel de log
+TaskScheduler scheduler;                              // Núcleo de controle
+TaskScheduler networkScheduler;                       // Núcleo de rede
+bool networkOnOwnCore = false;                        // false: o loop() também roda o lado de rede
+bool logOnOwnTask = false;                            // false: o loop() também formata o log
+int networkTaskId = -1;
+int controlTaskId = -1;
+int sensorTaskId = -1;
+
+#ifdef CONTROLLER_COUNT_ALLOCS
+unsigned long loopAllocations = 0;                    // Alocações do último loop()
+unsigned long loopAllocationsMax = 0;
+unsigned long allocatingLoops = 0;                    // loop()s com alguma alocação
+#endif
+
+#ifdef KNN_ONLINE_LEARNING
+KnnOnlineModel onlineModel;                           // Cópia em RAM dos protótipos (LVQ)
+Preferences modelPrefs;
+bool onlineModelDirty = false;
+const HalMillis MODEL_SAVE_INTERVAL = 3600000;    // 1 hora - Limita escritas na flash
+#endif
+
+#ifdef KNN_USE_BLOB
+#define MODEL_PARTITION_NAME "model"
+#define MODEL_PARTITION_SUBTYPE 0x40                  // Subtipo de dados definido em partitions.csv
+KnnBlobModel blobModel;                               // Aponta para a flash mapeada (sem cópia)
+bool blobModelLoaded = false;
+#endif
 
 // ======= CONSTANTES DE TEMPO  =======
-const unsigned long SENSOR_READ_INTERVAL = 2000;     // 2 segundos - Debug
-const unsigned long TELEMETRY_INTERVAL = 5000;       // 5 segundos - Telemetria
-const unsigned long TANK_CHECK_INTERVAL = 10000;     // 10 segundos - Tanque
-const unsigned long IRRIGATION_CHECK_INTERVAL = 60000; // 1 minuto - Verificação de irrigação
-const unsigned long MIN_INTERVAL_BETWEEN_IRRIGATIONS = 300000; // 5 minutos entre irrigações
-const unsigned long MAX_FILL_TIME = 120000;          // 2 minutos - Timeout tanque
-const unsigned long SENSOR_TIMEOUT = 5000;            // 5 segundos - Timeout sensores
-const unsigned long MAX_IRRIGATION_TIME = 60000;      // 1 minuto máximo
-const unsigned long MIN_IRRIGATION_TIME = 10000;      // 10 segundos mínimo
+const HalMillis SENSOR_READ_INTERVAL = 2000;     // 2 segundos - Debug
+const HalMillis TELEMETRY_INTERVAL = 5000;       // 5 segundos - Amostra de telemetria
+const HalMillis TELEMETRY_BATCH_MAX_AGE = 30000;  // 30 segundos - Amostra mais velha do lote
+const HalMillis TANK_CHECK_INTERVAL = 10000;     // 10 segundos - Tanque (bomba e válvula desligadas)
+const HalMillis CONTROL_INTERVAL = 100;          // 100 ms - Controle com bomba ou válvula ligada
+const HalMillis ADC_POLL_INTERVAL = 100;         // 100 ms - Quadro do ADC (mediana dos últimos 9)
+const HalMillis NETWORK_POLL_INTERVAL = 100;     // 100 ms - MQTT (online)
+const HalMillis SCHEDULER_REPORT_INTERVAL = 600000; // 10 minutos - Jitter das tarefas
+const HalMillis IRRIGATION_CHECK_INTERVAL = 60000; // 1 minuto - Verificação de irrigação
+const HalMillis MIN_INTERVAL_BETWEEN_IRRIGATIONS = 300000; // 5 minutos entre irrigações
+const HalMillis MAX_FILL_TIME = 120000;          // 2 minutos - Timeout tanque
+const HalMillis SENSOR_TIMEOUT = 5000;            // 5 segundos - Timeout sensores
+const HalMillis MAX_IRRIGATION_TIME = 60000;      // 1 minuto máximo
+const HalMillis MIN_IRRIGATION_TIME = 10000;      // 10 segundos mínimo
 const float HUMIDITY_TOLERANCE = 2.0;                 // Tolerância de 2% para parar irrigação
+const HalMillis DHT_MAX_SAMPLE_AGE = 10000;       // 10 segundos - Amostra do DHT11 mais velha = falha
 
 // ======= ESTRUTURA DOS DADOS DOS SENSORES =======
 struct SensorData {
@@ -106,136 +193,286 @@ struct SensorData {
     bool nivelAlto;
     bool bmpOk;
     bool irrigando;
-    String tankStatus;
-    String weatherCondition;
+    const char* tankStatus;
+    const char* weatherCondition;
+};
+
+// ======= FILAS ENTRE OS NÚCLEOS =======
+// Controle -> rede: estado completo para a telemetria e o getSystemStatus
+struct TelemetryFrame {
+    SensorData data;
+    bool irrigating;
+    bool pumpOn;
+    bool irrigationBlocked;
+    bool aiDecision;
+    float aiConfidence;
+    float minSoilHumidity;
+    const char* tankState;
+    const char* mode;
+    HalMillis irrigationElapsed;                  // ms; 0 se parada
+    HalMillis sampledAt;                          // millis() da aquisição
+    unsigned long long timestamp;                     // Hora UTC da aquisição (ms); 0 sem NTP
+#ifdef KNN_ONLINE_LEARNING
+    unsigned long modelUpdates;
+#endif
+};
+
+// Rede -> controle: comandos RPC já validados
+enum ControlCommandType {
+    CMD_MANUAL_IRRIGATION,   // value: 1 liga, 0 desliga
+    CMD_MIN_HUMIDITY,        // value: nova umidade mínima (%)
+    CMD_AUTO_MODE,
+    CMD_EMERGENCY_STOP
 };
 
+struct ControlCommand {
+    ControlCommandType type;
+    float value;
+};
+
+SpscRing<TelemetryFrame, 16> telemetryQueue;          // Cabe 1 minuto offline (reconexão)
+SpscRing<ControlCommand, 8> commandQueue;
+unsigned long telemetryDropped = 0;                   // Só o controle escreve
+unsigned long commandsRejected = 0;                   // Só a rede escreve
+TelemetryFrame lastTelemetryFrame = {};               // Só a rede lê e escreve (depois do setup)
+
+// ======= LOTE DE TELEMETRIA (núcleo de rede) =======
+// As amostras esperam com a hora da aquisição e saem numa publicação só,
+// ao completar o lote ou quando a mais velha chega a TELEMETRY_BATCH_MAX_AGE
+#define TELEMETRY_BATCH_SIZE 6                        // 30 s de amostras por publicação
+#define TELEMETRY_PAYLOAD_SIZE 3072                   // ~430 bytes por amostra
+static_assert(TELEMETRY_PAYLOAD_SIZE + 64 <= HAL_MQTT_BUFFER, "Lote de telemetria maior que o pacote MQTT");
+TelemetryFrame telemetryBatch[TELEMETRY_BATCH_SIZE];  // Circular: a mais velha em telemetryBatchFirst
+int telemetryBatchFirst = 0;
+int telemetryBatchCount = 0;
+unsigned long telemetryBatchDropped = 0;              // Mais velhas descartadas com o lote cheio (offline)
+
+// ======= BANDA MORTA DA TELEMETRIA (núcleo de rede) =======
+// Cada chave só vai quando se afasta do último valor enviado pela banda ou
+// depois de TELEMETRY_MAX_SILENCE calada; o ThingsBoard mantém o último valor
+const HalMillis TELEMETRY_MAX_SILENCE = 600000;   // 10 minutos - Toda chave reaparece
+
+enum TelemetryKey {
+    KEY_TEMPERATURE,
+    KEY_HUMIDITY,
+    KEY_SOIL_MOISTURE,
+    KEY_RAIN_INTENSITY,
+    KEY_IRRIGATING,
+    KEY_TANK_STATE,
+    KEY_IRRIGATION_BLOCKED,
+    KEY_CURRENT_MODE,
+    KEY_MIN_SOIL_HUMIDITY,
+    KEY_AI_DECISION,
+    KEY_OFFLINE_MODE,
+    KEY_AI_ENGINE,
+    KEY_AI_CONFIDENCE,
+    KEY_AI_MODEL_UPDATES,
+    KEY_AI_MODEL_CRC,
+    KEY_IRRIGATION_DURATION,
+    KEY_IRRIGATION_REMAINING,
+    KEY_PRESSURE,
+    KEY_ALTITUDE,
+    KEY_WEATHER,
+    TELEMETRY_KEY_COUNT
+};
+
+// Na ordem de TelemetryKey; banda 0 = qualquer mudança
+const DeadbandKey TELEMETRY_KEYS[TELEMETRY_KEY_COUNT] = {
+    {"temperature", 0.5f},              // °C (resolução do DHT11: 1 °C)
+    {"humidity", 1.0f},                 // %
+    {"soilMoisture", 1.0f},             // %
+    {"rainIntensity", 50.0f},           // Contagens do ADC (0-4095)
+    {"irrigating", 0},
+    {"tankState", 0},
+    {"irrigationBlocked", 0},
+    {"currentMode", 0},
+    {"minSoilHumidity", 0},
+    {"aiDecision", 0},
+    {"offlineMode", 0},
+    {"aiEngine", 0},
+    {"aiConfidence", 0.05f},
+    {"aiModelUpdates", 0},
+    {"aiModelCrc", 0},
+    {"irrigationDuration", 0},          // s; muda a cada amostra só durante a irrigação
+    {"irrigationTimeRemaining", 0},
+    {"pressure", 0.5f},                 // hPa
+    {"altitude", 5.0f},                 // m (derivada da pressão: 0,5 hPa ~ 4 m)
+    {"weather", 0}
+};
+TelemetryDeadband<TELEMETRY_KEY_COUNT> telemetryDeadband(TELEMETRY_KEYS, TELEMETRY_MAX_SILENCE);
+unsigned long telemetrySamplesSuppressed = 0;         // Amostras sem nenhuma chave fora da banda
+unsigned long telemetrySamplesMerged = 0;             // Amostras sem hora cobertas por uma mais nova do lote
+
+void controlSmartPump(bool shouldStart);
+#ifdef KNN_ONLINE_LEARNING
+void learnFromManualCommand(bool irrigate);
+#endif
+
 // ======= CALLBACK RPC DO THINGSBOARD =======
-void callback(char* topic, byte* payload, unsigned int length) {
-    Serial.println("🔔 Callback RPC ativado!");
-    Serial.println("Tópico: " + String(topic));
-    Serial.println("Tamanho payload: " + String(length));
+// Roda no núcleo de rede (dentro do mqttLoop()): só valida e enfileira
+bool queueCommand(ControlCommandType type, float value) {
+    ControlCommand command = {type, value};
+    if (!commandQueue.push(command)) {
+        commandsRejected++;
+        return false;
+    }
+    hal.wake();  // O controle aplica já, sem esperar o próximo prazo
+    return true;
+}
 
-    // Converter payload para string
-    String msg = String(payload, length);
-    Serial.println("📨 Comando RPC recebido: " + msg);
+#ifdef ARDUINO
+#define RPC_REQUEST_PREFIX "v1/devices/me/rpc/request/"
+#define RPC_DOC_SIZE 256              // Pool fixo do ArduinoJson (os comandos têm < 100 bytes)
+
+// Sem String nem DynamicJsonDocument: documento, tópico e resposta em
+// buffers fixos
+void callback(char* topic, byte* payload, unsigned int length) {
+    hal.printf("🔔 Callback RPC ativado!\n");
+    hal.printf("Tópico: %s\n", topic);
+    hal.printf("📨 Comando RPC recebido: %.*s\n", (int)length, (const char*)payload);
 
     // Verificar se é realmente um comando RPC
-    if (!String(topic).startsWith("v1/devices/me/rpc/request/")) {
-        Serial.println("❌ Tópico não é RPC válido");
+    const size_t prefixLength = sizeof(RPC_REQUEST_PREFIX) - 1;
+    if (strncmp(topic, RPC_REQUEST_PREFIX, prefixLength) != 0) {
+        hal.printf("❌ Tópico não é RPC válido\n");
         return;
     }
 
     // Extrair ID da requisição
-    String topicStr = String(topic);
-    String requestId = topicStr.substring(topicStr.lastIndexOf("/") + 1);
-    String responseTopic = "v1/devices/me/rpc/response/" + requestId;
-
-    Serial.println("🆔 Request ID: " + requestId);
-    Serial.println("📤 Response Topic: " + responseTopic);
-
-    // Parse JSON com verificação de erro
-    DynamicJsonDocument doc(1024);
-    DeserializationError error = deserializeJson(doc, msg);
+    const char* requestId = topic + prefixLength;
+    char responseTopic[64];
+    snprintf(responseTopic, sizeof(responseTopic), "v1/devices/me/rpc/response/%s", requestId);
+    hal.printf("🆔 Request ID: %s\n", requestId);
+
+    char response[160];
+    JsonWriter json(response, sizeof(response));
+    json.beginObject();
+
+    // Parse JSON com verificação de erro (payload const: o ArduinoJson copia para o pool)
+    StaticJsonDocument<RPC_DOC_SIZE> doc;
+    DeserializationError error = deserializeJson(doc, (const byte*)payload, length);
     if (error) {
-        Serial.println("❌ Erro ao fazer parse do JSON: " + String(error.c_str()));
-        String errorResponse = "{\"error\":\"Invalid JSON format\"}";
-        client.publish(responseTopic.c_str(), errorResponse.c_str());
+        hal.printf("❌ Erro ao fazer parse do JSON: %s\n", error.c_str());
+        json.field("error", "Invalid JSON format");
+        json.endObject();
+        hal.mqttPublish(responseTopic, response);
         return;
     }
 
     // Verificar se contém o campo method
-    if (!doc.containsKey("method")) {
-        Serial.println("❌ Comando sem campo 'method'");
-        String errorResponse = "{\"error\":\"Missing method field\"}";
-        client.publish(responseTopic.c_str(), errorResponse.c_str());
+    const char* method = doc["method"];
+    if (method == NULL) {
+        hal.printf("❌ Comando sem campo 'method'\n");
+        json.field("error", "Missing method field");
+        json.endObject();
+        hal.mqttPublish(responseTopic, response);
         return;
     }
-
-    String method = doc["method"];
-    String response = "{}";
-
-    Serial.println("🎯 Método chamado: " + method);
-
-    // Comandos disponíveis
-    if (method == "getSystemStatus") {
-        response = "{\"tankState\":\"" + getTankStateText() + "\",";
-        response += "\"irrigating\":" + String(isPumpOn() ? "true" : "false") + ",";
-        response += "\"mode\":\"" + getModeText() + "\",";
-        response += "\"minHumidity\":" + String(minSoilHumidity) + "}";
-    } else if (method == "setManualIrrigation") {
-        if (!doc.containsKey("params") || !doc["params"].containsKey("enable")) {
-            response = "{\"success\":false,\"error\":\"Missing enable parameter\"}";
+    hal.printf("🎯 Método chamado: %s\n", method);
+
+    // Comandos disponíveis: o estado vem do último quadro do controle e os
+    // comandos entram na fila; o núcleo de controle aplica no próximo ciclo
+    const TelemetryFrame& status = lastTelemetryFrame;
+    JsonVariantConst params = doc["params"];
+    bool queued = true;
+    if (strcmp(method, "getSystemStatus") == 0) {
+        json.field("tankState", status.tankState);
+        json.field("irrigating", status.pumpOn);
+        json.field("mode", status.mode);
+        json.field("minHumidity", status.minSoilHumidity);
+    } else if (strcmp(method, "setManualIrrigation") == 0) {
+        if (!params.containsKey("enable")) {
+            json.field("success", false);
+            json.field("error", "Missing enable parameter");
         } else {
-            bool enable = doc["params"]["enable"];
-            manualIrrigation = enable;
-            currentMode = enable ? MODE_MANUAL : MODE_AUTO;
-            controlSmartPump(enable);
-            response = "{\"success\":true,\"manualMode\":" + String(enable ? "true" : "false") + "}";
+            bool enable = params["enable"];
+            queued = queueCommand(CMD_MANUAL_IRRIGATION, enable ? 1.0f : 0.0f);
+            if (queued) {
+                json.field("success", true);
+                json.field("manualMode", enable);
+            }
         }
-    } else if (method == "setMinHumidity") {
-        if (!doc.containsKey("params") || !doc["params"].containsKey("humidity")) {
-            response = "{\"success\":false,\"error\":\"Missing humidity parameter\"}";
+    } else if (strcmp(method, "setMinHumidity") == 0) {
+        if (!params.containsKey("humidity")) {
+            json.field("success", false);
+            json.field("error", "Missing humidity parameter");
         } else {
-            float newMinHumidity = doc["params"]["humidity"];
-            if (newMinHumidity >= 0 && newMinHumidity <= 100) {
-                minSoilHumidity = newMinHumidity;
-                response = "{\"success\":true,\"minHumidity\":" + String(minSoilHumidity) + "}";
+            float newMinHumidity = params["humidity"];
+            if (newMinHumidity < 0 || newMinHumidity > 100) {
+                json.field("success", false);
+                json.field("error", "Invalid humidity range");
             } else {
-                response = "{\"success\":false,\"error\":\"Invalid humidity range\"}";
+                queued = queueCommand(CMD_MIN_HUMIDITY, newMinHumidity);
+                if (queued) {
+                    json.field("success", true);
+                    json.field("minHumidity", newMinHumidity);
+                }
             }
         }
-    } else if (method == "setAutoMode") {
-        currentMode = MODE_AUTO;
-        manualIrrigation = false;
-        response = "{\"success\":true,\"mode\":\"auto\"}";
-    } else if (method == "emergencyStop") {
-        controlSmartPump(false);
-        manualIrrigation = false;
-        response = "{\"success\":true,\"stopped\":true}";
+    } else if (strcmp(method, "setAutoMode") == 0) {
+        queued = queueCommand(CMD_AUTO_MODE, 0);
+        if (queued) {
+            json.field("success", true);
+            json.field("mode", "auto");
+        }
+    } else if (strcmp(method, "emergencyStop") == 0) {
+        queued = queueCommand(CMD_EMERGENCY_STOP, 0);
+        if (queued) {
+            json.field("success", true);
+            json.field("stopped", true);
+        }
     } else {
-        response = "{\"success\":false,\"error\":\"Unknown method\"}";
+        json.field("success", false);
+        json.field("error", "Unknown method");
     }
+    if (!queued) {
+        json.field("success", false);
+        json.field("error", "Command queue full");
+    }
+    json.endObject();
 
     // Enviar resposta
-    if (client.publish(responseTopic.c_str(), response.c_str())) {
-        Serial.println("✅ Resposta RPC enviada com sucesso");
+    if (hal.mqttPublish(responseTopic, response)) {
+        hal.printf("✅ Resposta RPC enviada com sucesso\n");
     } else {
-        Serial.println("❌ Falha ao enviar resposta RPC");
+        hal.printf("❌ Falha ao enviar resposta RPC\n");
     }
 }
+#else
+#define callback NULL                // Sem RPC no host
+#endif
 
 // ===== FUNÇÕES DE CONTROLE DOS RELÉS LOW LEVEL =====
 void turnOnPump() {
-    digitalWrite(PUMP_PIN, LOW);  // LOW para ativar relé
-    Serial.println("💧 BOMBA LIGADA (LOW level)");
+    hal.digitalWrite(PUMP_PIN, HAL_LOW);  // LOW para ativar relé
+    LOG_INFO("💧 BOMBA LIGADA (LOW level)\n");
 }
 
 void turnOffPump() {
-    digitalWrite(PUMP_PIN, HIGH); // HIGH para desativar relé
-    Serial.println("💧 BOMBA DESLIGADA (HIGH level)");
+    hal.digitalWrite(PUMP_PIN, HAL_HIGH); // HIGH para desativar relé
+    LOG_INFO("💧 BOMBA DESLIGADA (HIGH level)\n");
 }
 
 bool isPumpOn() {
-    return digitalRead(PUMP_PIN) == LOW; // LOW significa bomba ligada
+    return hal.digitalRead(PUMP_PIN) == HAL_LOW; // LOW significa bomba ligada
 }
 
 void turnOnSolenoid() {
-    digitalWrite(SOLENOIDE_PIN, LOW);  // LOW para ativar relé
-    Serial.println("🚰 VÁLVULA LIGADA (LOW level)");
+    hal.digitalWrite(SOLENOIDE_PIN, HAL_LOW);  // LOW para ativar relé
+    LOG_INFO("🚰 VÁLVULA LIGADA (LOW level)\n");
 }
 
-void turnOffSolenoide(){
-    digitalWrite(SOLENOIDE_PIN, HIGH); // HIGH para desativar relé
-    Serial.println("🚰 VÁLVULA DESLIGADA (HIGH level)");
+void turnOffSolenoid() {
+    hal.digitalWrite(SOLENOIDE_PIN, HAL_HIGH); // HIGH para desativar relé
+    LOG_INFO("🚰 VÁLVULA DESLIGADA (HIGH level)\n");
 }
 
 bool isSolenoidOn() {
-    return digitalRead(SOLENOIDE_PIN) == LOW; // LOW significa válvula ligada
+    return hal.digitalRead(SOLENOIDE_PIN) == HAL_LOW; // LOW significa válvula ligada
 }
 
 // ======= FUNÇÕES AUXILIARES =======
-String getTankStateText() {
+const char* getTankStateText() {
     switch (tankState) {
         case TANK_OK: return "OK";
         case TANK_LOW: return "BAIXO";
@@ -246,7 +483,7 @@ String getTankStateText() {
     }
 }
 
-String getModeText() {
+const char* getModeText() {
     switch (currentMode) {
         case MODE_AUTO: return "AUTO";
         case MODE_MANUAL: return "MANUAL";
@@ -254,301 +491,262 @@ String getModeText() {
     }
 }
 
-bool isTimeElapsed(unsigned long &lastTime, unsigned long interval) {
-    unsigned long currentTime = millis();
-    
-    // Proteção contra overflow do millis()
-    if (currentTime < lastTime) {
-        lastTime = currentTime;
-        return false;
-    }
-    
-    if (currentTime - lastTime >= interval) {
-        lastTime = currentTime;
-        return true;
-    }
-    
-    return false;
-}
-
 // ======= CONEXÕES =======
 void connectWiFi() {
-    WiFi.begin(ssid, password);
-    Serial.print("Conectando ao Wi-Fi");
-    unsigned long startAttemptTime = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - startAttemptTime < 30000) { // Timeout de 30 segundos
-        delay(1000);
-        Serial.print(".");
-    }
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\nWi-Fi conectado!");
-        Serial.println("IP: " + WiFi.localIP().toString());
+    hal.wifiBegin(ssid, password);
+    hal.printf("Conectando ao Wi-Fi");
+    HalMillis startAttemptTime = hal.millis();
+    while (!hal.wifiConnected() && hal.millis() - startAttemptTime < 30000) { // Timeout de 30 segundos
+        hal.delay(1000);
+        hal.printf(".");
+    }
+    if (hal.wifiConnected()) {
+        hal.printf("\nWi-Fi conectado!\n");
+        hal.printf("IP: %s\n", hal.wifiAddress());
     } else {
-        Serial.println("\nFalha ao conectar ao Wi-Fi.");
-        Serial.println("⚠️ MODO OFFLINE ATIVADO - Sistema funcionará autonomamente");
+        hal.printf("\nFalha ao conectar ao Wi-Fi.\n");
+        hal.printf("⚠️ MODO OFFLINE ATIVADO - Sistema funcionará autonomamente\n");
     }
 }
 
 void connectThingsBoard() {
     // Só tenta conectar se Wi-Fi estiver disponível
-    if (WiFi.status() != WL_CONNECTED) {
+    if (!hal.wifiConnected()) {
         thingsboardConnected = false;
         return;
     }
 
     unsigned int retryCount = 0;
-    while (!client.connected() && retryCount < 3) { // Máximo de 3 tentativas (reduzido)
-        Serial.print("Conectando ao ThingsBoard...");
-        if (client.connect("ESP32_IrrigationSystem", accessToken, NULL)) {
-            Serial.println("Conectado!");
-            client.subscribe("v1/devices/me/rpc/request/+");
-            Serial.println("Subscrito aos comandos RPC");
+    while (!hal.mqttConnected() && retryCount < 3) { // Máximo de 3 tentativas (reduzido)
+        hal.printf("Conectando ao ThingsBoard...");
+        if (hal.mqttConnect("ESP32_IrrigationSystem", accessToken)) {
+            hal.printf("Conectado!\n");
+            hal.mqttSubscribe("v1/devices/me/rpc/request/+");
+            hal.printf("Subscrito aos comandos RPC\n");
             thingsboardConnected = true;
             return;
         } else {
-            Serial.print(" Falhou, código: ");
-            Serial.println(client.state());
+            hal.printf(" Falhou, código: %d\n", hal.mqttState());
             retryCount++;
-            delay(2000); // Delay reduzido
+            hal.delay(2000); // Delay reduzido
         }
     }
-    
-    if (!client.connected()) {
+
+    if (!hal.mqttConnected()) {
         thingsboardConnected = false;
-        Serial.println("Falha ao conectar ao ThingsBoard.");
-        Serial.println("⚠️ MODO OFFLINE ATIVADO - Sistema funcionará autonomamente");
+        hal.printf("Falha ao conectar ao ThingsBoard.\n");
+        hal.printf("⚠️ MODO OFFLINE ATIVADO - Sistema funcionará autonomamente\n");
     }
 }
 
 // ======= FUNÇÃO PARA TENTAR RECONECTAR PERIODICAMENTE =======
+// Chamada pela tarefa de rede a cada CONNECTION_RETRY_INTERVAL
 void tryReconnect() {
-    unsigned long currentTime = millis();
-    
-    // Só tenta reconectar a cada minuto
-    if (currentTime - lastConnectionAttempt >= CONNECTION_RETRY_INTERVAL) {
-        lastConnectionAttempt = currentTime;
-        
-        Serial.println("🔄 Tentando reconectar...");
-        
-        // Tentar reconectar Wi-Fi se desconectado
-        if (WiFi.status() != WL_CONNECTED) {
-            connectWiFi();
-        }
-        
-        // Tentar reconectar ThingsBoard se Wi-Fi estiver OK
-        if (WiFi.status() == WL_CONNECTED && !client.connected()) {
-            connectThingsBoard();
-        }
-        
-        // Atualizar status de conexão
-        thingsboardConnected = (WiFi.status() == WL_CONNECTED && client.connected());
-        
-        if (thingsboardConnected) {
-            Serial.println("✅ Reconectado com sucesso!");
-        } else {
-            Serial.println("❌ Ainda sem conexão - Continuando em modo offline");
-        }
-    }
-}
+    hal.printf("🔄 Tentando reconectar...\n");
 
-// ======= FUNÇÕES DO MODELO KNN =======
-void standardize(float *input, int n_features) {
-    for (int i = 0; i < n_features; i++) {
-        input[i] = (input[i] - scaler_mean[i]) / scaler_scale[i];
+    // Tentar reconectar Wi-Fi se desconectado
+    if (!hal.wifiConnected()) {
+        connectWiFi();
     }
-}
 
-float euclidean_distance(const float *a, const float *b, int n_features) {
-    float distance = 0.0;
-    for (int i = 0; i < n_features; i++) {
-        float diff = a[i] - b[i];
-        distance += diff * diff;
+    // Tentar reconectar ThingsBoard se Wi-Fi estiver OK
+    if (hal.wifiConnected() && !hal.mqttConnected()) {
+        connectThingsBoard();
     }
-    return sqrt(distance);
-}
 
-int knn_predict(const float *input) {
-    float min_distances[N_NEIGHBORS];
-    int indices[N_NEIGHBORS];
+    // Atualizar status de conexão
+    thingsboardConnected = (hal.wifiConnected() && hal.mqttConnected());
 
-    for (int i = 0; i < N_NEIGHBORS; i++) {
-        min_distances[i] = INFINITY;
-        indices[i] = -1;
+    if (thingsboardConnected) {
+        hal.printf("✅ Reconectado com sucesso!\n");
+    } else {
+        hal.printf("❌ Ainda sem conexão - Continuando em modo offline\n");
     }
+}
+
+// ======= LEITURA DOS SENSORES (SNAPSHOT COM TTL) =======
+// Todos os consumidores leem o mesmo snapshot; o hardware só é acessado
+// quando a leitura de um sensor passou do seu TTL.
+enum SensorId {
+    SENSOR_DHT,
+    SENSOR_SOIL,
+    SENSOR_RAIN,
+    SENSOR_BMP,
+    SENSOR_LEVELS,
+    SENSOR_COUNT
+};
 
-    for (int i = 0; i < N_TRAIN_REDUCED; i++) {
-        float distance = euclidean_distance(input, &X_train_reduced[i * N_FEATURES], N_FEATURES);
+const HalMillis SENSOR_TTL[SENSOR_COUNT] = {
+    2000,   // DHT11 - Amostra nova a cada 2 segundos (dht_async.h)
+    50,     // FC-28 - Uma leitura por loop() (decide a irrigação)
+    1000,   // FC-37 - Só telemetria
+    5000,   // BMP280 - Só telemetria
+    50      // Sensores de nível - Uma leitura por loop() (tanque)
+};
 
-        for (int j = 0; j < N_NEIGHBORS; j++) {
-            if (distance < min_distances[j]) {
-                for (int k = N_NEIGHBORS - 1; k > j; k--) {
-                    min_distances[k] = min_distances[k - 1];
-                    indices[k] = indices[k - 1];
-                }
-                min_distances[j] = distance;
-                indices[j] = i;
-                break;
-            }
-        }
-    }
+struct SensorSnapshot {
+    SensorData data;
+    unsigned long version;                  // Incrementa a cada leitura de hardware
+    HalMillis readAt[SENSOR_COUNT];
+    bool loaded[SENSOR_COUNT];
+};
 
-    int votes[2] = {0, 0};
-    for (int i = 0; i < N_NEIGHBORS; i++) {
-        if (indices[i] >= 0) {
-            votes[y_train_reduced[indices[i]]]++;
-        }
-    }
+SensorSnapshot sensorSnapshot = {};
 
-    return (votes[1] > votes[0]) ? 1 : 0;
+bool isSensorStale(SensorId id, HalMillis now) {
+    return !sensorSnapshot.loaded[id] || now - sensorSnapshot.readAt[id] >= SENSOR_TTL[id];
 }
 
-// ======= LEITURA DOS SENSORES =======
-SensorData readAllSensors() {
-    SensorData data;
-
-    // DHT11
-    data.temperatura = dht.readTemperature();
-    data.umidadeAr = dht.readHumidity();
+void markSensorRead(SensorId id, HalMillis now) {
+    sensorSnapshot.readAt[id] = now;
+    sensorSnapshot.loaded[id] = true;
+    sensorSnapshot.version++;
+}
 
-    // Validar leituras do DHT11
-    if (isnan(data.temperatura) || isnan(data.umidadeAr)) {
-        Serial.println("Erro: Leitura inválida do DHT11. Usando valores padrão.");
-        data.temperatura = -999;  // Valor padrão
-        data.umidadeAr = -999;    // Valor padrão
+const SensorSnapshot& refreshSensors() {
+    SensorData& data = sensorSnapshot.data;
+    HalMillis now = hal.millis();
+
+    // DHT11 (última amostra válida; a leitura corre em segundo plano)
+    if (isSensorStale(SENSOR_DHT, now)) {
+        // Validar leituras do DHT11
+        HalMillis dhtAge;
+        if (!hal.dhtRead(&data.temperatura, &data.umidadeAr, &dhtAge) || dhtAge > DHT_MAX_SAMPLE_AGE) {
+            LOG_WARN("Erro: Leitura inválida do DHT11. Usando valores padrão.\n");
+            data.temperatura = -999;  // Valor padrão
+            data.umidadeAr = -999;    // Valor padrão
+        }
+        markSensorRead(SENSOR_DHT, now);
     }
 
-    // FC-28 (Umidade do Solo)
-    int soilReading = analogRead(SOIL_MOISTURE_PIN);
-    data.umidadeSolo = map(soilReading, 0, 4095, 100, 0);
+    // FC-28 (Umidade do Solo): map(leitura, 0, 4095, 100, 0)
+    if (isSensorStale(SENSOR_SOIL, now)) {
+        int soilReading = hal.analogRead(SOIL_MOISTURE_PIN);
+        data.umidadeSolo = 100 - (long)soilReading * 100 / 4095;
 
-    // Validar leituras do FC-28
-    if (data.umidadeSolo < 0 || data.umidadeSolo > 100) {
-        Serial.println("Erro: Leitura inválida do sensor de umidade do solo. Usando valor padrão.");
-        data.umidadeSolo = 50.0;  // Valor padrão
+        // Validar leituras do FC-28
+        if (data.umidadeSolo < 0 || data.umidadeSolo > 100) {
+            LOG_WARN("Erro: Leitura inválida do sensor de umidade do solo. Usando valor padrão.\n");
+            data.umidadeSolo = 50.0;  // Valor padrão
+        }
+        markSensorRead(SENSOR_SOIL, now);
     }
 
     // FC-37 (Sensor de Chuva)
-    data.chuvaAnalogica = analogRead(RAIN_ANALOG_PIN);
+    if (isSensorStale(SENSOR_RAIN, now)) {
+        data.chuvaAnalogica = hal.analogRead(RAIN_ANALOG_PIN);
+        markSensorRead(SENSOR_RAIN, now);
+    }
 
     // BMP280
-    data.bmpOk = false;
-    if (bmpAvailable) {
-        data.pressao = bmp.readPressure() / 100.0F;
-        data.altitude = bmp.readAltitude(1013.25);
-        data.bmpOk = true;
-
-        // Validar leituras do BMP280
-        if (data.pressao < 300 || data.pressao > 1100) {
-            Serial.println("Erro: Leitura inválida do BMP280. Ignorando dados.");
-            data.pressao = -999;  // Valor de erro
-            data.altitude = -999; // Valor de erro
-            data.bmpOk = false;
+    if (isSensorStale(SENSOR_BMP, now)) {
+        data.bmpOk = false;
+        if (bmpAvailable) {
+            hal.bmpRead(&data.pressao, &data.altitude);
+            data.bmpOk = true;
+
+            // Validar leituras do BMP280
+            if (data.pressao < 300 || data.pressao > 1100) {
+                LOG_WARN("Erro: Leitura inválida do BMP280. Ignorando dados.\n");
+                data.pressao = -999;  // Valor de erro
+                data.altitude = -999; // Valor de erro
+                data.bmpOk = false;
+            }
         }
+        markSensorRead(SENSOR_BMP, now);
     }
 
     // Sensores de nível
-    data.nivelBaixo = digitalRead(LEVEL_SENSOR1_PIN);
-    data.nivelAlto = digitalRead(LEVEL_SENSOR2_PIN);
+    if (isSensorStale(SENSOR_LEVELS, now)) {
+        data.nivelBaixo = hal.digitalRead(LEVEL_SENSOR1_PIN);
+        data.nivelAlto = hal.digitalRead(LEVEL_SENSOR2_PIN);
+        markSensorRead(SENSOR_LEVELS, now);
+    }
 
-    // Status da irrigação
+    // Status da irrigação (estado dos atuadores, sempre atual)
     data.irrigando = isPumpOn();
     data.tankStatus = getTankStateText();
+    data.weatherCondition = "";
 
-    return data;
+    return sensorSnapshot;
+}
+
+SensorData readAllSensors() {
+    return refreshSensors().data;
 }
 
 void printSensorData(SensorData data) {
   // Indicar status de conexão
-  String connectionStatus = thingsboardConnected ? "🌐 ONLINE" : "📡 OFFLINE";
-  
-  Serial.println("\n==================== DADOS DOS SENSORES ====================");
-  Serial.println("Status: " + connectionStatus + " | Modo: " + getModeText());
-  
+  const char* connectionStatus = thingsboardConnected ? "🌐 ONLINE" : "📡 OFFLINE";
+
+  LOG_INFO("\n==================== DADOS DOS SENSORES ====================\n");
+  LOG_INFO("Status: %s | Modo: %s\n", connectionStatus, getModeText());
+
   // DHT11 - Temperatura e Umidade do Ar
-  Serial.print("Temperatura (DHT11): ");
   if (data.temperatura == -999) {
-    Serial.println("ERRO");
+    LOG_INFO("Temperatura (DHT11): ERRO\n");
   } else {
-    Serial.print(data.temperatura);
-    Serial.println(" °C");
+    LOG_INFO("Temperatura (DHT11): %.2f °C\n", data.temperatura);
   }
 
-  Serial.print("Umidade do Ar (DHT11): ");
   if (data.umidadeAr == -999) {
-    Serial.println("ERRO");
+    LOG_INFO("Umidade do Ar (DHT11): ERRO\n");
   } else {
-    Serial.print(data.umidadeAr);
-    Serial.println(" %");
+    LOG_INFO("Umidade do Ar (DHT11): %.2f %%\n", data.umidadeAr);
   }
 
   // FC-28 - Umidade do Solo
-  Serial.print("Umidade do Solo (FC-28): ");
   if (data.umidadeSolo < 0 || data.umidadeSolo > 100) {
-    Serial.println("ERRO");
+    LOG_INFO("Umidade do Solo (FC-28): ERRO\n");
   } else {
-    Serial.print(data.umidadeSolo);
-    Serial.print(" % (Mín: ");
-    Serial.print(minSoilHumidity);
-    Serial.println("%)");
+    LOG_INFO("Umidade do Solo (FC-28): %.2f %% (Mín: %.2f%%)\n", data.umidadeSolo, minSoilHumidity);
   }
 
   // FC-37 - Chuva (Analog)
-  Serial.print("Chuva (FC-37 - Valor Analógico): ");
-  Serial.println(data.chuvaAnalogica);
+  LOG_INFO("Chuva (FC-37 - Valor Analógico): %d\n", data.chuvaAnalogica);
 
   // BMP280 - Pressão e Altitude
   if (data.bmpOk) {
-    Serial.print("Pressão Atmosférica (BMP280): ");
-    Serial.print(data.pressao);
-    Serial.println(" hPa");
-
-    Serial.print("Altitude Estimada (BMP280): ");
-    Serial.print(data.altitude);
-    Serial.println(" m");
+    LOG_INFO("Pressão Atmosférica (BMP280): %.2f hPa\n", data.pressao);
+    LOG_INFO("Altitude Estimada (BMP280): %.2f m\n", data.altitude);
   } else {
-    Serial.println("BMP280: Leitura inválida ou não disponível.");
+    LOG_INFO("BMP280: Leitura inválida ou não disponível.\n");
   }
 
   // Sensores de Nível
-  Serial.print("Nível Baixo Detectado: ");
-  Serial.println(data.nivelBaixo ? "Sim" : "Não");
-
-  Serial.print("Nível Alto Detectado: ");
-  Serial.println(data.nivelAlto ? "Sim" : "Não");
+  LOG_INFO("Nível Baixo Detectado: %s\n", data.nivelBaixo ? "Sim" : "Não");
+  LOG_INFO("Nível Alto Detectado: %s\n", data.nivelAlto ? "Sim" : "Não");
 
   // Status da Irrigação
-  Serial.print("Bomba Ligada: ");
-  Serial.println(data.irrigando ? "Sim" : "Não");
-  
+  LOG_INFO("Bomba Ligada: %s\n", data.irrigando ? "Sim" : "Não");
+
   if (irrigationActive) {
-    unsigned long duration = (millis() - irrigationStartTime) / 1000;
-    Serial.print("Tempo de Irrigação: ");
-    Serial.print(duration);
-    Serial.println(" segundos");
+    unsigned long duration = (hal.millis() - irrigationStartTime) / 1000;
+    LOG_INFO("Tempo de Irrigação: %lu segundos\n", duration);
   }
 
-  Serial.print("Estado do Tanque: ");
-  Serial.println(data.tankStatus);
+  LOG_INFO("Estado do Tanque: %s\n", data.tankStatus);
 
-  Serial.println("============================================================\n");
+  LOG_INFO("============================================================\n\n");
 }
 
 // ======= SISTEMA DE GERENCIAMENTO DO TANQUE AUTOMÁTICO =======
 WaterSystemState readTankLevel() {
-    bool level1 = digitalRead(LEVEL_SENSOR1_PIN);  // Nível baixo
-    bool level2 = digitalRead(LEVEL_SENSOR2_PIN);  // Nível alto
-    
+    const SensorData& data = refreshSensors().data;
+    bool level1 = data.nivelBaixo;  // Nível baixo
+    bool level2 = data.nivelAlto;   // Nível alto
+
     if (!level1 && !level2) {
-        Serial.println("DEBUG: TANQUE VAZIO detectado");
+        LOG_DEBUG("DEBUG: TANQUE VAZIO detectado\n");
         return TANK_EMPTY;
     } else if (level1 && !level2) {
-        Serial.println("DEBUG: TANQUE BAIXO detectado");
+        LOG_DEBUG("DEBUG: TANQUE BAIXO detectado\n");
         return TANK_LOW;
     } else if (level1 && level2) {
-        Serial.println("DEBUG: TANQUE CHEIO detectado");
+        LOG_DEBUG("DEBUG: TANQUE CHEIO detectado\n");
         return TANK_FULL;
     } else {
-        Serial.println("DEBUG: Estado inválido - assumindo VAZIO");
+        LOG_DEBUG("DEBUG: Estado inválido - assumindo VAZIO\n");
         return TANK_EMPTY;
     }
 }
@@ -559,12 +757,13 @@ void controlWaterSupply(bool turnOn) {
     } else {
         turnOffSolenoid();
     }
-    
+
     if (turnOn) {
-        Serial.println("ABASTECIMENTO LIGADA");
-        tankFillStartTime = millis();
+        LOG_INFO("ABASTECIMENTO LIGADA\n");
+        tankFillStartTime = hal.millis();
+        scheduler.trigger(controlTaskId, tankFillStartTime);  // Acompanhar o enchimento a cada 100 ms
     } else {
-        Serial.println("ABASTECIMENTO DESLIGADA");
+        LOG_INFO("ABASTECIMENTO DESLIGADA\n");
     }
 }
 
@@ -574,7 +773,7 @@ void manageTankSystem() {
     // FORÇAR PARADA DE IRRIGAÇÃO SE TANQUE VAZIO
     if (currentLevel == TANK_EMPTY) {
         if (irrigationActive) {
-            Serial.println("🚨 EMERGÊNCIA: Parando irrigação - TANQUE VAZIO!");
+            LOG_ERROR("🚨 EMERGÊNCIA: Parando irrigação - TANQUE VAZIO!\n");
             turnOffPump();
             irrigationActive = false;
         }
@@ -583,17 +782,17 @@ void manageTankSystem() {
         controlWaterSupply(true); // Tentar reabastecer
         return;
     }
-    
+
     switch (tankState) {
         case TANK_OK:
         case TANK_FULL:
             if (currentLevel == TANK_LOW) {
-                Serial.println("NÍVEL BAIXO - Iniciando abastecimento automático");
+                LOG_INFO("NÍVEL BAIXO - Iniciando abastecimento automático\n");
                 tankState = TANK_FILLING;
                 controlWaterSupply(true);
                 irrigationBlocked = false;
             } else if (currentLevel == TANK_EMPTY) {
-                Serial.println("TANQUE VAZIO - Bloqueando irrigação");
+                LOG_WARN("TANQUE VAZIO - Bloqueando irrigação\n");
                 tankState = TANK_EMPTY;
                 controlWaterSupply(true);
                 irrigationBlocked = true;
@@ -607,10 +806,10 @@ void manageTankSystem() {
                 irrigationBlocked = false;
             }
             break;
-            
+
         case TANK_LOW:
             if (currentLevel == TANK_FULL) {
-                Serial.println("TANQUE CHEIO - Parando abastecimento automático");
+                LOG_INFO("TANQUE CHEIO - Parando abastecimento automático\n");
                 tankState = TANK_FULL;
                 controlWaterSupply(false);
                 irrigationBlocked = false;
@@ -624,7 +823,7 @@ void manageTankSystem() {
                 }
             }
             break;
-            
+
         case TANK_EMPTY:
             if (currentLevel == TANK_LOW || currentLevel == TANK_FULL) {
                 tankState = (currentLevel == TANK_FULL) ? TANK_FULL : TANK_LOW;
@@ -634,15 +833,15 @@ void manageTankSystem() {
                 irrigationBlocked = false;
             }
             break;
-            
+
         case TANK_FILLING:
             if (currentLevel == TANK_FULL) {
-                Serial.println("ABASTECIMENTO AUTOMÁTICO CONCLUÍDO - Sensor 2 atingido");
+                LOG_INFO("ABASTECIMENTO AUTOMÁTICO CONCLUÍDO - Sensor 2 atingido\n");
                 tankState = TANK_FULL;
                 controlWaterSupply(false);  // DESLIGA AUTOMATICAMENTE
                 irrigationBlocked = false;
-            } else if (millis() - tankFillStartTime > MAX_FILL_TIME) {
-                Serial.println("TIMEOUT - Sistema de abastecimento");
+            } else if (hal.millis() - tankFillStartTime > MAX_FILL_TIME) {
+                LOG_WARN("TIMEOUT - Sistema de abastecimento\n");
                 controlWaterSupply(false);
                 tankState = TANK_LOW;
             }
@@ -652,394 +851,842 @@ void manageTankSystem() {
 
 // ======= CONTROLE INTELIGENTE DE IRRIGAÇÃO =======
 void controlSmartPump(bool shouldStart) {
-    unsigned long currentTime = millis();
-    
+    HalMillis currentTime = hal.millis();
+
     // Verificar se irrigação está bloqueada por falta de água
     if (shouldStart && irrigationBlocked) {
-        Serial.println("IRRIGAÇÃO BLOQUEADA - Tanque vazio");
+        LOG_WARN("IRRIGAÇÃO BLOQUEADA - Tanque vazio\n");
         turnOffPump();
         irrigationActive = false;
         return;
     }
-    
+
     // NOVA VERIFICAÇÃO - Verificar intervalo mínimo entre irrigações (apenas para novas irrigações)
     if (shouldStart && !irrigationActive && lastIrrigationEnd > 0) {
-        unsigned long timeSinceLastIrrigation = currentTime - lastIrrigationEnd;
+        HalMillis timeSinceLastIrrigation = currentTime - lastIrrigationEnd;
         if (timeSinceLastIrrigation < MIN_INTERVAL_BETWEEN_IRRIGATIONS) {
             unsigned long remainingTime = (MIN_INTERVAL_BETWEEN_IRRIGATIONS - timeSinceLastIrrigation) / 1000;
-            Serial.println("⏰ IRRIGAÇÃO BLOQUEADA - Aguardar " + String(remainingTime) + " segundos (intervalo de 5 min)");
+            LOG_WARN("⏰ IRRIGAÇÃO BLOQUEADA - Aguardar %lu segundos (intervalo de 5 min)\n", remainingTime);
             turnOffPump();
             irrigationActive = false;
             return;
         }
     }
-    
+
     // INICIAR IRRIGAÇÃO
     if (shouldStart && !irrigationActive) {
         turnOnPump();
         irrigationActive = true;
         irrigationStartTime = currentTime;
-        Serial.println("🚿 IRRIGAÇÃO INICIADA - Monitorando umidade...");
+        scheduler.trigger(controlTaskId, currentTime);  // Monitorar a cada 100 ms
+        LOG_INFO("🚿 IRRIGAÇÃO INICIADA - Monitorando umidade...\n");
         return;
     }
-    
+
     // PARAR IRRIGAÇÃO (comando externo)
     if (!shouldStart && irrigationActive) {
         turnOffPump();
         irrigationActive = false;
         lastIrrigationEnd = currentTime; // NOVA LINHA - Registrar quando a irrigação terminou
-        Serial.println("🛑 IRRIGAÇÃO INTERROMPIDA - Comando externo");
+        LOG_INFO("🛑 IRRIGAÇÃO INTERROMPIDA - Comando externo\n");
         return;
     }
-    
+
     // VERIFICAR SE DEVE PARAR (apenas se estiver irrigando)
     if (irrigationActive) {
-        unsigned long irrigationDuration = currentTime - irrigationStartTime;
+        HalMillis irrigationDuration = currentTime - irrigationStartTime;
         SensorData currentData = readAllSensors(); // Ler dados atuais
-        
-        bool shouldStop = false;
-        String stopReason = "";
-        
+
+        // Motivo da parada (o log guarda só ponteiros: nada de texto montado na pilha)
+        enum { KEEP_RUNNING, STOP_MAX_TIME, STOP_HUMIDITY, STOP_TANK_EMPTY } stopReason = KEEP_RUNNING;
+
         // CONDIÇÃO 1: Tempo máximo atingido
         if (irrigationDuration >= MAX_IRRIGATION_TIME) {
-            shouldStop = true;
-            stopReason = "Tempo máximo atingido (" + String(MAX_IRRIGATION_TIME/1000) + "s)";
+            stopReason = STOP_MAX_TIME;
         }
-        
+
         // CONDIÇÃO 2: Umidade desejada atingida (após tempo mínimo)
         else if (irrigationDuration >= MIN_IRRIGATION_TIME) {
             // Verificar se umidade mínima foi atingida
             if (currentData.umidadeSolo >= (minSoilHumidity + HUMIDITY_TOLERANCE)) {
-                shouldStop = true;
-                stopReason = "Umidade desejada atingida (" + String(currentData.umidadeSolo) + "% >= " + String(minSoilHumidity + HUMIDITY_TOLERANCE) + "%)";
+                stopReason = STOP_HUMIDITY;
             }
         }
-        
+
         // CONDIÇÃO 3: Tanque vazio (emergência)
         if (tankState == TANK_EMPTY) {
-            shouldStop = true;
-            stopReason = "Tanque vazio - irrigação de emergência interrompida";
+            stopReason = STOP_TANK_EMPTY;
         }
-        
-        if (shouldStop) {
+
+        if (stopReason != KEEP_RUNNING) {
             turnOffPump();
             irrigationActive = false;
             lastIrrigationEnd = currentTime; // NOVA LINHA - Registrar quando a irrigação terminou
-            Serial.println("🛑 IRRIGAÇÃO FINALIZADA - " + stopReason);
+            switch (stopReason) {
+                case STOP_MAX_TIME:
+                    LOG_INFO("🛑 IRRIGAÇÃO FINALIZADA - Tempo máximo atingido (%lus)\n", (unsigned long)(MAX_IRRIGATION_TIME / 1000));
+                    break;
+                case STOP_HUMIDITY:
+                    LOG_INFO("🛑 IRRIGAÇÃO FINALIZADA - Umidade desejada atingida (%.2f%% >= %.2f%%)\n",
+                             currentData.umidadeSolo, minSoilHumidity + HUMIDITY_TOLERANCE);
+                    break;
+                default:
+                    LOG_ERROR("🛑 IRRIGAÇÃO FINALIZADA - Tanque vazio - irrigação de emergência interrompida\n");
+                    break;
+            }
         }
     }
 }
 
+// ======= MOTOR DE INFERÊNCIA =======
+// KNN do firmware com as variantes de build (tabela, partição de dados,
+// aprendizado online). Recebe as leituras cruas, como a árvore.
+class FirmwareKnnEngine : public InferenceEngine {
+public:
+    using InferenceEngine::predict;
+    int predict(const float *input, float *confidence) const override {
+        int prediction;
+#ifdef KNN_USE_LUT
+        // Leituras inteiras dentro da grade: resposta direto da tabela (1 bit, sem confiança)
+        if (knn_lut_lookup(input[0], input[1], input[2], &prediction)) {
+            *confidence = NAN;
+            return prediction;
+        }
+#endif
+        float input_scaled[N_FEATURES];
+        for (int i = 0; i < N_FEATURES; i++) {
+            input_scaled[i] = input[i];
+        }
+
+#ifdef KNN_USE_BLOB
+        if (blobModelLoaded) {
+            knn_blob_standardize(&blobModel, input_scaled);
+            return knn_blob_predict(&blobModel, input_scaled, confidence);
+        }
+#endif
+        standardize(input_scaled, N_FEATURES);
+#ifdef KNN_ONLINE_LEARNING
+        prediction = knn_online_predict(&onlineModel, input_scaled, confidence);
+#else
+        prediction = knn_predict_confidence(input_scaled, confidence);
+#endif
+        return prediction;
+    }
+    const char *name() const override { return "knn"; }
+};
+
+// Leituras repetidas entre verificações reaproveitam a última decisão
+#ifdef INFERENCE_USE_TREE
+const TreeEngine treeEngine;
+MemoizedEngine memoizedEngine(treeEngine);
+#else
+const FirmwareKnnEngine knnEngine;
+MemoizedEngine memoizedEngine(knnEngine);
+#endif
+const InferenceEngine& aiEngine = memoizedEngine;
+float lastAiConfidence = NAN;                         // Confiança da última decisão da IA (telemetria)
+
+// ======= APRENDIZADO ONLINE DO MODELO (LVQ) =======
+#ifdef KNN_ONLINE_LEARNING
+void loadOnlineModel() {
+    knn_online_reset(&onlineModel);
+    modelPrefs.begin("knn", false);
+    KnnOnlineModel stored;
+    if (modelPrefs.getBytesLength("model") == sizeof(stored) &&
+        modelPrefs.getBytes("model", &stored, sizeof(stored)) == sizeof(stored) &&
+        knn_online_is_compatible(&stored)) {
+        onlineModel = stored;
+        hal.printf("🧠 Modelo adaptado carregado da NVS (%lu atualizações)\n", (unsigned long)onlineModel.updates);
+    } else {
+        hal.printf("🧠 Usando modelo original do model_data.h\n");
+    }
+}
+
+void saveOnlineModel() {
+    if (!onlineModelDirty) return;
+    if (modelPrefs.putBytes("model", &onlineModel, sizeof(onlineModel)) == sizeof(onlineModel)) {
+        onlineModelDirty = false;
+        LOG_INFO("💾 Modelo adaptado salvo na NVS\n");
+    } else {
+        LOG_ERROR("❌ Falha ao salvar modelo adaptado\n");
+    }
+}
+
+void learnFromManualCommand(bool irrigate) {
+    SensorData data = readAllSensors();
+    if (data.temperatura == -999 || data.umidadeAr == -999) {
+        LOG_WARN("🧠 Exemplo ignorado - DHT11 com falha\n");
+        return;
+    }
+
+    float input_scaled[N_FEATURES] = {data.temperatura, data.umidadeAr, data.umidadeSolo};
+    standardize(input_scaled, N_FEATURES);
+    int prototype = knn_online_update(&onlineModel, input_scaled, irrigate ? 1 : 0);
+    if (prototype >= 0) {
+        onlineModelDirty = true;
+        memoizedEngine.clear();  // Decisões guardadas são do modelo anterior
+        LOG_INFO("🧠 Protótipo %d ajustado (rótulo %s)\n", prototype, irrigate ? "ON" : "OFF");
+    }
+}
+#endif
+
+// ======= MODELO NA PARTIÇÃO DE DADOS =======
+#ifdef KNN_USE_BLOB
+// Mapeia a partição "model" na memória e valida o blob. O mapeamento nunca
+// é desfeito: os ponteiros de blobModel apontam direto para a flash.
+void loadBlobModel() {
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)MODEL_PARTITION_SUBTYPE, MODEL_PARTITION_NAME);
+    if (partition == NULL) {
+        hal.printf("🧠 Partição \"" MODEL_PARTITION_NAME "\" não encontrada - usando model_data.h\n");
+        return;
+    }
+
+    const void* mapped = NULL;
+#if ESP_IDF_VERSION_MAJOR >= 5  // Arduino-ESP32 3.x
+    esp_partition_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &handle);
+#else
+    spi_flash_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &handle);
+#endif
+    if (err != ESP_OK) {
+        hal.printf("❌ Falha ao mapear a partição do modelo - usando model_data.h\n");
+        return;
+    }
+
+    KnnBlobStatus status = knn_blob_open(mapped, partition->size, &blobModel);
+    if (status != KNN_BLOB_OK) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+        esp_partition_munmap(handle);
+#else
+        spi_flash_munmap(handle);
+#endif
+        hal.printf("🧠 model.bin inválido (%s) - usando model_data.h\n", knn_blob_status_text(status));
+        return;
+    }
+    blobModelLoaded = true;
+    hal.printf("🧠 Modelo carregado da partição: %d protótipos, k=%d, CRC %lx\n", blobModel.n_prototypes,
+               blobModel.n_neighbors, (unsigned long)blobModel.crc32);
+}
+#endif
+
 // ======= LÓGICA DE DECISÃO COM PRIORIDADES E MODO OFFLINE =======
 bool shouldIrrigate(const SensorData& data) {
     // Verificar se os dados são válidos
     if (data.temperatura == -999 || data.umidadeAr == -999) {
-        Serial.println("ERRO: Dados inválidos dos sensores - Irrigação bloqueada");
+        LOG_ERROR("ERRO: Dados inválidos dos sensores - Irrigação bloqueada\n");
         return false;
     }
-    
+
     // NOVA VERIFICAÇÃO - Verificar intervalo mínimo entre irrigações
     if (lastIrrigationEnd > 0) {
-        unsigned long timeSinceLastIrrigation = millis() - lastIrrigationEnd;
+        HalMillis timeSinceLastIrrigation = hal.millis() - lastIrrigationEnd;
         if (timeSinceLastIrrigation < MIN_INTERVAL_BETWEEN_IRRIGATIONS) {
             unsigned long remainingTime = (MIN_INTERVAL_BETWEEN_IRRIGATIONS - timeSinceLastIrrigation) / 1000;
-            Serial.println("⏰ Aguardando intervalo de segurança: " + String(remainingTime) + " segundos restantes");
+            LOG_INFO("⏰ Aguardando intervalo de segurança: %lu segundos restantes\n", remainingTime);
             return false;
         }
     }
-    
+
     // PRIORIDADE 1: Comando manual do ThingsBoard (apenas se conectado)
     if (currentMode == MODE_MANUAL && thingsboardConnected) {
-        Serial.println("🎮 MODO MANUAL ATIVO - Comando ThingsBoard");
+        LOG_INFO("🎮 MODO MANUAL ATIVO - Comando ThingsBoard\n");
         return manualIrrigation;
     }
-    
+
     // Se não conectado ao ThingsBoard, força modo automático
     if (!thingsboardConnected && currentMode == MODE_MANUAL) {
-        Serial.println("📡 Sem conexão - Forçando modo AUTOMÁTICO");
+        LOG_WARN("📡 Sem conexão - Forçando modo AUTOMÁTICO\n");
         currentMode = MODE_AUTO;
     }
-    
+
     // MODO AUTOMÁTICO: Combina IA + Umidade mínima
-    
+    const char* modeText = thingsboardConnected ? "ONLINE" : "OFFLINE";
+
     // PRIORIDADE 2: Umidade crítica (sempre irriga se muito baixa)
-    Serial.println("🔍 VERIFICAÇÃO DE UMIDADE:");
-    Serial.println("   - Umidade solo atual: " + String(data.umidadeSolo) + "%");
-    Serial.println("   - Umidade mínima definida: " + String(minSoilHumidity) + "%");
-    Serial.println("   - Comparação: " + String(data.umidadeSolo) + " < " + String(minSoilHumidity) + " = " + String(data.umidadeSolo < minSoilHumidity ? "VERDADEIRO" : "FALSO"));
-    
+    LOG_DEBUG("🔍 VERIFICAÇÃO DE UMIDADE:\n");
+    LOG_DEBUG("   - Umidade solo atual: %.2f%%\n", data.umidadeSolo);
+    LOG_DEBUG("   - Umidade mínima definida: %.2f%%\n", minSoilHumidity);
+    LOG_DEBUG("   - Comparação: %.2f < %.2f = %s\n", data.umidadeSolo, minSoilHumidity,
+              data.umidadeSolo < minSoilHumidity ? "VERDADEIRO" : "FALSO");
+
     if (data.umidadeSolo < minSoilHumidity) {
-        String modeText = thingsboardConnected ? "ONLINE" : "OFFLINE";
-        Serial.println("🌱 UMIDADE CRÍTICA (" + modeText + ") - Irrigação prioritária (" + 
-                      String(data.umidadeSolo) + "% < " + String(minSoilHumidity) + "%)");
+        LOG_INFO("🌱 UMIDADE CRÍTICA (%s) - Irrigação prioritária (%.2f%% < %.2f%%)\n",
+                 modeText, data.umidadeSolo, minSoilHumidity);
         return true;
     }
-    
+
     // PRIORIDADE 3: Decisão da IA (se umidade não está crítica)
     float input[N_FEATURES] = {data.temperatura, data.umidadeAr, data.umidadeSolo};
-    float input_scaled[N_FEATURES];
-    for (int i = 0; i < N_FEATURES; i++) {
-        input_scaled[i] = input[i];
-    }
-    standardize(input_scaled, N_FEATURES);
-    
-    int prediction = knn_predict(input_scaled);
+    int prediction = aiEngine.predict(input, &lastAiConfidence);
     if (prediction == 1) {
-        String modeText = thingsboardConnected ? "ONLINE" : "OFFLINE";
-        Serial.println("🤖 IA DECIDIU (" + modeText + ") - Irrigação recomendada (Temp:" + String(data.temperatura) + 
-                      "°C, Umid.Ar:" + String(data.umidadeAr) + "%, Umid.Solo:" + String(data.umidadeSolo) + "%)");
+        LOG_INFO("🤖 IA DECIDIU (%s) - Irrigação recomendada (Temp:%.2f°C, Umid.Ar:%.2f%%, Umid.Solo:%.2f%%, confiança %.2f)\n",
+                 modeText, data.temperatura, data.umidadeAr, data.umidadeSolo, lastAiConfidence);
         return true;
     }
-    
-    String modeText = thingsboardConnected ? "ONLINE" : "OFFLINE";
-    Serial.println("✅ CONDIÇÕES OK (" + modeText + ") - Irrigação não necessária");
+
+    LOG_INFO("✅ CONDIÇÕES OK (%s) - Irrigação não necessária\n", modeText);
     return false;
 }
 
 // ======= ENVIO DE TELEMETRIA COM VERIFICAÇÃO DE CONEXÃO =======
-void sendTelemetry(const SensorData& data, bool irrigationDecision) {
+// Núcleo de controle: copia o estado que a telemetria precisa
+TelemetryFrame buildTelemetryFrame(const SensorData& data, bool irrigationDecision) {
+    TelemetryFrame frame;
+    frame.data = data;
+    frame.irrigating = irrigationActive; // Usar estado real da irrigação
+    frame.pumpOn = isPumpOn();
+    frame.irrigationBlocked = irrigationBlocked;
+    frame.aiDecision = irrigationDecision;
+    frame.aiConfidence = lastAiConfidence;
+    frame.minSoilHumidity = minSoilHumidity;
+    frame.tankState = getTankStateText();
+    frame.mode = getModeText();
+    frame.irrigationElapsed = irrigationActive ? hal.millis() - irrigationStartTime : 0;
+    frame.sampledAt = hal.millis();
+    frame.timestamp = hal.epochMs();
+#ifdef KNN_ONLINE_LEARNING
+    frame.modelUpdates = onlineModel.updates;
+#endif
+    return frame;
+}
+
+// Núcleo de rede: chaves de uma amostra que saíram da banda morta (só lê o
+// quadro e constantes); devolve quantas foram escritas
+template <typename T>
+int deltaField(JsonWriter& json, TelemetryKey key, T value, HalMillis sampledAt) {
+    if (!telemetryDeadband.update(key, (float)value, sampledAt)) return 0;
+    json.field(telemetryDeadband.name(key), value);
+    return 1;
+}
+
+int deltaField(JsonWriter& json, TelemetryKey key, const char* text, HalMillis sampledAt) {
+    if (!telemetryDeadband.update(key, text, sampledAt)) return 0;
+    json.field(telemetryDeadband.name(key), text);
+    return 1;
+}
+
+int writeTelemetryValues(JsonWriter& json, const TelemetryFrame& frame) {
+    const SensorData& data = frame.data;
+    const HalMillis at = frame.sampledAt;
+    int written = 0;
+    written += deltaField(json, KEY_TEMPERATURE, data.temperatura, at);
+    written += deltaField(json, KEY_HUMIDITY, data.umidadeAr, at);
+    written += deltaField(json, KEY_SOIL_MOISTURE, data.umidadeSolo, at);
+    written += deltaField(json, KEY_RAIN_INTENSITY, data.chuvaAnalogica, at);
+    written += deltaField(json, KEY_IRRIGATING, frame.irrigating, at);
+    written += deltaField(json, KEY_TANK_STATE, data.tankStatus, at);
+    written += deltaField(json, KEY_IRRIGATION_BLOCKED, frame.irrigationBlocked, at);
+    written += deltaField(json, KEY_CURRENT_MODE, frame.mode, at);
+    written += deltaField(json, KEY_MIN_SOIL_HUMIDITY, frame.minSoilHumidity, at);
+    written += deltaField(json, KEY_AI_DECISION, frame.aiDecision, at);
+    written += deltaField(json, KEY_OFFLINE_MODE, false, at); // Indicar que está online
+    written += deltaField(json, KEY_AI_ENGINE, aiEngine.name(), at);
+    if (!isnan(frame.aiConfidence)) {
+        written += deltaField(json, KEY_AI_CONFIDENCE, frame.aiConfidence, at);  // Da última verificação
+    }
+#ifdef KNN_ONLINE_LEARNING
+    written += deltaField(json, KEY_AI_MODEL_UPDATES, frame.modelUpdates, at);
+#endif
+#ifdef KNN_USE_BLOB
+    char crcText[12];
+    snprintf(crcText, sizeof(crcText), "%lx", (unsigned long)blobModel.crc32);
+    written += deltaField(json, KEY_AI_MODEL_CRC, blobModelLoaded ? crcText : "firmware", at);
+#endif
+
+    // Adicionar informações de tempo se irrigando
+    if (frame.irrigating) {
+        unsigned long elapsed = frame.irrigationElapsed;
+        written += deltaField(json, KEY_IRRIGATION_DURATION, elapsed / 1000, at);
+        written += deltaField(json, KEY_IRRIGATION_REMAINING, (MAX_IRRIGATION_TIME - elapsed) / 1000, at);
+    }
+
+    if (data.bmpOk) {
+        written += deltaField(json, KEY_PRESSURE, data.pressao, at);
+        written += deltaField(json, KEY_ALTITUDE, data.altitude, at);
+        written += deltaField(json, KEY_WEATHER, data.weatherCondition, at);
+    }
+    return written;
+}
+
+// Guarda a amostra no lote; cheio (sem conexão), descarta a mais velha
+void batchTelemetry(const TelemetryFrame& frame) {
+    if (telemetryBatchCount == TELEMETRY_BATCH_SIZE) {
+        telemetryBatchFirst = (telemetryBatchFirst + 1) % TELEMETRY_BATCH_SIZE;
+        telemetryBatchCount--;
+        telemetryBatchDropped++;
+    }
+    telemetryBatch[(telemetryBatchFirst + telemetryBatchCount) % TELEMETRY_BATCH_SIZE] = frame;
+    telemetryBatchCount++;
+}
+
+bool isTelemetryBatchDue() {
+    if (telemetryBatchCount == 0) return false;
+    if (telemetryBatchCount >= TELEMETRY_BATCH_SIZE) return true;
+    const TelemetryFrame& oldest = telemetryBatch[telemetryBatchFirst];
+    return (HalMillisDelta)(hal.millis() - oldest.sampledAt) >= (HalMillisDelta)TELEMETRY_BATCH_MAX_AGE;
+}
+
+// Publica o lote como [{"ts":...,"values":{...}}, ...], cada amostra só com
+// as chaves que mudaram; amostra sem nenhuma fica de fora. Amostras sem hora
+// (NTP ainda sem resposta) recebem todas a hora de chegada no ThingsBoard,
+// que guardaria só o último valor de cada chave: vai só a mais nova delas,
+// como um objeto sem "ts" (o último valor de cada chave vence). Se a
+// publicação falhar, o lote (e a banda morta) fica para a reconexão
+void sendTelemetry() {
     // Só envia telemetria se conectado ao ThingsBoard
-    if (!thingsboardConnected || !client.connected()) {
-        Serial.println("📡 Telemetria não enviada - Sem conexão com ThingsBoard");
+    if (!thingsboardConnected || !hal.mqttConnected()) {
         return;
     }
 
-    DynamicJsonDocument doc(1024);
+    static char payload[TELEMETRY_PAYLOAD_SIZE];   // Fora da pilha da tarefa de rede
+    JsonWriter json(payload, sizeof(payload));
+    int lastUntimed = -1;
+    for (int i = 0; i < telemetryBatchCount; i++) {
+        if (telemetryBatch[(telemetryBatchFirst + i) % TELEMETRY_BATCH_SIZE].timestamp == 0) lastUntimed = i;
+    }
 
-    doc["temperature"] = data.temperatura;
-    doc["humidity"] = data.umidadeAr;
-    doc["soilMoisture"] = data.umidadeSolo;
-    doc["rainIntensity"] = data.chuvaAnalogica;
-    doc["irrigating"] = irrigationActive; // Usar estado real da irrigação
-    doc["tankState"] = data.tankStatus;
-    doc["irrigationBlocked"] = irrigationBlocked;
-    doc["currentMode"] = getModeText();
-    doc["minSoilHumidity"] = minSoilHumidity;
-    doc["aiDecision"] = irrigationDecision;
-    doc["offlineMode"] = false; // Indicar que está online
+    json.beginArray();
+    int samples = 0;
+    int merged = 0;
+    for (int i = 0; i < telemetryBatchCount; i++) {
+        const TelemetryFrame& frame = telemetryBatch[(telemetryBatchFirst + i) % TELEMETRY_BATCH_SIZE];
+        if (frame.timestamp == 0 && i != lastUntimed) {
+            merged++;
+            continue;
+        }
+        const JsonWriter::Mark sampleStart = json.mark();
+        int keys;
+        json.beginObject();
+        if (frame.timestamp != 0) {
+            json.field("ts", frame.timestamp);
+            json.key("values");
+            json.beginObject();
+            keys = writeTelemetryValues(json, frame);
+            json.endObject();
+        } else {
+            keys = writeTelemetryValues(json, frame);
+        }
+        json.endObject();
+        if (keys == 0) {
+            json.rewind(sampleStart);
+            telemetrySamplesSuppressed++;
+        } else {
+            samples++;
+        }
+    }
+    json.endArray();
 
-    // Adicionar informações de tempo se irrigando
+    if (!json.ok()) {
+        hal.printf("❌ Telemetria excedeu %u bytes - lote descartado\n", (unsigned)sizeof(payload));
+        telemetryDeadband.rollback();
+        telemetryBatchCount = 0;
+        return;
+    }
+
+    if (samples == 0) {
+        telemetrySamplesMerged += merged;
+        telemetryBatchCount = 0;  // Nada mudou: nenhuma publicação
+        return;
+    }
+
+    if (hal.mqttPublish("v1/devices/me/telemetry", payload)) {
+        hal.printf("📡 Telemetria enviada ao ThingsBoard (%d amostras)\n", samples);
+        telemetryDeadband.commit();
+        telemetrySamplesMerged += merged;
+        telemetryBatchCount = 0;
+    } else {
+        hal.printf("❌ Falha ao enviar telemetria\n");
+        telemetryDeadband.rollback();
+        thingsboardConnected = false; // Marcar como desconectado
+    }
+}
+
+// ======= TAREFAS DO NÚCLEO DE REDE =======
+// Nada aqui mexe na bomba ou no tanque: um connectWiFi() de 30 s atrasa só
+// a rede
+
+// MQTT a cada 100 ms; sem conexão, uma tentativa por minuto. Depois junta
+// ao lote os quadros que o controle enfileirou e publica o lote vencido
+void networkTask() {
+    if (thingsboardConnected) {
+        if (!hal.mqttConnected()) {
+            thingsboardConnected = false;
+            hal.printf("❌ Conexão ThingsBoard perdida - Mudando para modo OFFLINE\n");
+        } else {
+            hal.mqttLoop(); // Processar mensagens apenas se conectado
+        }
+    } else {
+        tryReconnect();
+    }
+
+    TelemetryFrame frame;
+    while (telemetryQueue.pop(&frame)) {
+        lastTelemetryFrame = frame;
+        batchTelemetry(frame);
+    }
+    if (isTelemetryBatchDue()) {
+        sendTelemetry();
+    }
+    networkScheduler.setPeriod(networkTaskId, thingsboardConnected ? NETWORK_POLL_INTERVAL : CONNECTION_RETRY_INTERVAL);
+}
+
+// ======= TAREFAS DO NÚCLEO DE CONTROLE =======
+// Cada tarefa faz sua parte e retorna; entre os prazos o loop() fica ocioso
+
+// Comandos RPC enfileirados pelo núcleo de rede
+void applyCommands() {
+    ControlCommand command;
+    while (commandQueue.pop(&command)) {
+        switch (command.type) {
+            case CMD_MANUAL_IRRIGATION: {
+                bool enable = command.value != 0;
+                manualIrrigation = enable;
+                currentMode = enable ? MODE_MANUAL : MODE_AUTO;
+#ifdef KNN_ONLINE_LEARNING
+                learnFromManualCommand(enable); // Comando do operador = exemplo rotulado
+#endif
+                controlSmartPump(enable);
+                break;
+            }
+            case CMD_MIN_HUMIDITY:
+                minSoilHumidity = command.value;
+                break;
+            case CMD_AUTO_MODE:
+                currentMode = MODE_AUTO;
+                manualIrrigation = false;
+                break;
+            case CMD_EMERGENCY_STOP:
+                controlSmartPump(false);
+                manualIrrigation = false;
+                break;
+        }
+    }
+}
+
+// Controle: parada da irrigação e tanque. A cada 100 ms com a bomba ou a
+// válvula ligada; com tudo desligado, a cada TANK_CHECK_INTERVAL
+void controlTask() {
     if (irrigationActive) {
-        unsigned long duration = (millis() - irrigationStartTime) / 1000;
-        doc["irrigationDuration"] = duration;
-        doc["irrigationTimeRemaining"] = (MAX_IRRIGATION_TIME - (millis() - irrigationStartTime)) / 1000;
+        controlSmartPump(true); // Verifica condições de parada
     }
+    manageTankSystem();
+    scheduler.setPeriod(controlTaskId, (isPumpOn() || isSolenoidOn()) ? CONTROL_INTERVAL : TANK_CHECK_INTERVAL);
+}
 
-    if (data.bmpOk) {
-        doc["pressure"] = data.pressao;
-        doc["altitude"] = data.altitude;
-        doc["weather"] = data.weatherCondition;
+// DHT11: avança a transação em segundo plano no ritmo que ela pede
+void sensorTask() {
+    HalMillis next = hal.dhtPoll();
+    scheduler.setPeriod(sensorTaskId, next > 0 ? next : 1);
+}
+
+// Único ponto que amostra o FC-28 e o FC-37: a mediana cobre quadros
+// seguidos, não as leituras espaçadas do controle
+void adcTask() {
+    hal.analogPoll();
+}
+
+void printTask() {
+    printSensorData(refreshSensors().data);
+}
+
+// Decide se deve INICIAR a irrigação; a parada fica com a tarefa de controle
+void irrigationCheckTask() {
+    if (irrigationActive) return;
+
+    SensorData sensorData = readAllSensors();
+
+    // Validar dados críticos antes de tomar decisão
+    if (sensorData.temperatura == -999 || sensorData.umidadeAr == -999) {
+        LOG_ERROR("ERRO CRÍTICO: DHT11 com falha - Pausando irrigação\n");
+        controlSmartPump(false); // Garantir que está desligada
+        return;
+    }
+
+    bool shouldStart = shouldIrrigate(sensorData);
+    if (shouldStart) {
+        controlSmartPump(true); // Iniciar irrigação inteligente
+    }
+
+    LOG_INFO("=== VERIFICAÇÃO DE IRRIGAÇÃO (%s) EXECUTADA (1 minuto) ===\n",
+             thingsboardConnected ? "ONLINE" : "OFFLINE");
+    LOG_DEBUG("Próxima verificação em: %lu segundos\n", (unsigned long)(IRRIGATION_CHECK_INTERVAL / 1000));
+}
+
+// Quadro para o núcleo de rede; com a fila cheia o quadro é descartado
+void telemetryTask() {
+    if (!thingsboardConnected) {
+        LOG_WARN("📡 Telemetria no lote - Sem conexão com ThingsBoard\n");
+    }
+    if (!telemetryQueue.push(buildTelemetryFrame(refreshSensors().data, irrigationActive))) {
+        telemetryDropped++;
+    }
+}
+
+// Atraso de cada tarefa em relação ao prazo (jitter) e períodos perdidos
+void printTaskReport(const char* title, const TaskScheduler& tasks) {
+    LOG_INFO("\n⏱️ %s (atraso em relação ao prazo):\n", title);
+    for (int i = 0; i < tasks.count(); i++) {
+        const SchedTask& task = tasks.task(i);
+        LOG_INFO("   %-10s %8lu execuções | médio %lu ms | máx %lu ms | %lu períodos perdidos\n", task.name,
+                 task.runs, task.runs > 0 ? task.lateSumMs / task.runs : 0, task.lateMaxMs, task.overruns);
+    }
+}
+
+void printControlReport() {
+    printTaskReport("NÚCLEO DE CONTROLE", scheduler);
+    LOG_INFO("   Telemetria descartada (fila cheia): %lu\n", telemetryDropped);
+#ifdef CONTROLLER_COUNT_ALLOCS
+    LOG_INFO("   Alocações no heap: %lu loop()s com alocação, máx %lu por loop()\n", allocatingLoops,
+             loopAllocationsMax);
+#endif
+}
+
+void printNetworkReport() {
+    printTaskReport("NÚCLEO DE REDE", networkScheduler);
+    LOG_INFO("   Comandos recusados (fila cheia): %lu\n", commandsRejected);
+    LOG_INFO("   Amostras de telemetria descartadas (lote cheio): %lu\n", telemetryBatchDropped);
+    LOG_INFO("   Amostras de telemetria sem mudança (banda morta): %lu\n", telemetrySamplesSuppressed);
+    LOG_INFO("   Amostras de telemetria sem hora cobertas pela mais nova: %lu\n", telemetrySamplesMerged);
+}
+
+// Um ciclo do lado de rede; devolve quantos ms faltam para o próximo prazo
+HalMillis networkLoopOnce() {
+    networkScheduler.runDue(hal.millis());
+    return networkScheduler.timeUntilNext(hal.millis());  // tryReconnect() pode ter demorado
+}
+
+#ifdef ARDUINO
+void networkCoreMain(void*) {
+    for (;;) {
+        vTaskDelay(pdMS_TO_TICKS(networkLoopOnce()));
     }
+}
 
-    String payload;
-    serializeJson(doc, payload);
+// Tarefa de rede no núcleo 0; false em chips de um núcleo (S2, C3)
+bool startNetworkCore() {
+#if CONFIG_FREERTOS_UNICORE
+    return false;
+#else
+    return xTaskCreatePinnedToCore(networkCoreMain, "rede", NETWORK_TASK_STACK, NULL, NETWORK_TASK_PRIORITY, NULL,
+                                   NETWORK_CORE) == pdPASS;
+#endif
+}
+
+// Formata os registros de log (deferred_log.h) fora do caminho de controle
+void logTaskMain(void*) {
+    for (;;) {
+        logDrain(hal);
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+    }
+}
 
-    if (client.publish("v1/devices/me/telemetry", payload.c_str())) {
-        Serial.println("📡 Telemetria enviada ao ThingsBoard");
+bool startLogTask() {
+    return xTaskCreatePinnedToCore(logTaskMain, "log", LOG_TASK_STACK, NULL, LOG_TASK_PRIORITY, NULL, NETWORK_CORE) ==
+           pdPASS;
+}
+#else
+bool startNetworkCore();  // Fornecida pelo programa de host (greenhouse_sim emula o segundo núcleo)
+bool startLogTask() { return false; }  // Host: o loop() formata o log depois das tarefas
+#endif
+
+void startTasks() {
+    HalMillis now = hal.millis();
+    controlTaskId = scheduler.addPeriodic("controle", controlTask, TANK_CHECK_INTERVAL, 0, now);
+    sensorTaskId = scheduler.addPeriodic("dht", sensorTask, 1, 0, now);
+    scheduler.addPeriodic("adc", adcTask, ADC_POLL_INTERVAL, 0, now);
+    scheduler.addPeriodic("console", printTask, SENSOR_READ_INTERVAL, SENSOR_READ_INTERVAL, now);
+    // PRIMEIRA VERIFICAÇÃO EM 1 MINUTO (evita irrigação imediata)
+    scheduler.addPeriodic("irrigacao", irrigationCheckTask, IRRIGATION_CHECK_INTERVAL, IRRIGATION_CHECK_INTERVAL, now);
+    scheduler.addPeriodic("telemetria", telemetryTask, TELEMETRY_INTERVAL, TELEMETRY_INTERVAL, now);
+#ifdef KNN_ONLINE_LEARNING
+    // Persistir o modelo adaptado periodicamente
+    scheduler.addPeriodic("modelo", saveOnlineModel, MODEL_SAVE_INTERVAL, MODEL_SAVE_INTERVAL, now);
+#endif
+    scheduler.addPeriodic("relatorio", printControlReport, SCHEDULER_REPORT_INTERVAL, SCHEDULER_REPORT_INTERVAL, now);
+
+    HalMillis networkPeriod = thingsboardConnected ? NETWORK_POLL_INTERVAL : CONNECTION_RETRY_INTERVAL;
+    networkTaskId = networkScheduler.addPeriodic("rede", networkTask, networkPeriod, networkPeriod, now);
+    networkScheduler.addPeriodic("relatorio", printNetworkReport, SCHEDULER_REPORT_INTERVAL, SCHEDULER_REPORT_INTERVAL, now);
+
+    // Estado inicial para o getSystemStatus, antes de o outro núcleo existir
+    lastTelemetryFrame = buildTelemetryFrame(refreshSensors().data, irrigationActive);
+
+    // Impressão imediata desligada antes de criar as tarefas: com ela, cada
+    // LOG_*() da tarefa de rede chamaria logDrain() e o anel SPSC teria dois
+    // consumidores (rede e tarefa "log"). O que sobrou do setup sai aqui
+    logDrain(hal);
+    logImmediateOutput = NULL;
+    networkOnOwnCore = startNetworkCore();
+    if (networkOnOwnCore) {
+        hal.printf("🧵 Rede no núcleo %d, controle no loop()\n", NETWORK_CORE);
     } else {
-        Serial.println("❌ Falha ao enviar telemetria");
-        thingsboardConnected = false; // Marcar como desconectado
+        hal.printf("🧵 Rede e controle no mesmo loop()\n");
     }
+    logOnOwnTask = startLogTask();
 }
 
 // ======= SETUP DO SISTEMA =======
 void setup() {
-    Serial.begin(115200);
-    Serial.println("SISTEMA DE IRRIGAÇÃO INTELIGENTE v2.0");
-    Serial.println("Com ThingsBoard e Controle Automático de Tanque");
-    Serial.println("=======================================");
-    
+#ifdef ARDUINO
+    esp32Hal.begin(115200);
+#endif
+    logImmediateOutput = &hal;  // Até startTasks(): LOG_*() imprime na hora, na ordem do setup
+    hal.printf("SISTEMA DE IRRIGAÇÃO INTELIGENTE v2.0\n");
+    hal.printf("Com ThingsBoard e Controle Automático de Tanque\n");
+    hal.printf("=======================================\n");
+
     // Conectar Wi-Fi e ThingsBoard
     connectWiFi();
-    client.setServer(thingsboardServer, 1883);
-    client.setCallback(callback);
+    hal.timeBegin(ntpServer);
+    hal.mqttBegin(thingsboardServer, 1883, callback);
     connectThingsBoard();
-    
+
     // Atualizar status inicial de conexão
-    thingsboardConnected = (WiFi.status() == WL_CONNECTED && client.connected());
-    
+    thingsboardConnected = (hal.wifiConnected() && hal.mqttConnected());
+
     if (thingsboardConnected) {
-        Serial.println("✅ Sistema ONLINE - ThingsBoard conectado");
-    } else {
-        Serial.println("⚠️ Sistema OFFLINE - Funcionando autonomamente");
-    }
-    
-    // Inicializar I2C e BMP280
-    Wire.begin(BMP_SDA, BMP_SCL);
-    delay(100); // Aguardar estabilizar
-    
-    // Tentar múltiplos endereços e configurações
-    bmpAvailable = false;
-    if (bmp.begin(0x76)) {
-        Serial.println("BMP280 inicializado no endereço 0x76");
-        bmpAvailable = true;
-    } else if (bmp.begin(0x77)) {
-        Serial.println("BMP280 inicializado no endereço 0x77");
-        bmpAvailable = true;
+        hal.printf("✅ Sistema ONLINE - ThingsBoard conectado\n");
     } else {
-        Serial.println("⚠️ BMP280 não encontrado - Continuando sem sensor de pressão");
-        bmpAvailable = false;
+        hal.printf("⚠️ Sistema OFFLINE - Funcionando autonomamente\n");
     }
-    
+
+    // Inicializar I2C e BMP280 (tenta os endereços 0x76 e 0x77)
+    int bmpAddress = hal.bmpBegin();
+    bmpAvailable = bmpAddress != 0;
     if (bmpAvailable) {
-        bmp.setSampling(Adafruit_BMP280::MODE_NORMAL,
-                       Adafruit_BMP280::SAMPLING_X2,
-                       Adafruit_BMP280::SAMPLING_X16,
-                       Adafruit_BMP280::FILTER_X16,
-                       Adafruit_BMP280::STANDBY_MS_500);
-        delay(100); // Aguardar configuração
-        
+        hal.printf("BMP280 inicializado no endereço 0x%x\n", bmpAddress);
+
         // Teste de leitura
-        float testPressure = bmp.readPressure() / 100.0F;
+        float testPressure, testAltitude;
+        hal.bmpRead(&testPressure, &testAltitude);
         if (testPressure < 300 || testPressure > 1100) {
-            Serial.println("⚠️ BMP280 com leituras inválidas - Desabilitando");
+            hal.printf("⚠️ BMP280 com leituras inválidas - Desabilitando\n");
             bmpAvailable = false;
         } else {
-            Serial.println("✅ BMP280 funcionando corretamente");
+            hal.printf("✅ BMP280 funcionando corretamente\n");
         }
+    } else {
+        hal.printf("⚠️ BMP280 não encontrado - Continuando sem sensor de pressão\n");
     }
-    
+
     // Configurar pinos
-    pinMode(SOIL_MOISTURE_PIN, INPUT);
-    pinMode(RAIN_ANALOG_PIN, INPUT);
-    pinMode(LEVEL_SENSOR1_PIN, INPUT);
-    pinMode(LEVEL_SENSOR2_PIN, INPUT);
-    
-    pinMode(PUMP_PIN, OUTPUT);
-    pinMode(SOLENOIDE_PIN, OUTPUT);
-    
+    hal.pinMode(SOIL_MOISTURE_PIN, HAL_PIN_INPUT);
+    hal.pinMode(RAIN_ANALOG_PIN, HAL_PIN_INPUT);
+    hal.pinMode(LEVEL_SENSOR1_PIN, HAL_PIN_INPUT);
+    hal.pinMode(LEVEL_SENSOR2_PIN, HAL_PIN_INPUT);
+
+    hal.pinMode(PUMP_PIN, HAL_PIN_OUTPUT);
+    hal.pinMode(SOLENOIDE_PIN, HAL_PIN_OUTPUT);
+
+    // FC-28 e FC-37 amostrados em segundo plano (média por quadro + mediana)
+    const int analogPins[] = {SOIL_MOISTURE_PIN, RAIN_ANALOG_PIN};
+    hal.analogBegin(analogPins, 2);
+
     // Estado inicial
     turnOffPump();
     turnOffSolenoid();
-    
+
     // Inicializar DHT
-    dht.begin();
-    
+    hal.dhtBegin();
+
+#ifdef KNN_ONLINE_LEARNING
+    loadOnlineModel();
+#endif
+#ifdef KNN_USE_BLOB
+    loadBlobModel();
+#endif
+    hal.printf("🧠 Motor de inferência: %s\n", aiEngine.name());
+
     // Estado inicial do tanque
     tankState = readTankLevel();
-    
-    // INICIALIZAR TEMPOS PARA EVITAR IRRIGAÇÃO IMEDIATA
-    unsigned long currentTime = millis();
-    lastTankCheck = currentTime;
-    lastTelemetry = currentTime;
-    lastIrrigationCheck = currentTime + IRRIGATION_CHECK_INTERVAL; // PRIMEIRA VERIFICAÇÃO EM 1 MINUTO
-    lastSensorRead = currentTime;
-    lastConnectionAttempt = currentTime;
-    
-    Serial.println("Sistema inicializado com sucesso!");
-    Serial.println("⏰ Primeira verificação de irrigação em: " + String(IRRIGATION_CHECK_INTERVAL/1000) + " segundos (1 minuto)");
-    
+
+    hal.printf("Sistema inicializado com sucesso!\n");
+    hal.printf("⏰ Primeira verificação de irrigação em: %lu segundos (1 minuto)\n", (unsigned long)(IRRIGATION_CHECK_INTERVAL / 1000));
+
     if (thingsboardConnected) {
-        Serial.println("📡 MODO ONLINE ATIVO");
-        Serial.println("Comandos disponíveis via ThingsBoard:");
-        Serial.println("   - setManualIrrigation: Controle manual");
-        Serial.println("   - setMinHumidity: Define umidade mínima (integrada no modo AUTO)");
-        Serial.println("   - setAutoMode: Volta para modo IA + Umidade");
-        Serial.println("   - getSystemStatus: Status do sistema");
-        Serial.println("   - emergencyStop: Parada de emergência");
+        hal.printf("📡 MODO ONLINE ATIVO\n");
+        hal.printf("Comandos disponíveis via ThingsBoard:\n");
+        hal.printf("   - setManualIrrigation: Controle manual\n");
+        hal.printf("   - setMinHumidity: Define umidade mínima (integrada no modo AUTO)\n");
+        hal.printf("   - setAutoMode: Volta para modo IA + Umidade\n");
+        hal.printf("   - getSystemStatus: Status do sistema\n");
+        hal.printf("   - emergencyStop: Parada de emergência\n");
     } else {
-        Serial.println("🔋 MODO OFFLINE ATIVO");
-        Serial.println("Sistema funcionará autonomamente:");
-        Serial.println("   - Modo automático (IA + Umidade mínima)");
-        Serial.println("   - Umidade mínima atual: " + String(minSoilHumidity) + "%");
-        Serial.println("   - Tentará reconectar automaticamente");
-    }
-    Serial.println("=======================================");
-    
+        hal.printf("🔋 MODO OFFLINE ATIVO\n");
+        hal.printf("Sistema funcionará autonomamente:\n");
+        hal.printf("   - Modo automático (IA + Umidade mínima)\n");
+        hal.printf("   - Umidade mínima atual: %.2f%%\n", minSoilHumidity);
+        hal.printf("   - Tentará reconectar automaticamente\n");
+    }
+    hal.printf("=======================================\n");
+
     // EXIBIR VALORES INICIAIS DAS VARIÁVEIS CRÍTICAS
-    Serial.println("\n🔧 CONFIGURAÇÕES INICIAIS:");
-    Serial.println("==========================================");
-    Serial.println("💧 Umidade mínima do solo: " + String(minSoilHumidity) + "%");
-    Serial.println("⏰ Intervalo de verificação: " + String(IRRIGATION_CHECK_INTERVAL/1000) + " segundos (1 minuto)");
-    Serial.println("⏱️ Tempo mínimo de irrigação: " + String(MIN_IRRIGATION_TIME/1000) + " segundos");
-    Serial.println("⏱️ Tempo máximo de irrigação: " + String(MAX_IRRIGATION_TIME/1000) + " segundos");
-    Serial.println("⏳ Intervalo mínimo entre irrigações: " + String(MIN_INTERVAL_BETWEEN_IRRIGATIONS/1000) + " segundos (5 minutos)");
-    Serial.println("🎛️ Modo inicial: " + getModeText());
-    Serial.println("🔧 Irrigação manual: " + String(manualIrrigation ? "ATIVADA" : "DESATIVADA"));
-    Serial.println("🌐 ThingsBoard: " + String(thingsboardConnected ? "CONECTADO" : "DESCONECTADO"));
-    Serial.println("==========================================");
-    
-    Serial.println("🕐 Aguardando estabilização dos sensores...");
-    delay(2000); // Aguardar estabilização
-    
+    hal.printf("\n🔧 CONFIGURAÇÕES INICIAIS:\n");
+    hal.printf("==========================================\n");
+    hal.printf("💧 Umidade mínima do solo: %.2f%%\n", minSoilHumidity);
+    hal.printf("⏰ Intervalo de verificação: %lu segundos (1 minuto)\n", (unsigned long)(IRRIGATION_CHECK_INTERVAL / 1000));
+    hal.printf("⏱️ Tempo mínimo de irrigação: %lu segundos\n", (unsigned long)(MIN_IRRIGATION_TIME / 1000));
+    hal.printf("⏱️ Tempo máximo de irrigação: %lu segundos\n", (unsigned long)(MAX_IRRIGATION_TIME / 1000));
+    hal.printf("⏳ Intervalo mínimo entre irrigações: %lu segundos (5 minutos)\n", (unsigned long)(MIN_INTERVAL_BETWEEN_IRRIGATIONS / 1000));
+    hal.printf("🎛️ Modo inicial: %s\n", getModeText());
+    hal.printf("🔧 Irrigação manual: %s\n", manualIrrigation ? "ATIVADA" : "DESATIVADA");
+    hal.printf("🌐 ThingsBoard: %s\n", thingsboardConnected ? "CONECTADO" : "DESCONECTADO");
+    hal.printf("==========================================\n");
+
+    hal.printf("🕐 Aguardando estabilização dos sensores...\n");
+    // Aguardar estabilização; o DHT11 faz a primeira leitura em segundo plano
+    HalMillis stabilizeStart = hal.millis();
+    while (hal.millis() - stabilizeStart < 2000) {
+        float t, h;
+        HalMillis age;
+        hal.dhtRead(&t, &h, &age);
+        hal.delay(10);
+    }
+
     // TESTE INICIAL DOS SENSORES APÓS ESTABILIZAÇÃO
-    Serial.println("\n🧪 TESTE INICIAL DOS SENSORES:");
-    Serial.println("==========================================");
+    hal.printf("\n🧪 TESTE INICIAL DOS SENSORES:\n");
+    hal.printf("==========================================\n");
     SensorData initialData = readAllSensors();
-    Serial.println("📊 Temperatura: " + String(initialData.temperatura) + "°C");
-    Serial.println("📊 Umidade do ar: " + String(initialData.umidadeAr) + "%");
-    Serial.println("📊 Umidade do solo: " + String(initialData.umidadeSolo) + "% (Limite: " + String(minSoilHumidity) + "%)");
-    Serial.println("📊 Deve irrigar: " + String((initialData.umidadeSolo < minSoilHumidity) ? "SIM" : "NÃO"));
-    Serial.println("==========================================");
-    
-    delay(2000);
+    hal.printf("📊 Temperatura: %.2f°C\n", initialData.temperatura);
+    hal.printf("📊 Umidade do ar: %.2f%%\n", initialData.umidadeAr);
+    hal.printf("📊 Umidade do solo: %.2f%% (Limite: %.2f%%)\n", initialData.umidadeSolo, minSoilHumidity);
+    hal.printf("📊 Deve irrigar: %s\n", (initialData.umidadeSolo < minSoilHumidity) ? "SIM" : "NÃO");
+    hal.printf("==========================================\n");
+
+    hal.delay(2000);
+    startTasks();
+#ifdef CONTROLLER_COUNT_ALLOCS
+    allocCounterAttach();  // Só o laço de controle (esta tarefa) é contado
+#endif
 }
 
 // ======= LOOP PRINCIPAL =======
 void loop() {
-    // === GERENCIAR CONEXÕES ===
-    // Verificar conexão ThingsBoard apenas se conectado
-    if (thingsboardConnected) {
-        if (!client.connected()) {
-            thingsboardConnected = false;
-            Serial.println("❌ Conexão ThingsBoard perdida - Mudando para modo OFFLINE");
-        } else {
-            client.loop(); // Processar mensagens apenas se conectado
-        }
-    } else {
-        // Tentar reconectar periodicamente
-        tryReconnect();
+#ifdef CONTROLLER_COUNT_ALLOCS
+    const unsigned long allocationsBefore = heapAllocations;
+#endif
+    applyCommands();
+    scheduler.runDue(hal.millis());
+    if (!networkOnOwnCore) {
+        networkScheduler.runDue(hal.millis());
     }
-
-    unsigned long currentTime = millis();
-    
-    // === SEMPRE ler sensores (dados frescos) ===
-    SensorData sensorData = readAllSensors();
-    
-    // === Imprimir dados dos sensores a cada 2 segundos ===
-    if (isTimeElapsed(lastSensorRead, SENSOR_READ_INTERVAL)) {
-        printSensorData(sensorData);
-        lastSensorRead = currentTime;
+#ifdef CONTROLLER_COUNT_ALLOCS
+    loopAllocations = heapAllocations - allocationsBefore;
+    if (loopAllocations > 0) allocatingLoops++;
+    if (loopAllocations > loopAllocationsMax) loopAllocationsMax = loopAllocations;
+#endif
+    if (!logOnOwnTask) {
+        logDrain(hal);
     }
 
-    // === CONTROLE CONTÍNUO DA IRRIGAÇÃO ===
-    if (irrigationActive) {
-        // Se irrigação estiver ativa, verificar continuamente se deve parar
-        controlSmartPump(true); // Verifica condições de parada
-    } else {
-        // === Verificar se deve INICIAR irrigação a cada 30 segundos ===
-        if (isTimeElapsed(lastIrrigationCheck, IRRIGATION_CHECK_INTERVAL)) {
-            // Validar dados críticos antes de tomar decisão
-            if (sensorData.temperatura == -999 || sensorData.umidadeAr == -999) {
-                Serial.println("ERRO CRÍTICO: DHT11 com falha - Pausando irrigação");
-                controlSmartPump(false); // Garantir que está desligada
-                lastIrrigationCheck = currentTime;
-                return;
-            }
-
-            bool shouldStart = shouldIrrigate(sensorData);
-            if (shouldStart) {
-                controlSmartPump(true); // Iniciar irrigação inteligente
-            }
-            lastIrrigationCheck = currentTime;
-            
-            String modeText = thingsboardConnected ? "ONLINE" : "OFFLINE";
-            Serial.println("=== VERIFICAÇÃO DE IRRIGAÇÃO (" + modeText + ") EXECUTADA (1 minuto) ===");
-            Serial.println("Próxima verificação em: " + String(IRRIGATION_CHECK_INTERVAL/1000) + " segundos");
-        }
-    }
-
-    // === Enviar telemetria a cada 5 segundos (apenas se conectado) ===
-    static bool lastIrrigationDecision = irrigationActive; // Usar estado atual
-    if (isTimeElapsed(lastTelemetry, TELEMETRY_INTERVAL)) {
-        lastIrrigationDecision = irrigationActive;
-        sendTelemetry(sensorData, lastIrrigationDecision);
-        lastTelemetry = currentTime;
+    // Nada vence antes disso (ou um comando chega: hal.wake())
+    HalMillis now = hal.millis();
+    HalMillis wait = scheduler.timeUntilNext(now);
+    if (!networkOnOwnCore) {
+        HalMillis networkWait = networkScheduler.timeUntilNext(now);
+        if (networkWait < wait) wait = networkWait;
     }
-
-    // === Gerenciar sistema de tanque SEMPRE (crítico) ===
-    manageTankSystem();
-
-    delay(100); // Pequeno delay para estabilidade
+    hal.idle(wait);
 }
-
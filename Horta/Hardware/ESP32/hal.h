@@ -0,0 +1,123 @@
+/*
+    Camada de abstração de hardware (HAL) do controlador de irrigação
+
+    A lógica de controle do esp32IA.cpp (loop(), manageTankSystem(),
+    controlSmartPump(), shouldIrrigate()) só acessa o hardware por esta
+    interface: relógio (e hora UTC), GPIO, ADC, DHT11, BMP280, Wi-Fi/MQTT
+    e console.
+
+    - hal_esp32.h: Esp32Hal, sobre as bibliotecas do Arduino (firmware)
+    - host/hal_host.h: HostHal, em memória, para compilar e medir o
+      controlador no Linux (host/controller_bench.cpp)
+
+    O sketch usa a referência global `hal`:
+
+        hal.digitalWrite(PUMP_PIN, HAL_LOW);
+        hal.printf("Umidade do solo: %.2f %%\n", umidadeSolo);
+*/
+
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define HAL_LOW 0
+#define HAL_HIGH 1
+#define HAL_PRINTF_BUFFER 320       // Maior linha formatada por printf()
+#define HAL_MQTT_BUFFER 4096        // Maior pacote MQTT (cabeçalho + tópico + payload)
+
+enum HalPinMode {
+    HAL_PIN_INPUT,
+    HAL_PIN_OUTPUT
+};
+
+// Mesma assinatura do callback do PubSubClient
+typedef void (*HalMqttCallback)(char *topic, uint8_t *payload, unsigned int length);
+
+// Tempo do millis(). No ESP32 `unsigned long` tem 32 bits e volta a zero a
+// cada ~49,7 dias; no Linux tem 64 e nunca volta. HAL_MILLIS_32 (definido no
+// host/greenhouse_sim) faz o controlador rodar no host com a mesma aritmética
+// de 32 bits do firmware. Comparações de prazos usam a diferença com sinal:
+// (HalMillisDelta)(a - b) < 0 quando `a` vem antes de `b`.
+#ifdef HAL_MILLIS_32
+typedef uint32_t HalMillis;
+typedef int32_t HalMillisDelta;
+#else
+typedef unsigned long HalMillis;
+typedef long HalMillisDelta;
+#endif
+
+class Hal {
+public:
+    virtual ~Hal() {}
+
+    // ======= RELÓGIO =======
+    virtual HalMillis millis() = 0;
+    virtual void delay(HalMillis ms) = 0;
+    // Nada a fazer por `ms`: a CPU fica ociosa até o próximo prazo do
+    // escalonador (delay() é espera dentro de uma tarefa)
+    virtual void idle(HalMillis ms) = 0;
+    // Interrompe o idle() do laço de controle antes do prazo (comando novo
+    // na fila); pode ser chamado do outro núcleo
+    virtual void wake() = 0;
+    // Hora UTC por NTP, sincronizada em segundo plano quando há Wi-Fi
+    virtual void timeBegin(const char *ntpServer) = 0;
+    // ms desde 1970 (UTC); 0 enquanto o relógio não foi sincronizado
+    virtual unsigned long long epochMs() = 0;
+
+    // ======= GPIO / ADC =======
+    virtual void pinMode(int pin, HalPinMode mode) = 0;
+    virtual int digitalRead(int pin) = 0;
+    virtual void digitalWrite(int pin, int level) = 0;
+    // Amostragem em segundo plano dos pinos analógicos: analogPoll(),
+    // chamado por uma tarefa periódica, é o único ponto que consome as
+    // conversões; analogRead() desses pinos só devolve a mediana dos
+    // últimos quadros, sem amostrar nem bloquear
+    virtual void analogBegin(const int *pins, int count) = 0;
+    virtual void analogPoll() = 0;
+    virtual int analogRead(int pin) = 0;                  // 12 bits (0-4095)
+
+    // ======= DHT11 =======
+    virtual void dhtBegin() = 0;
+    // Avança a leitura em segundo plano; retorna em quantos ms precisa ser
+    // chamado de novo
+    virtual HalMillis dhtPoll() = 0;
+    // Não bloqueia: devolve a última amostra válida e sua idade em ms.
+    // false se nenhuma leitura deu certo ainda.
+    virtual bool dhtRead(float *temperature, float *humidity, HalMillis *ageMs) = 0;
+
+    // ======= BMP280 =======
+    // Inicializa o I2C e procura o sensor em 0x76 e 0x77. Retorna o
+    // endereço encontrado ou 0.
+    virtual int bmpBegin() = 0;
+    virtual void bmpRead(float *pressureHpa, float *altitude) = 0;
+
+    // ======= WI-FI / MQTT =======
+    virtual void wifiBegin(const char *ssid, const char *password) = 0;
+    virtual bool wifiConnected() = 0;
+    virtual const char *wifiAddress() = 0;
+    virtual void mqttBegin(const char *server, uint16_t port, HalMqttCallback callback) = 0;
+    virtual bool mqttConnect(const char *clientId, const char *user) = 0;
+    virtual bool mqttConnected() = 0;
+    virtual int mqttState() = 0;                          // Código de erro do último connect
+    virtual bool mqttSubscribe(const char *topic) = 0;
+    virtual bool mqttPublish(const char *topic, const char *payload) = 0;
+    virtual void mqttLoop() = 0;
+
+    // ======= CONSOLE =======
+    virtual void print(const char *text) = 0;
+
+    void printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        char line[HAL_PRINTF_BUFFER];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        print(line);
+    }
+};
+
+#endif // HAL_H
@@ -0,0 +1,133 @@
+/*
+    HAL do ESP32 (Arduino)
+
+    Implementa hal.h com as mesmas bibliotecas que o sketch usava
+    diretamente (Adafruit_BMP280, WiFi e PubSubClient). O DHT11 é lido
+    pela máquina de estados de dht_async.h e o FC-28/FC-37 pelo ADC
+    contínuo de adc_stream.h, sem bloquear o loop().
+*/
+
+#ifndef HAL_ESP32_H
+#define HAL_ESP32_H
+
+#include <Arduino.h>
+#include <sys/time.h>
+#include <time.h>
+#include <Wire.h>
+#include <Adafruit_BMP280.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include "adc_stream.h"
+#include "dht_async.h"
+#include "hal.h"
+
+#define ESP32_HAL_EPOCH_VALID 1577836800    // 2020-01-01: antes disso o SNTP ainda não respondeu
+
+class Esp32Hal : public Hal {
+public:
+    Esp32Hal(uint8_t dhtPin, uint8_t dhtType, int sdaPin, int sclPin)
+        : dht_(dhtPin, dhtType), mqtt_(wifiClient_), sdaPin_(sdaPin), sclPin_(sclPin) {
+        address_[0] = '\0';
+    }
+
+    // Console serial; chamar antes de qualquer print()
+    void begin(unsigned long baud) { Serial.begin(baud); }
+
+    HalMillis millis() override { return ::millis(); }
+    void delay(HalMillis ms) override { ::delay(ms); }
+    // Bloqueia na notificação da tarefa: a tarefa IDLE do FreeRTOS roda
+    // (light sleep automático, se habilitado no sdkconfig) até o prazo ou
+    // até wake()
+    void idle(HalMillis ms) override {
+        idleTask_ = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+    }
+    void wake() override {
+        TaskHandle_t task = idleTask_;
+        if (task != NULL) xTaskNotifyGive(task);
+    }
+    // SNTP do ESP-IDF: ressincroniza sozinho sempre que o Wi-Fi está de pé
+    void timeBegin(const char *ntpServer) override { configTime(0, 0, ntpServer); }
+    unsigned long long epochMs() override {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        if (now.tv_sec < ESP32_HAL_EPOCH_VALID) return 0;
+        return (unsigned long long)now.tv_sec * 1000ULL + now.tv_usec / 1000;
+    }
+
+    void pinMode(int pin, HalPinMode mode) override { ::pinMode(pin, mode == HAL_PIN_OUTPUT ? OUTPUT : INPUT); }
+    int digitalRead(int pin) override { return ::digitalRead(pin); }
+    void digitalWrite(int pin, int level) override { ::digitalWrite(pin, level == HAL_LOW ? LOW : HIGH); }
+    void analogBegin(const int *pins, int count) override { adc_.begin(pins, count); }
+    void analogPoll() override { adc_.poll(); }
+    int analogRead(int pin) override {
+        int value;
+        if (adc_.read(pin, &value)) return value;  // Mediana do ADC contínuo
+        return ::analogRead(pin);
+    }
+
+    void dhtBegin() override { dht_.begin(); }
+    HalMillis dhtPoll() override { return dht_.poll(); }
+    bool dhtRead(float *temperature, float *humidity, HalMillis *ageMs) override {
+        dht_.poll();
+        return dht_.sample(temperature, humidity, ageMs);
+    }
+
+    int bmpBegin() override {
+        Wire.begin(sdaPin_, sclPin_);
+        ::delay(100); // Aguardar estabilizar
+        int address = 0;
+        if (bmp_.begin(0x76)) {
+            address = 0x76;
+        } else if (bmp_.begin(0x77)) {
+            address = 0x77;
+        } else {
+            return 0;
+        }
+        bmp_.setSampling(Adafruit_BMP280::MODE_NORMAL,
+                         Adafruit_BMP280::SAMPLING_X2,
+                         Adafruit_BMP280::SAMPLING_X16,
+                         Adafruit_BMP280::FILTER_X16,
+                         Adafruit_BMP280::STANDBY_MS_500);
+        ::delay(100); // Aguardar configuração
+        return address;
+    }
+    void bmpRead(float *pressureHpa, float *altitude) override {
+        *pressureHpa = bmp_.readPressure() / 100.0F;
+        *altitude = bmp_.readAltitude(1013.25);
+    }
+
+    void wifiBegin(const char *ssid, const char *password) override { WiFi.begin(ssid, password); }
+    bool wifiConnected() override { return WiFi.status() == WL_CONNECTED; }
+    const char *wifiAddress() override {
+        WiFi.localIP().toString().toCharArray(address_, sizeof(address_));
+        return address_;
+    }
+
+    void mqttBegin(const char *server, uint16_t port, HalMqttCallback callback) override {
+        mqtt_.setServer(server, port);
+        mqtt_.setCallback(callback);
+        mqtt_.setBufferSize(HAL_MQTT_BUFFER);  // Padrão de 256 bytes não comporta a telemetria
+    }
+    bool mqttConnect(const char *clientId, const char *user) override { return mqtt_.connect(clientId, user, NULL); }
+    bool mqttConnected() override { return mqtt_.connected(); }
+    int mqttState() override { return mqtt_.state(); }
+    bool mqttSubscribe(const char *topic) override { return mqtt_.subscribe(topic); }
+    bool mqttPublish(const char *topic, const char *payload) override { return mqtt_.publish(topic, payload); }
+    void mqttLoop() override { mqtt_.loop(); }
+
+    void print(const char *text) override { Serial.print(text); }
+
+private:
+    DhtAsync dht_;
+    TaskHandle_t volatile idleTask_ = NULL;     // Laço de controle (quem chama idle())
+    AdcStream adc_;
+    Adafruit_BMP280 bmp_;
+    WiFiClient wifiClient_;
+    PubSubClient mqtt_;
+    int sdaPin_;
+    int sclPin_;
+    char address_[16];
+};
+
+#endif // HAL_ESP32_H
@@ -0,0 +1,139 @@
+/*
+    Teste de host: o loop() do controlador não aloca no heap
+
+    Compila o esp32IA.cpp com CONTROLLER_COUNT_ALLOCS (alloc_counter.h
+    substitui o malloc da glibc) e roda o loop() por alguns dias simulados,
+    passando por todos os caminhos do controle: bomba ligando e parando,
+    tanque baixo, vazio e enchendo, DHT11 com falha, chuva forte,
+    conexão caindo e voltando, telemetria e comandos RPC na fila.
+
+    Falha (código 1) se algum loop() depois do setup() alocar.
+
+    Uso: controller_alloc_test [horas] [--verbose]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define CONTROLLER_COUNT_ALLOCS
+#include "hal_host.h"
+
+HostHal hostHal;
+Hal& hal = hostHal;
+
+#include "esp32IA.cpp"
+
+// Um núcleo só: o loop() também roda o lado de rede (telemetria, reconexão)
+bool startNetworkCore() { return false; }
+
+#define PHASE_MS (15UL * 60UL * 1000UL)     // Cada fase dura 15 minutos
+
+// Umidade do solo (%) -> leitura do FC-28 (inverso do mapeamento de readAllSensors)
+static int soilReading(float moisture) {
+    return (int)((100.0f - moisture) * 4095.0f / 100.0f);
+}
+
+static void setTank(bool low, bool high) {
+    hostHal.levels[LEVEL_SENSOR1_PIN] = low ? HAL_HIGH : HAL_LOW;
+    hostHal.levels[LEVEL_SENSOR2_PIN] = high ? HAL_HIGH : HAL_LOW;
+}
+
+// Fases do cenário, uma a cada PHASE_MS, em ciclo
+static void updateScenario(unsigned long now) {
+    const unsigned long phase = (now / PHASE_MS) % 8;
+    hostHal.dhtOk = true;
+    hostHal.analog[RAIN_ANALOG_PIN] = 4000;
+    switch (phase) {
+        case 0:     // Solo seco, tanque cheio, online: a bomba liga
+            setTank(true, true);
+            hostHal.analog[SOIL_MOISTURE_PIN] = soilReading(10.0f);
+            hostHal.online = true;
+            break;
+        case 1:     // Solo molhado: a bomba para pela umidade
+            hostHal.analog[SOIL_MOISTURE_PIN] = soilReading(70.0f);
+            break;
+        case 2:     // Tanque baixo: a válvula abre
+            setTank(true, false);
+            hostHal.analog[SOIL_MOISTURE_PIN] = soilReading(10.0f);
+            break;
+        case 3:     // Tanque vazio com o solo seco: irrigação bloqueada
+            setTank(false, false);
+            break;
+        case 4:     // Tanque enche de novo; conexão cai
+            setTank(true, true);
+            hostHal.online = false;
+            break;
+        case 5:     // DHT11 sem resposta, chuva forte
+            hostHal.dhtOk = false;
+            hostHal.analog[RAIN_ANALOG_PIN] = 500;
+            break;
+        case 6:     // Conexão volta; comandos manuais pelo ThingsBoard
+            hostHal.online = true;
+            if (now % PHASE_MS < 1000) {
+                queueCommand(CMD_MANUAL_IRRIGATION, 1.0f);
+                queueCommand(CMD_MIN_HUMIDITY, 40.0f);
+            }
+            break;
+        case 7:     // Parada de emergência e volta ao modo automático
+            if (now % PHASE_MS < 1000) {
+                queueCommand(CMD_EMERGENCY_STOP, 0);
+                queueCommand(CMD_AUTO_MODE, 0);
+                queueCommand(CMD_MIN_HUMIDITY, 30.0f);
+            }
+            hostHal.analog[SOIL_MOISTURE_PIN] = soilReading(50.0f);
+            break;
+    }
+}
+
+int main(int argc, char **argv) {
+    unsigned long hours = 48;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--verbose") == 0) {
+            hostHal.echo = true;
+        } else {
+            hours = std::strtoul(argv[i], NULL, 10);
+        }
+    }
+    if (hours == 0) {
+        std::fprintf(stderr, "Uso: %s [horas] [--verbose]\n", argv[0]);
+        return 1;
+    }
+
+    updateScenario(0);
+    setup();
+
+    const unsigned long start = hostHal.millis();
+    const unsigned long end = start + hours * 3600000UL;
+    unsigned long loops = 0;
+    unsigned long pumpStarts = 0;
+    unsigned long fills = 0;
+    bool pumpWasOn = isPumpOn();
+    bool valveWasOn = isSolenoidOn();
+    unsigned long firstAllocatingLoop = 0;
+    while (hostHal.millis() < end) {
+        updateScenario(hostHal.millis() - start);
+        loop();
+        loops++;
+        if (loopAllocations > 0 && firstAllocatingLoop == 0) firstAllocatingLoop = loops;
+        if (isPumpOn() && !pumpWasOn) pumpStarts++;
+        if (isSolenoidOn() && !valveWasOn) fills++;
+        pumpWasOn = isPumpOn();
+        valveWasOn = isSolenoidOn();
+    }
+
+    std::printf("loop(): %lu chamadas em %lu h simuladas\n", loops, hours);
+    std::printf("Cobertura: %lu partidas da bomba, %lu abastecimentos, %lu publicações MQTT\n", pumpStarts, fills,
+                hostHal.publishes);
+    std::printf("Alocações: %lu loop()s com alocação, máx %lu por loop()\n", allocatingLoops, loopAllocationsMax);
+    if (pumpStarts == 0 || fills == 0 || hostHal.publishes == 0) {
+        std::printf("FALHA: o cenário não passou por todos os caminhos\n");
+        return 1;
+    }
+    if (allocatingLoops > 0) {
+        std::printf("FALHA: o loop() %lu alocou no heap\n", firstAllocatingLoop);
+        return 1;
+    }
+    std::printf("OK: nenhuma alocação no heap depois do setup()\n");
+    return 0;
+}
@@ -0,0 +1,132 @@
+/*
+    Benchmark de host do controlador de irrigação
+
+    Compila o esp32IA.cpp inteiro contra a HostHal (hal_host.h) e mede no
+    Linux o mesmo código que roda no ESP32:
+    - ns por chamada de loop(), com o relógio avançando até o próximo
+      prazo do escalonador a cada iteração (o idle() do fim do loop)
+    - ns por chamada de manageTankSystem(), controlSmartPump() e
+      shouldIrrigate()
+    - bytes impressos no console, leituras de sensores e publicações MQTT
+      por iteração do loop()
+
+    Cenário: tanque cheio, DHT11 e BMP280 respondendo, umidade do solo
+    oscilando entre seco e úmido para a bomba ligar e desligar.
+
+    Uso: controller_bench [iteracoes] [--online] [--verbose]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "hal_host.h"
+
+HostHal hostHal;
+Hal& hal = hostHal;
+
+#include "esp32IA.cpp"
+
+// Um núcleo só: o loop() roda também o lado de rede
+bool startNetworkCore() { return false; }
+
+// Umidade do solo (%) -> leitura do FC-28 (inverso do mapeamento de readAllSensors)
+static int soilReading(float moisture) {
+    return (int)((100.0f - moisture) * 4095.0f / 100.0f);
+}
+
+// Solo com ciclo de 20 minutos: seca até 10% e volta a 70%
+static void updateScenario() {
+    const unsigned long cycleMs = 20UL * 60UL * 1000UL;
+    const float phase = (float)(hostHal.millis() % cycleMs) / cycleMs;
+    const float moisture = 10.0f + 60.0f * fabsf(2.0f * phase - 1.0f);
+    hostHal.analog[SOIL_MOISTURE_PIN] = soilReading(moisture);
+    hostHal.analog[RAIN_ANALOG_PIN] = 4000;
+}
+
+template <typename Function>
+static double nsPerCall(int iterations, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        function();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int main(int argc, char **argv) {
+    int iterations = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--online") == 0) {
+            hostHal.online = true;
+        } else if (std::strcmp(argv[i], "--verbose") == 0) {
+            hostHal.echo = true;
+        } else {
+            iterations = std::atoi(argv[i]);
+        }
+    }
+    if (iterations <= 0) {
+        std::fprintf(stderr, "Uso: %s [iteracoes] [--online] [--verbose]\n", argv[0]);
+        return 1;
+    }
+
+    hostHal.levels[LEVEL_SENSOR1_PIN] = HAL_HIGH;  // Tanque cheio
+    hostHal.levels[LEVEL_SENSOR2_PIN] = HAL_HIGH;
+    updateScenario();
+    setup();
+
+    // ======= LOOP() =======
+    const unsigned long printedBefore = hostHal.printedBytes;
+    const unsigned long readsBefore = hostHal.sensorReads;
+    const unsigned long startMs = hostHal.millis();
+    unsigned long pumpStarts = 0;
+    bool pumpWasOn = isPumpOn();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        updateScenario();
+        loop();
+        if (isPumpOn() && !pumpWasOn) pumpStarts++;
+        pumpWasOn = isPumpOn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    const double loopNs = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+    const double simulatedHours = (hostHal.millis() - startMs) / 3600000.0;
+    const double printedPerLoop = (double)(hostHal.printedBytes - printedBefore) / iterations;
+    const double readsPerLoop = (double)(hostHal.sensorReads - readsBefore) / iterations;
+
+    // ======= FUNÇÕES DE CONTROLE =======
+    hostHal.echo = false;
+    const int calls = iterations / 10 > 0 ? iterations / 10 : 1;
+    const double tankNs = nsPerCall(calls, [] { manageTankSystem(); });
+
+    irrigationActive = false;
+    lastIrrigationEnd = 0;
+    const double pumpNs = nsPerCall(calls, [] {
+        controlSmartPump(true);   // Liga a bomba
+        controlSmartPump(false);  // Interrompe (comando externo)
+        lastIrrigationEnd = 0;
+    }) / 2;
+
+    hostHal.analog[SOIL_MOISTURE_PIN] = soilReading(60.0f);  // Acima do mínimo: decisão da IA
+    const SensorData data = readAllSensors();
+    lastIrrigationEnd = 0;
+    volatile int decisions = 0;
+    const double decisionNs = nsPerCall(calls, [&] { decisions += shouldIrrigate(data); });
+
+    std::printf("\n==================== CONTROLADOR ====================\n");
+    std::printf("Modo:               %s\n", hostHal.online ? "online" : "offline");
+    std::printf("Motor de inferência: %s\n", aiEngine.name());
+    std::printf("Iterações de loop(): %d (%.1f h simuladas)\n", iterations, simulatedHours);
+    std::printf("Acionamentos da bomba: %lu\n", pumpStarts);
+    std::printf("%-20s %10s\n", "Função", "ns/chamada");
+    std::printf("%-20s %10.1f\n", "loop()", loopNs);
+    std::printf("%-20s %10.1f\n", "manageTankSystem()", tankNs);
+    std::printf("%-20s %10.1f\n", "controlSmartPump()", pumpNs);
+    std::printf("%-20s %10.1f\n", "shouldIrrigate()", decisionNs);
+    std::printf("Console:            %.1f bytes/loop()\n", printedPerLoop);
+    std::printf("Leituras de sensor: %.2f por loop()\n", readsPerLoop);
+    std::printf("MQTT:               %lu publicações, %lu bytes\n", hostHal.publishes, hostHal.publishedBytes);
+    std::printf("=====================================================\n");
+    return 0;
+}
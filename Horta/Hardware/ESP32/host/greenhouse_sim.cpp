@@ -0,0 +1,203 @@
+/*
+    Simulação de meses de operação da estufa em tempo virtual
+
+    Roda o esp32IA.cpp (setup() + loop()) sobre a SimHal, com o relógio
+    virtual e os modelos de solo, bomba, tanque e chuva de
+    greenhouse_sim.h. Os delay() do firmware avançam o relógio em vez de
+    bloquear, e o idle() do fim do loop() salta direto para o próximo
+    prazo do escalonador. O lado de rede roda no segundo núcleo emulado
+    pela SimHal; --single-core o põe de volta no mesmo loop() (como num
+    ESP32-S2/C3).
+
+    Reporta água usada, acionamentos da bomba, latência entre o solo
+    cruzar a umidade mínima e a bomba ligar, tempo bloqueado em delay(),
+    tempo ocioso, o atraso de cada tarefa em relação ao prazo e o custo de
+    host por loop().
+
+    Compilado com HAL_MILLIS_32 (CMakeLists.txt): o controlador vê um
+    millis() de 32 bits como o do ESP32, que estoura em ~49,7 dias; com
+    mais de 50 dias a simulação passa pelo estouro.
+
+    Uso: greenhouse_sim [dias] [--seed N] [--adc-noise N] [--raw-adc] [--online] [--single-core] [--verbose]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "greenhouse_sim.h"
+
+SimHal simHal;
+Hal& hal = simHal;
+bool singleCore = false;
+
+#include "esp32IA.cpp"
+
+bool startNetworkCore() {
+    if (singleCore) return false;
+    simHal.networkStep = networkLoopOnce;
+    return true;
+}
+
+GreenhouseModel model;
+
+// Estatísticas coletadas a cada avanço do relógio
+struct SimStats {
+    unsigned long pumpStarts = 0;
+    unsigned long aiStarts = 0;             // Partidas com o solo acima do mínimo
+    unsigned long pumpMs = 0;
+    unsigned long valveMs = 0;
+    unsigned long belowMinMs = 0;           // Solo abaixo de minSoilHumidity
+    unsigned long belowSince = 0;           // Início do déficit atual (0 = sem déficit)
+    unsigned long latencies = 0;
+    double latencySumMs = 0;
+    unsigned long latencyMaxMs = 0;
+    float minSoil = 100.0f;
+    float maxSoil = 0.0f;
+    bool pumpWasOn = false;
+};
+
+SimStats stats;
+
+// Saídas do modelo nos pinos e no DHT11 (leituras inteiras, como o sensor real)
+static void publishSensors() {
+    simHal.levels[LEVEL_SENSOR1_PIN] = model.lowSensor() ? HAL_HIGH : HAL_LOW;
+    simHal.levels[LEVEL_SENSOR2_PIN] = model.highSensor() ? HAL_HIGH : HAL_LOW;
+    simHal.analog[SOIL_MOISTURE_PIN] = model.soilReading();
+    simHal.analog[RAIN_ANALOG_PIN] = model.rainReading();
+    simHal.temperature = roundf(model.temperature);
+    simHal.humidity = roundf(model.humidity);
+}
+
+// Estado da bomba e da válvula vale para todo o intervalo [from, to)
+static void onAdvance(unsigned long from, unsigned long to) {
+    const bool pumpOn = isPumpOn();
+    const bool valveOn = isSolenoidOn();
+    if (pumpOn && !stats.pumpWasOn) {
+        stats.pumpStarts++;
+        if (stats.belowSince != 0) {
+            unsigned long latency = from - stats.belowSince;
+            stats.latencies++;
+            stats.latencySumMs += latency;
+            if (latency > stats.latencyMaxMs) stats.latencyMaxMs = latency;
+        } else {
+            stats.aiStarts++;
+        }
+    }
+    stats.pumpWasOn = pumpOn;
+    model.advance(from, to, pumpOn, valveOn);
+
+    const unsigned long elapsed = to - from;
+    if (pumpOn) stats.pumpMs += elapsed;
+    if (valveOn) stats.valveMs += elapsed;
+    if (model.soil < minSoilHumidity) {
+        stats.belowMinMs += elapsed;
+        if (stats.belowSince == 0) stats.belowSince = to;
+    } else {
+        stats.belowSince = 0;
+    }
+    if (model.soil < stats.minSoil) stats.minSoil = model.soil;
+    if (model.soil > stats.maxSoil) stats.maxSoil = model.soil;
+    publishSensors();
+}
+
+static void printTaskTable(const char *title, const TaskScheduler &tasks) {
+    std::printf("\n-- %s (atraso em relação ao prazo) --\n", title);
+    std::printf("%-12s %10s %10s %10s %10s\n", "Tarefa", "Execuções", "Médio ms", "Máx ms", "Perdidos");
+    for (int i = 0; i < tasks.count(); i++) {
+        const SchedTask &task = tasks.task(i);
+        std::printf("%-12s %10lu %10.2f %10lu %10lu\n", task.name, task.runs,
+                    task.runs ? (double)task.lateSumMs / task.runs : 0.0, task.lateMaxMs, task.overruns);
+    }
+}
+
+int main(int argc, char **argv) {
+    int days = 90;
+    GreenhouseParams params;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--online") == 0) {
+            simHal.online = true;
+        } else if (std::strcmp(argv[i], "--single-core") == 0) {
+            singleCore = true;
+        } else if (std::strcmp(argv[i], "--verbose") == 0) {
+            simHal.echo = true;
+        } else if (std::strcmp(argv[i], "--adc-noise") == 0 && i + 1 < argc) {
+            simHal.adcNoise = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--raw-adc") == 0) {
+            simHal.adcFilter = false;
+        } else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            params.seed = (uint32_t)std::strtoul(argv[++i], NULL, 10);
+        } else {
+            days = std::atoi(argv[i]);
+        }
+    }
+    if (days <= 0) {
+        std::fprintf(stderr, "Uso: %s [dias] [--seed N] [--adc-noise N] [--raw-adc] [--online] [--single-core] [--verbose]\n", argv[0]);
+        return 1;
+    }
+
+    model = GreenhouseModel(params);
+    simHal.onAdvance = onAdvance;
+    simHal.levels[PUMP_PIN] = HAL_HIGH;       // Relés desligados (LOW level)
+    simHal.levels[SOLENOIDE_PIN] = HAL_HIGH;
+    publishSensors();
+
+    auto start = std::chrono::steady_clock::now();
+    setup();
+    const unsigned long end = (unsigned long)days * SIM_MS_PER_DAY;
+    unsigned long loops = 0;
+    while (simHal.now < end) {
+        loop();
+        loops++;
+    }
+    auto finish = std::chrono::steady_clock::now();
+    const double wallSeconds = std::chrono::duration<double>(finish - start).count();
+
+    const double simDays = simHal.now / (double)SIM_MS_PER_DAY;
+    std::printf("\n==================== SIMULAÇÃO ====================\n");
+    std::printf("Período:            %.1f dias (semente %u, %s, %s)\n", simDays, params.seed,
+                simHal.online ? "online" : "offline", networkOnOwnCore ? "rede no outro núcleo" : "um núcleo");
+    std::printf("Motor de inferência: %s\n", aiEngine.name());
+    std::printf("Chamadas de loop(): %lu (%.1f ns cada, %.2f s de host)\n", loops, wallSeconds * 1e9 / loops, wallSeconds);
+    std::printf("Aceleração:         %.0fx o tempo real\n", simHal.now / 1000.0 / wallSeconds);
+    const unsigned long long millisWrap = (unsigned long long)(HalMillis)-1 + 1;
+    std::printf("millis():           %u bits, %s\n", (unsigned)sizeof(HalMillis) * 8,
+                simHal.now >= millisWrap ? "estourou durante a simulação" : "sem estouro nesta simulação");
+    std::printf("\n-- Água --\n");
+    std::printf("Irrigação:          %.1f L (%.2f L/dia)\n", model.pumpLiters, model.pumpLiters / simDays);
+    std::printf("Rede -> tanque:     %.1f L (válvula aberta %.1f min)\n", model.mainsLiters, stats.valveMs / 60000.0);
+    std::printf("Chuva:              %.1f h\n", model.rainHours);
+    std::printf("Tanque no fim:      %.1f L\n", model.tank);
+    std::printf("Bomba a seco:       %.1f s\n", model.dryPumpMs / 1000.0);
+    std::printf("\n-- Bomba --\n");
+    std::printf("Acionamentos:       %lu (%.2f/dia, %lu pela IA com o solo acima do mínimo)\n", stats.pumpStarts,
+                stats.pumpStarts / simDays, stats.aiStarts);
+    std::printf("Tempo ligada:       %.1f min (%.1f s por acionamento)\n", stats.pumpMs / 60000.0,
+                stats.pumpStarts ? stats.pumpMs / 1000.0 / stats.pumpStarts : 0.0);
+    std::printf("\n-- Solo --\n");
+    std::printf("Umidade:            mín %.1f%%, máx %.1f%% (mínimo configurado %.1f%%)\n", stats.minSoil,
+                stats.maxSoil, minSoilHumidity);
+    std::printf("Abaixo do mínimo:   %.1f h (%.2f%% do tempo)\n", stats.belowMinMs / 3600000.0,
+                100.0 * stats.belowMinMs / simHal.now);
+    std::printf("Latência da decisão: média %.1f s, máx %.1f s (%lu déficits atendidos)\n",
+                stats.latencies ? stats.latencySumMs / stats.latencies / 1000.0 : 0.0, stats.latencyMaxMs / 1000.0,
+                stats.latencies);
+    std::printf("\n-- Controlador --\n");
+    std::printf("Bloqueado em delay(): %.1f h (%.2f%% do tempo)\n", simHal.blockedMs / 3600000.0,
+                100.0 * simHal.blockedMs / simHal.now);
+    std::printf("Ocioso em idle():   %.1f h (%.2f%% do tempo, %.1f despertares/min)\n", simHal.idleMs / 3600000.0,
+                100.0 * simHal.idleMs / simHal.now, simHal.wakeups / (simHal.now / 60000.0));
+    if (networkOnOwnCore) {
+        std::printf("Rede em delay():    %.1f h (%.2f%% do tempo, no outro núcleo)\n",
+                    simHal.networkBlockedMs / 3600000.0, 100.0 * simHal.networkBlockedMs / simHal.now);
+    }
+    std::printf("Filas:              %lu quadros de telemetria descartados, %lu comandos recusados\n",
+                telemetryDropped, commandsRejected);
+    std::printf("Console:            %.1f MB\n", simHal.printedBytes / 1e6);
+    std::printf("MQTT:               %lu publicações, %.1f MB\n", simHal.publishes, simHal.publishedBytes / 1e6);
+    printTaskTable("Núcleo de controle", scheduler);
+    printTaskTable("Núcleo de rede", networkScheduler);
+    std::printf("===================================================\n");
+    return 0;
+}
@@ -0,0 +1,246 @@
+/*
+    Simulador de estufa em tempo virtual
+
+    GreenhouseModel: modelos físicos simples e determinísticos
+    - clima: temperatura com ciclo diário e variação entre dias, umidade
+      do ar inversa à temperatura, chuvas sorteadas por um gerador com
+      semente fixa
+    - solo: secagem proporcional à evapotranspiração, ganho com a bomba e
+      com a chuva, drenagem acima da capacidade de campo
+    - tanque: saída pela bomba, entrada pela válvula (rede), sensores de
+      nível baixo/alto por limiar de volume
+
+    SimHal: HostHal com relógio virtual. delay() não dorme: avança o
+    relógio e o modelo; idle() salta até o próximo prazo do loop().
+    Com `networkStep` ligado, emula o segundo núcleo do ESP32: o laço de
+    rede tem relógio próprio (`networkNow`), seus delay() não param o
+    controle e seus passos acontecem durante o idle() do controle, que
+    acorda mais cedo se a rede chamar wake().
+
+    Mesma semente e mesmos parâmetros = mesma simulação, bit a bit.
+*/
+
+#ifndef GREENHOUSE_SIM_H
+#define GREENHOUSE_SIM_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "hal_host.h"
+
+#define SIM_MS_PER_HOUR 3600000UL
+#define SIM_MS_PER_DAY (24UL * SIM_MS_PER_HOUR)
+#define SIM_MAX_STEP_MS 1000UL      // Maior passo de integração do modelo
+
+struct GreenhouseParams {
+    uint32_t seed = 42;
+
+    // Clima
+    float meanTemperature = 25.0f;  // °C
+    float dailyAmplitude = 6.0f;    // °C (pico às 15h)
+    float dayVariation = 3.0f;      // °C de variação entre dias
+    float rainProbability = 0.25f;  // Chance de chuva por dia
+    float rainRate = 4.0f;          // Umidade do solo (%) ganha por hora de chuva
+
+    // Solo
+    float initialSoil = 60.0f;      // %
+    float dryingRate = 0.6f;        // %/h a 25 °C e 60% de umidade do ar
+    float fieldCapacity = 80.0f;    // % - acima disso o solo drena
+    float drainRate = 5.0f;         // %/h acima da capacidade de campo
+    float soilPerLiter = 4.0f;      // % de umidade por litro irrigado
+
+    // Tanque e hidráulica
+    float tankCapacity = 100.0f;    // L
+    float initialTank = 80.0f;      // L
+    float lowSensorLiters = 20.0f;  // Sensor de nível baixo
+    float highSensorLiters = 90.0f; // Sensor de nível alto
+    float pumpFlow = 2.0f;          // L/min
+    float mainsFlow = 40.0f;        // L/min pela válvula
+};
+
+class GreenhouseModel {
+public:
+    // ======= ESTADO =======
+    float soil;                     // %
+    float tank;                     // L
+    float temperature;              // °C
+    float humidity;                 // %
+    bool raining = false;
+
+    // ======= TOTAIS =======
+    double pumpLiters = 0;          // Água levada ao solo
+    double mainsLiters = 0;         // Água da rede para o tanque
+    double rainHours = 0;
+    unsigned long dryPumpMs = 0;    // Bomba ligada com tanque vazio
+
+    explicit GreenhouseModel(const GreenhouseParams &params = GreenhouseParams())
+        : soil(params.initialSoil), tank(params.initialTank), p_(params), rng_(params.seed ? params.seed : 1) {
+        planDay(0);
+        updateWeather(0);
+    }
+
+    // Avança o modelo de `from` até `to` (ms) com os atuadores fixos
+    void advance(unsigned long from, unsigned long to, bool pumpOn, bool valveOn) {
+        while (from < to) {
+            unsigned long step = to - from < SIM_MAX_STEP_MS ? to - from : SIM_MAX_STEP_MS;
+            integrate(from, step, pumpOn, valveOn);
+            from += step;
+        }
+        updateWeather(to);
+    }
+
+    bool lowSensor() const { return tank >= p_.lowSensorLiters; }
+    bool highSensor() const { return tank >= p_.highSensorLiters; }
+    // Leituras de 12 bits: FC-28 (0 = encharcado) e FC-37 (4095 = seco)
+    int soilReading() const { return (int)lrintf((100.0f - soil) * 4095.0f / 100.0f); }
+    int rainReading() const { return raining ? 1200 : 4000; }
+
+private:
+    void integrate(unsigned long now, unsigned long stepMs, bool pumpOn, bool valveOn) {
+        const float hours = stepMs / (float)SIM_MS_PER_HOUR;
+        const float minutes = stepMs / 60000.0f;
+        updateWeather(now);
+
+        // Evapotranspiração: cresce com a temperatura e com o ar seco
+        float et = p_.dryingRate * (1.0f + 0.05f * (temperature - 25.0f)) * ((100.0f - humidity) / 40.0f);
+        if (et < 0) et = 0;
+        soil -= et * hours;
+        if (raining) {
+            soil += p_.rainRate * hours;
+            rainHours += hours;
+        }
+        if (soil > p_.fieldCapacity) soil -= p_.drainRate * hours;
+
+        if (pumpOn) {
+            float liters = p_.pumpFlow * minutes;
+            if (liters > tank) {
+                dryPumpMs += stepMs;
+                liters = tank;
+            }
+            tank -= liters;
+            pumpLiters += liters;
+            soil += liters * p_.soilPerLiter;
+        }
+        if (valveOn) {
+            float liters = p_.mainsFlow * minutes;
+            if (tank + liters > p_.tankCapacity) liters = p_.tankCapacity - tank;  // Transborda
+            tank += liters;
+            mainsLiters += liters;
+        }
+
+        if (soil < 0) soil = 0;
+        if (soil > 100) soil = 100;
+    }
+
+    void updateWeather(unsigned long now) {
+        unsigned long day = now / SIM_MS_PER_DAY;
+        if (day != day_) planDay(day);
+        float hour = (now % SIM_MS_PER_DAY) / (float)SIM_MS_PER_HOUR;
+        temperature = p_.meanTemperature + dayOffset_ + p_.dailyAmplitude * sinf(2.0f * (float)M_PI * (hour - 9.0f) / 24.0f);
+        raining = now >= rainStart_ && now < rainEnd_;
+        humidity = raining ? 92.0f : 95.0f - 2.0f * (temperature - 15.0f);
+        if (humidity < 25.0f) humidity = 25.0f;
+        if (humidity > 95.0f) humidity = 95.0f;
+    }
+
+    // Sorteia o clima do dia: desvio de temperatura e uma chuva opcional
+    void planDay(unsigned long day) {
+        day_ = day;
+        dayOffset_ = (uniform() * 2.0f - 1.0f) * p_.dayVariation;
+        rainStart_ = rainEnd_ = 0;
+        if (uniform() < p_.rainProbability) {
+            unsigned long start = day * SIM_MS_PER_DAY + (unsigned long)(uniform() * 20.0f * SIM_MS_PER_HOUR);
+            rainStart_ = start;
+            rainEnd_ = start + (unsigned long)((1.0f + uniform() * 4.0f) * SIM_MS_PER_HOUR);
+        }
+    }
+
+    // xorshift32: determinístico e igual em qualquer plataforma
+    float uniform() {
+        rng_ ^= rng_ << 13;
+        rng_ ^= rng_ >> 17;
+        rng_ ^= rng_ << 5;
+        return (rng_ >> 8) / 16777216.0f;
+    }
+
+    GreenhouseParams p_;
+    uint32_t rng_;
+    unsigned long day_ = (unsigned long)-1;
+    float dayOffset_ = 0;
+    unsigned long rainStart_ = 0;
+    unsigned long rainEnd_ = 0;
+};
+
+class SimHal : public HostHal {
+public:
+    // Chamado a cada avanço do relógio: atualiza o modelo e os pinos
+    void (*onAdvance)(unsigned long from, unsigned long to) = nullptr;
+    // Segundo núcleo: um passo do laço de rede, que devolve a espera em ms
+    HalMillis (*networkStep)() = nullptr;
+
+    unsigned long now = 0;              // Relógio do controle (e do modelo)
+    unsigned long networkNow = 0;       // Relógio do núcleo de rede
+    unsigned long blockedMs = 0;        // Tempo parado em delay() >= 1 s (conexões, setup)
+    unsigned long networkBlockedMs = 0; // O mesmo, no núcleo de rede
+    unsigned long wakeups = 0;          // Chamadas de idle(): o loop() acordou e voltou a dormir
+    unsigned long earlyWakeups = 0;     // idle() interrompido por wake()
+
+    // O controlador vê o relógio em HalMillis (32 bits com HAL_MILLIS_32,
+    // como no ESP32); o simulador conta em 64 bits e não volta a zero
+    HalMillis millis() override { return (HalMillis)(onNetwork_ ? networkNow : now); }
+    unsigned long long epochMs() override { return clockSynced ? epochStartMs + (onNetwork_ ? networkNow : now) : 0; }
+    void delay(HalMillis ms) override {
+        if (onNetwork_) {
+            if (ms >= 1000) networkBlockedMs += ms;
+            networkNow += ms;
+            return;
+        }
+        if (ms >= 1000) blockedMs += ms;
+        delayedMs += ms;
+        advanceTo(now + ms);
+    }
+
+    // Ocioso até o próximo prazo do escalonador: o relógio salta direto,
+    // parando nos passos do núcleo de rede que vencem antes
+    void idle(HalMillis ms) override {
+        wakeups++;
+        const unsigned long start = now;
+        unsigned long target = now + ms;
+        woken_ = false;
+        if (networkStep && (long)(networkNow - now) < 0) networkNow = now;
+        while (networkStep && (long)(networkNow - target) < 0 && !woken_) {
+            advanceTo(networkNow);
+            onNetwork_ = true;
+            unsigned long wait = networkStep();
+            onNetwork_ = false;
+            networkNow += wait > 0 ? wait : 1;
+        }
+        if (woken_ && (long)(wokenAt_ - target) < 0) {
+            earlyWakeups++;
+            target = (long)(wokenAt_ - now) > 0 ? wokenAt_ : now;
+        }
+        HostHal::idle(target - start);
+        advanceTo(target);
+    }
+
+    void wake() override {
+        if (onNetwork_ && !woken_) {
+            woken_ = true;
+            wokenAt_ = networkNow;
+        }
+    }
+
+    // Salto do simulador entre chamadas de loop() (não conta como delay)
+    void advanceTo(unsigned long target) {
+        if (target <= now) return;
+        if (onAdvance) onAdvance(now, target);
+        now = target;
+    }
+
+private:
+    bool onNetwork_ = false;
+    bool woken_ = false;
+    unsigned long wokenAt_ = 0;
+};
+
+#endif // GREENHOUSE_SIM_H
@@ -0,0 +1,169 @@
+/*
+    HAL de host (Linux) do controlador de irrigação
+
+    Implementa hal.h em memória para compilar o esp32IA.cpp fora do ESP32:
+    - pinos e ADC são arrays que o programa de host lê e escreve; com
+      `adcNoise` o ADC soma ruído (e picos) e os pinos de analogBegin()
+      passam pela mesma sobreamostragem + mediana do ESP32: cada
+      analogPoll() é um quadro, e analogRead() só lê a mediana
+    - DHT11 e BMP280 devolvem os valores dos campos públicos
+    - Wi-Fi/MQTT ficam conectados ou não conforme `online`; as publicações
+      só são contadas (e recusadas acima de HAL_MQTT_BUFFER, como no
+      PubSubClient)
+    - a hora UTC é `epochStartMs` + millis(); com `clockSynced` falso,
+      epochMs() devolve 0 (NTP sem resposta)
+    - millis() é o tempo real desde a criação mais o total pedido em
+      delay() e em idle(), que não dormem: o loop() roda sem as pausas do
+      firmware
+    - print() descarta o texto (ou escreve em stdout com `echo`) e conta os
+      bytes, que no ESP32 iriam para a UART
+*/
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "adc_filter.h"
+#include "hal.h"
+
+#define HOST_HAL_PINS 40
+#define HOST_HAL_OVERSAMPLE 8       // Conversões somadas por leitura filtrada
+
+class HostHal : public Hal {
+public:
+    // ======= ESTADO SIMULADO =======
+    int levels[HOST_HAL_PINS] = {0};
+    int analog[HOST_HAL_PINS] = {0};
+    float temperature = 25.0f;
+    float humidity = 60.0f;
+    bool dhtOk = true;
+    HalMillis dhtAge = 0;               // Idade da amostra devolvida por dhtRead()
+    bool bmpPresent = true;
+    float pressure = 1013.25f;
+    float altitude = 0.0f;
+    int adcNoise = 0;                   // Amplitude do ruído do ADC (contagens)
+    bool adcFilter = true;              // false: analogBegin() não filtra (leitura única)
+    bool online = false;
+    bool echo = false;
+    bool clockSynced = true;
+    unsigned long long epochStartMs = 1767225600000ULL;  // 2026-01-01 00:00 UTC
+
+    // ======= CONTADORES =======
+    unsigned long delayedMs = 0;
+    unsigned long idleMs = 0;           // Parte de delayedMs ociosa (idle())
+    unsigned long publishes = 0;
+    unsigned long publishedBytes = 0;
+    unsigned long printedBytes = 0;
+    unsigned long sensorReads = 0;      // Leituras de DHT11, ADC e BMP280
+
+    HostHal() : start_(std::chrono::steady_clock::now()) {}
+
+    HalMillis millis() override {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        return (HalMillis)(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() + delayedMs);
+    }
+    void delay(HalMillis ms) override { delayedMs += ms; }
+    void idle(HalMillis ms) override {
+        idleMs += ms;
+        delayedMs += ms;
+    }
+    void wake() override {}
+    void timeBegin(const char *) override {}
+    unsigned long long epochMs() override { return clockSynced ? epochStartMs + millis() : 0; }
+
+    void pinMode(int, HalPinMode) override {}
+    int digitalRead(int pin) override { return validPin(pin) ? levels[pin] : HAL_LOW; }
+    void digitalWrite(int pin, int level) override {
+        if (validPin(pin)) levels[pin] = level;
+    }
+    void analogBegin(const int *pins, int count) override {
+        for (int i = 0; i < count; i++) {
+            if (validPin(pins[i])) filtered_[pins[i]] = adcFilter;
+        }
+    }
+    void analogPoll() override {
+        for (int pin = 0; pin < HOST_HAL_PINS; pin++) {
+            if (filtered_[pin]) pushFrame(pin);
+        }
+    }
+    int analogRead(int pin) override {
+        sensorReads++;
+        if (!validPin(pin)) return 0;
+        if (!filtered_[pin]) return noisyRead(pin);
+        if (filters_[pin].empty()) pushFrame(pin);  // Nenhum quadro ainda (antes da primeira tarefa)
+        return filters_[pin].median();
+    }
+
+    void dhtBegin() override {}
+    HalMillis dhtPoll() override { return 2000; }   // Sem transação: o intervalo do DHT11
+    bool dhtRead(float *t, float *h, HalMillis *ageMs) override {
+        sensorReads++;
+        if (!dhtOk) return false;
+        *t = temperature;
+        *h = humidity;
+        *ageMs = dhtAge;
+        return true;
+    }
+
+    int bmpBegin() override { return bmpPresent ? 0x76 : 0; }
+    void bmpRead(float *p, float *a) override {
+        sensorReads++;
+        *p = pressure;
+        *a = altitude;
+    }
+
+    void wifiBegin(const char *, const char *) override {}
+    bool wifiConnected() override { return online; }
+    const char *wifiAddress() override { return "127.0.0.1"; }
+    void mqttBegin(const char *, uint16_t, HalMqttCallback) override {}
+    bool mqttConnect(const char *, const char *) override { return online; }
+    bool mqttConnected() override { return online; }
+    int mqttState() override { return online ? 0 : -2; }  // -2 = MQTT_CONNECT_FAILED
+    bool mqttSubscribe(const char *) override { return online; }
+    bool mqttPublish(const char *topic, const char *payload) override {
+        if (!online || 5 + 2 + strlen(topic) + strlen(payload) > HAL_MQTT_BUFFER) return false;
+        publishes++;
+        publishedBytes += strlen(payload);
+        return true;
+    }
+    void mqttLoop() override {}
+
+    void print(const char *text) override {
+        printedBytes += strlen(text);
+        if (echo) fputs(text, stdout);
+    }
+
+private:
+    static bool validPin(int pin) { return pin >= 0 && pin < HOST_HAL_PINS; }
+
+    // Um quadro do ADC contínuo: média de HOST_HAL_OVERSAMPLE conversões
+    void pushFrame(int pin) {
+        long sum = 0;
+        for (int i = 0; i < HOST_HAL_OVERSAMPLE; i++) sum += noisyRead(pin);
+        filters_[pin].push((int)(sum / HOST_HAL_OVERSAMPLE));
+    }
+
+    // Ruído uniforme de ±adcNoise e, em 2% das conversões, um pico de 8x
+    int noisyRead(int pin) {
+        if (adcNoise == 0) return analog[pin];
+        noise_ ^= noise_ << 13;
+        noise_ ^= noise_ >> 17;
+        noise_ ^= noise_ << 5;
+        int offset = (int)(noise_ % (2 * adcNoise + 1)) - adcNoise;
+        if ((noise_ >> 24) % 50 == 0) offset *= 8;
+        int value = analog[pin] + offset;
+        return value < 0 ? 0 : (value > 4095 ? 4095 : value);
+    }
+
+    bool filtered_[HOST_HAL_PINS] = {false};
+    AdcFilter filters_[HOST_HAL_PINS];
+    uint32_t noise_ = 2463534242u;
+
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif // HAL_HOST_H
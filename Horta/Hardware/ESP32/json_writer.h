@@ -0,0 +1,143 @@
+/*
+    Escrita de JSON em buffer fixo
+
+    Monta os objetos planos da telemetria sem alocar memória e sem
+    depender do ArduinoJson, para o controlador compilar também no host:
+
+        char payload[512];
+        JsonWriter json(payload, sizeof(payload));
+        json.beginObject();
+        json.field("temperature", 25.5f);
+        json.field("irrigating", true);
+        json.endObject();
+        if (json.ok()) publish(payload);
+
+    Floats saem com até 7 dígitos significativos (como o ArduinoJson);
+    NaN e infinitos saem como null. Se o buffer não comportar o objeto,
+    ok() fica falso e o texto é truncado.
+*/
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+
+class JsonWriter {
+public:
+    JsonWriter(char *buffer, size_t size) : buffer_(buffer), size_(size), length_(0), first_(true), ok_(size > 0) {
+        if (size_ > 0) buffer_[0] = '\0';
+    }
+
+    void beginObject() {
+        separator();
+        append("{");
+        first_ = true;
+    }
+    void endObject() {
+        append("}");
+        first_ = false;
+    }
+    void beginArray() {
+        separator();
+        append("[");
+        first_ = true;
+    }
+    void endArray() {
+        append("]");
+        first_ = false;
+    }
+
+    // Chave de um objeto ou array aninhado: key("values"); beginObject();
+    void key(const char *name) {
+        separator();
+        appendf("\"%s\":", name);
+        first_ = true;  // O valor que vem a seguir não leva vírgula
+    }
+
+    void field(const char *name, float value) {
+        key(name);
+        first_ = false;
+        if (isfinite(value)) {
+            appendf("%.7g", (double)value);
+        } else {
+            append("null");
+        }
+    }
+    void field(const char *name, int value) {
+        key(name);
+        first_ = false;
+        appendf("%d", value);
+    }
+    void field(const char *name, unsigned long value) {
+        key(name);
+        first_ = false;
+        appendf("%lu", value);
+    }
+    void field(const char *name, unsigned long long value) {
+        key(name);
+        first_ = false;
+        appendf("%llu", value);
+    }
+    void field(const char *name, bool value) {
+        key(name);
+        first_ = false;
+        append(value ? "true" : "false");
+    }
+    // Texto sem aspas nem barras (rótulos fixos do firmware)
+    void field(const char *name, const char *value) {
+        key(name);
+        first_ = false;
+        appendf("\"%s\"", value);
+    }
+
+    // Ponto para desfazer um trecho já escrito (ex.: amostra sem nenhuma chave)
+    struct Mark {
+        size_t length;
+        bool first;
+        bool ok;
+    };
+    Mark mark() const { return Mark{length_, first_, ok_}; }
+    void rewind(const Mark &mark) {
+        length_ = mark.length;
+        first_ = mark.first;
+        ok_ = mark.ok;
+        if (size_ > 0) buffer_[length_] = '\0';
+    }
+
+    bool ok() const { return ok_; }
+    size_t length() const { return length_; }
+    const char *c_str() const { return buffer_; }
+
+private:
+    void separator() {
+        if (!first_) append(",");
+        first_ = false;
+    }
+
+    void append(const char *text) { appendf("%s", text); }
+
+    void appendf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+        if (!ok_) return;
+        va_list args;
+        va_start(args, format);
+        int written = vsnprintf(buffer_ + length_, size_ - length_, format, args);
+        va_end(args);
+        if (written < 0 || (size_t)written >= size_ - length_) {
+            ok_ = false;
+            length_ = size_ - 1;
+            return;
+        }
+        length_ += (size_t)written;
+    }
+
+    char *buffer_;
+    size_t size_;
+    size_t length_;
+    bool first_;
+    bool ok_;
+};
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,62 @@
+/*
+    Fila circular sem trava para um produtor e um consumidor (SPSC)
+
+    Liga os dois núcleos do ESP32 sem mutex: só o produtor escreve `head_`
+    e só o consumidor escreve `tail_`, cada índice publicado com
+    release/acquire. Nenhum lado espera pelo outro; com a fila cheia
+    push() devolve false e o produtor decide o que fazer (descartar,
+    recusar o comando):
+
+        SpscRing<TelemetryFrame, 4> telemetryQueue;
+        telemetryQueue.push(frame);      // núcleo de controle
+        ...
+        TelemetryFrame frame;
+        while (telemetryQueue.pop(&frame)) publish(frame);   // núcleo de rede
+
+    Capacidade fixa (potência de 2), sem alocação. Os índices crescem sem
+    parar e só são reduzidos módulo N no acesso; o estouro do unsigned
+    não muda head_ - tail_.
+*/
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+
+template <typename T, unsigned N>
+class SpscRing {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "Capacidade deve ser potência de 2");
+
+public:
+    // Produtor: false se a fila está cheia (o item não entra)
+    bool push(const T &item) {
+        const unsigned head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N) return false;
+        items_[head % N] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumidor: false se a fila está vazia
+    bool pop(T *item) {
+        const unsigned tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        *item = items_[tail % N];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Aproximado quando lido do outro lado
+    unsigned size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr unsigned capacity() { return N; }
+
+private:
+    T items_[N];
+    std::atomic<unsigned> head_{0};
+    std::atomic<unsigned> tail_{0};
+};
+
+#endif // SPSC_RING_H
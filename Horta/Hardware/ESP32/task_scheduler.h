@@ -0,0 +1,187 @@
+/*
+    Escalonador cooperativo por prazo (min-heap)
+
+    Substitui o loop() que girava a cada 100 ms testando isTimeElapsed():
+    cada tarefa tem um prazo, o heap mantém a mais próxima no topo e o
+    loop() só acorda quando ela vence:
+
+        TaskScheduler scheduler;
+        int tank = scheduler.addPeriodic("tank", manageTank, 10000, 0);
+        scheduler.addOneShot("hello", sayHello, 500);
+        ...
+        scheduler.runDue(hal.millis());
+        hal.idle(scheduler.timeUntilNext(hal.millis()));  // CPU ociosa até o próximo prazo
+
+    Tarefas periódicas são reagendadas a partir do prazo (prazo + período),
+    não do instante em que rodaram, então o atraso de uma execução não se
+    acumula. Se uma tarefa perde períodos inteiros, eles são pulados e
+    contados em `overruns`. `lateMs` é o atraso de cada execução em relação
+    ao prazo (jitter).
+
+    Capacidade fixa (SCHED_MAX_TASKS), sem alocação. As comparações de
+    tempo usam diferença com sinal e sobrevivem ao estouro do millis()
+    (coberto no host pelo greenhouse_sim, que roda com HAL_MILLIS_32).
+*/
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include "hal.h"                // HalMillis
+
+#define SCHED_MAX_TASKS 10
+
+typedef void (*SchedTaskFn)();
+
+struct SchedTask {
+    const char *name;
+    SchedTaskFn fn;
+    HalMillis period;       // 0 = execução única
+    HalMillis deadline;
+    bool active;
+
+    // ======= ESTATÍSTICAS =======
+    unsigned long runs;
+    unsigned long overruns;     // Períodos perdidos
+    unsigned long lateSumMs;
+    unsigned long lateMaxMs;
+};
+
+class TaskScheduler {
+public:
+    // Tarefa periódica; a primeira execução vence em `now + firstDelay`
+    int addPeriodic(const char *name, SchedTaskFn fn, HalMillis period, HalMillis firstDelay,
+                    HalMillis now = 0) {
+        return add(name, fn, period > 0 ? period : 1, now + firstDelay);
+    }
+
+    // Execução única depois de `delayMs`
+    int addOneShot(const char *name, SchedTaskFn fn, HalMillis delayMs, HalMillis now = 0) {
+        return add(name, fn, 0, now + delayMs);
+    }
+
+    // Novo período, aplicado a partir do próximo reagendamento
+    void setPeriod(int id, HalMillis period) {
+        if (valid(id) && tasks_[id].period > 0 && period > 0) tasks_[id].period = period;
+    }
+
+    // Antecipa a tarefa para `now` (ex.: a bomba ligou e o controle precisa rodar já)
+    void trigger(int id, HalMillis now) {
+        int position = valid(id) ? positionOf(id) : -1;
+        if (position < 0) return;  // Inativa ou em execução
+        if (before(now, tasks_[id].deadline)) {
+            tasks_[id].deadline = now;
+            siftUp(position);
+        }
+    }
+
+    // Executa as tarefas vencidas em `now` e retorna quantos ms faltam, a
+    // partir de `now`, para o próximo prazo. Se as tarefas demoram (ex.:
+    // reconexão com delay()), releia o relógio e use timeUntilNext()
+    HalMillis runDue(HalMillis now) {
+        while (size_ > 0 && !before(now, tasks_[heap_[0]].deadline)) {
+            // Sai do heap antes de rodar: a tarefa pode chamar trigger() em outra
+            int id = heap_[0];
+            removeTop();
+            SchedTask &task = tasks_[id];
+            HalMillis late = now - task.deadline;
+            task.runs++;
+            task.lateSumMs += late;
+            if (late > task.lateMaxMs) task.lateMaxMs = late;
+
+            task.fn();
+
+            if (task.period == 0) {
+                task.active = false;
+                continue;
+            }
+            task.deadline += task.period;
+            if (!before(now, task.deadline)) {
+                HalMillis missed = (now - task.deadline) / task.period + 1;
+                task.overruns += missed;
+                task.deadline += missed * task.period;
+            }
+            heap_[size_] = id;
+            siftUp(size_++);
+        }
+        return timeUntilNext(now);
+    }
+
+    // ms de `now` até o próximo prazo; 0 se já venceu ou não há tarefas
+    HalMillis timeUntilNext(HalMillis now) const {
+        if (size_ == 0 || !before(now, tasks_[heap_[0]].deadline)) return 0;
+        return tasks_[heap_[0]].deadline - now;
+    }
+
+    // Prazo da próxima tarefa (0 se não há tarefas)
+    HalMillis nextDeadline() const { return size_ > 0 ? tasks_[heap_[0]].deadline : 0; }
+
+    int count() const { return count_; }
+    const SchedTask &task(int id) const { return tasks_[id]; }
+
+private:
+    static bool before(HalMillis a, HalMillis b) { return (HalMillisDelta)(a - b) < 0; }
+
+    // Ordem do heap: prazo e, no empate, a tarefa criada primeiro
+    bool earlier(int a, int b) const {
+        if (tasks_[a].deadline != tasks_[b].deadline) return before(tasks_[a].deadline, tasks_[b].deadline);
+        return a < b;
+    }
+
+    bool valid(int id) const { return id >= 0 && id < count_; }
+
+    int add(const char *name, SchedTaskFn fn, HalMillis period, HalMillis deadline) {
+        if (count_ >= SCHED_MAX_TASKS) return -1;
+        int id = count_++;
+        tasks_[id] = SchedTask{name, fn, period, deadline, true, 0, 0, 0, 0};
+        heap_[size_] = id;
+        siftUp(size_++);
+        return id;
+    }
+
+    int positionOf(int id) const {
+        for (int i = 0; i < size_; i++) {
+            if (heap_[i] == id) return i;
+        }
+        return -1;
+    }
+
+    void removeTop() {
+        heap_[0] = heap_[--size_];
+        if (size_ > 0) siftDown(0);
+    }
+
+    void siftUp(int i) {
+        while (i > 0) {
+            int parent = (i - 1) / 2;
+            if (!earlier(heap_[i], heap_[parent])) break;
+            swap(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(int i) {
+        while (true) {
+            int left = 2 * i + 1;
+            int right = left + 1;
+            int first = i;
+            if (left < size_ && earlier(heap_[left], heap_[first])) first = left;
+            if (right < size_ && earlier(heap_[right], heap_[first])) first = right;
+            if (first == i) break;
+            swap(i, first);
+            i = first;
+        }
+    }
+
+    void swap(int a, int b) {
+        int tmp = heap_[a];
+        heap_[a] = heap_[b];
+        heap_[b] = tmp;
+    }
+
+    SchedTask tasks_[SCHED_MAX_TASKS];
+    int heap_[SCHED_MAX_TASKS];
+    int count_ = 0;
+    int size_ = 0;
+};
+
+#endif // TASK_SCHEDULER_H
@@ -0,0 +1,98 @@
+/*
+    Banda morta por chave da telemetria (só o que mudou)
+
+    Modo, umidade mínima, estado do tanque e o nome do motor de IA quase
+    nunca mudam, e a temperatura oscila décimos de grau entre amostras.
+    Cada chave tem uma banda: o valor só é enviado quando se afasta do
+    último valor enviado por pelo menos a banda, ou quando a chave ficou
+    calada por `maxSilenceMs` (o painel não fica sem notícia):
+
+        const DeadbandKey keys[] = {{"temperature", 0.5f}, {"tankState", 0}};
+        TelemetryDeadband<2> deadband(keys, 600000);
+        if (deadband.update(0, 25.3f, sampledAt)) json.field("temperature", 25.3f);
+        ...
+        if (publish(payload)) deadband.commit(); else deadband.rollback();
+
+    Banda 0: qualquer mudança (booleanos, inteiros, textos). Textos são
+    comparados por hash (FNV-1a), então o buffer pode ser temporário.
+    update() mexe só no estado pendente; commit() o confirma quando a
+    publicação dá certo e rollback() o descarta, para que uma mudança não
+    se perca numa publicação que falhou.
+
+    Capacidade fixa (N chaves), sem alocação.
+*/
+
+#ifndef TELEMETRY_DEADBAND_H
+#define TELEMETRY_DEADBAND_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include "hal.h"                // HalMillis
+
+struct DeadbandKey {
+    const char *name;
+    float band;                 // 0 = qualquer mudança
+};
+
+template <int N>
+class TelemetryDeadband {
+public:
+    TelemetryDeadband(const DeadbandKey (&keys)[N], HalMillis maxSilenceMs)
+        : keys_(keys), maxSilence_(maxSilenceMs) {}
+
+    const char *name(int key) const { return keys_[key].name; }
+
+    // true se a chave deve ir nesta amostra (e passa a ser o último valor enviado)
+    bool update(int key, float value, HalMillis now) {
+        KeyState &state = pending_[key];
+        const float band = keys_[key].band;
+        const bool moved = band > 0 ? fabsf(value - state.value) >= band : value != state.value;
+        return send(state, moved, value, now);
+    }
+
+    bool update(int key, const char *text, HalMillis now) {
+        KeyState &state = pending_[key];
+        const float value = (float)hash(text);
+        return send(state, value != state.value, value, now);
+    }
+
+    void commit() {
+        for (int i = 0; i < N; i++) committed_[i] = pending_[i];
+    }
+    void rollback() {
+        for (int i = 0; i < N; i++) pending_[i] = committed_[i];
+    }
+
+private:
+    struct KeyState {
+        float value;
+        HalMillis sentAt;
+        bool sent;
+    };
+
+    bool send(KeyState &state, bool moved, float value, HalMillis now) {
+        if (state.sent && !moved && (HalMillisDelta)(now - state.sentAt) < (HalMillisDelta)maxSilence_) return false;
+        state.value = value;
+        state.sentAt = now;
+        state.sent = true;
+        return true;
+    }
+
+    // Hash de 24 bits: cabe exato na mantissa do float
+    static uint32_t hash(const char *text) {
+        uint32_t h = 2166136261u;
+        for (; *text != '\0'; text++) {
+            h ^= (uint8_t)*text;
+            h *= 16777619u;
+        }
+        return h & 0xFFFFFFu;
+    }
+
+    const DeadbandKey (&keys_)[N];
+    HalMillis maxSilence_;
+    KeyState pending_[N] = {};
+    KeyState committed_[N] = {};
+};
+
+#endif // TELEMETRY_DEADBAND_H
@@ -17,14 +17,129 @@ TEST_SIZE = 0.2
 RANDOM_STATE = 42
 N_CLUSTERS = 100  # Reduzido para ser mais eficiente no ESP32
 K_NEIGHBORS = 3   # Número de vizinhos para KNN
+KD_LEAF_SIZE = 8  # Protótipos por folha da KD-tree exportada
+EXPORT_QUANTIZED = True  # Exporta também os protótipos em int16 (colunas por feature)
+Q_SHIFT = 10      # Ponto fixo Q5.10 sobre os valores padronizados
+Q_MAX = 8191      # Satura em +-8 desvios padrão (distância cabe em int32)
+EXPORT_BLOB = True  # Exporta também model.bin (partição "model" do ESP32)
+BLOB_VERSION = 1  # Mesmo KNN_BLOB_VERSION de knn_model_blob.h
+BLOB_ALIGN = 16
+CONF_BINS = 10    # Faixas da calibração da confiança (knn_conf_calibration); 0 = não exporta
+CONF_MIN_COUNT = 50  # Amostras mínimas por faixa (faixas menores se juntam às vizinhas)
+CONF_EPSILON = 1e-3  # Mesmo KNN_CONF_EPSILON de knn.h
 
-def save_model_to_header(X_train_reduced, y_train_reduced, scaler_mean, scaler_scale, filename="model_data.h"):
+def build_kdtree(X, leaf_size=KD_LEAF_SIZE):
+    """Monta uma KD-tree implícita (achatada) sobre os protótipos
+
+    O nó que cobre o intervalo [lo, hi) de kd_index tem o pivô na posição
+    mid = lo + (hi - lo) // 2, dimensão de corte kd_split_dim[mid], filho
+    esquerdo em [lo, mid) e direito em [mid + 1, hi). Intervalos com até
+    leaf_size protótipos são folhas e são percorridos linearmente.
+    """
+    points = X.tolist()
+    n_features = len(points[0]) if points else 0
+    kd_index = list(range(len(points)))
+    kd_split_dim = [0] * len(points)
+
+    def build(lo, hi):
+        if hi - lo <= leaf_size:
+            return
+        # Corta na dimensão de maior amplitude dentro do intervalo
+        spreads = [max(points[i][d] for i in kd_index[lo:hi]) - min(points[i][d] for i in kd_index[lo:hi])
+                   for d in range(n_features)]
+        dim = spreads.index(max(spreads))
+        kd_index[lo:hi] = sorted(kd_index[lo:hi], key=lambda i: (points[i][dim], i))
+        mid = lo + (hi - lo) // 2
+        kd_split_dim[mid] = dim
+        build(lo, mid)
+        build(mid + 1, hi)
+
+    build(0, len(points))
+    return kd_index, kd_split_dim
+
+def quantize_prototypes(X, q_shift=Q_SHIFT, q_max=Q_MAX):
+    """Quantiza os protótipos padronizados em int16, organizados por feature
+
+    Retorna as colunas concatenadas: todos os valores da feature 0, depois
+    os da feature 1, e assim por diante. A entrada do firmware passa pelo
+    mesmo scaler_mean/scaler_scale antes de ser quantizada (knn.h).
+    """
+    points = X.tolist()
+    n_features = len(points[0]) if points else 0
+    columns = []
+    for d in range(n_features):
+        for p in points:
+            columns.append(max(-q_max, min(q_max, round(p[d] * (1 << q_shift)))))
+    return columns
+
+def write_int_array(f, ctype, name, values):
+    """Escreve um array inteiro C++ com 15 valores por linha"""
+    f.write(f"static const {ctype} {name}[] = {{\n    ")
+    for i, v in enumerate(values):
+        f.write(f"{int(v)}")
+        if i < len(values) - 1:
+            f.write(", ")
+            if (i + 1) % 15 == 0:
+                f.write("\n    ")
+    f.write("\n};\n\n")
+
+def calibration_table(totals, hits, min_count=CONF_MIN_COUNT):
+    """Junta faixas vizinhas até min_count amostras e aplica o PAV (tabela crescente)"""
+    n_bins = len(totals)
+    groups = []  # [primeira, última, total, acertos]
+    for b in range(n_bins):
+        if not groups or groups[-1][2] >= max(min_count, 1):
+            groups.append([b, b, 0, 0])
+        groups[-1][1] = b
+        groups[-1][2] += totals[b]
+        groups[-1][3] += hits[b]
+    if len(groups) > 1 and groups[-1][2] < min_count:
+        tail = groups.pop()
+        groups[-1][1] = tail[1]
+        groups[-1][2] += tail[2]
+        groups[-1][3] += tail[3]
+
+    pooled = []
+    for group in groups:
+        pooled.append(group)
+        while len(pooled) > 1 and pooled[-2][3] * pooled[-1][2] > pooled[-1][3] * pooled[-2][2]:
+            right = pooled.pop()
+            pooled[-1] = [pooled[-1][0], right[1], pooled[-1][2] + right[2], pooled[-1][3] + right[3]]
+
+    table = (np.arange(n_bins) + 0.5) / n_bins
+    for first, last, total, correct in pooled:
+        if total > 0:
+            table[first:last + 1] = correct / total
+    return table
+
+def calibrate_confidence(X_train_reduced, y_train_reduced, X_test_scaled, y_test, n_bins=CONF_BINS):
+    """Acurácia observada no teste por faixa da confiança bruta de knn_weighted_share()"""
+    hits = np.zeros(n_bins)
+    totals = np.zeros(n_bins)
+    for x, label in zip(X_test_scaled, y_test):
+        distances = np.linalg.norm(X_train_reduced - x, axis=1)
+        nearest = np.argsort(distances, kind="stable")[:K_NEIGHBORS]
+        labels = y_train_reduced[nearest]
+        predicted = np.bincount(labels, minlength=2).argmax()
+        weights = 1.0 / (distances[nearest] + CONF_EPSILON)
+        share = weights[labels == predicted].sum() / weights.sum()
+        b = min(n_bins - 1, int(share * n_bins))
+        totals[b] += 1
+        hits[b] += predicted == label
+    return calibration_table(totals, hits)
+
+def save_model_to_header(X_train_reduced, y_train_reduced, scaler_mean, scaler_scale, filename="model_data.h",
+                         calibration=None):
     """Salva os dados do modelo em formato C++ header"""
     print(f"Salvando modelo no arquivo {filename}...")
 
     with open(filename, "w", encoding="UTF-8") as f:
         f.write("#ifndef MODEL_DATA_H\n")
         f.write("#define MODEL_DATA_H\n\n")
+        f.write(f"#define N_FEATURES {X_train_reduced.shape[1]}\n")
+        f.write(f"#define N_TRAIN_REDUCED {len(y_train_reduced)}\n")
+        f.write(f"#define N_NEIGHBORS {K_NEIGHBORS}\n")
+        f.write(f"#define N_CLASSES {int(np.max(y_train_reduced)) + 1}\n\n")
         
         # Dados de treinamento reduzidos
         f.write("static const float X_train_reduced[] = {\n")
@@ -67,10 +182,66 @@ def save_model_to_header(X_train_reduced, y_train_reduced, scaler_mean, scaler_s
                 f.write(", ")
         f.write("\n};\n\n")
         
+        # KD-tree implícita sobre X_train_reduced (busca exata em knn.h)
+        kd_index, kd_split_dim = build_kdtree(X_train_reduced)
+        f.write(f"#define KD_LEAF_SIZE {KD_LEAF_SIZE}\n\n")
+        write_int_array(f, "unsigned short", "kd_index", kd_index)
+        write_int_array(f, "unsigned char", "kd_split_dim", kd_split_dim)
+        
+        # Protótipos quantizados (structure-of-arrays, int16)
+        if EXPORT_QUANTIZED:
+            f.write(f"#define KNN_Q_SHIFT {Q_SHIFT}\n")
+            f.write(f"#define KNN_Q_MAX {Q_MAX}\n\n")
+            write_int_array(f, "short", "X_train_q", quantize_prototypes(X_train_reduced))
+        
+        # Calibração da confiança (knn_predict_confidence)
+        if calibration is not None and len(calibration) > 0:
+            f.write(f"#define KNN_CONF_BINS {len(calibration)}\n\n")
+            f.write("static const float knn_conf_calibration[] = {\n    ")
+            f.write(", ".join(f"{v:.4f}" for v in calibration))
+            f.write("\n};\n\n")
+        
         f.write("#endif // MODEL_DATA_H\n")
     
     print("Modelo salvo com sucesso!")
 
+def save_model_to_blob(X_train_reduced, y_train_reduced, scaler_mean, scaler_scale, filename="model.bin"):
+    """Salva o modelo no formato binário de knn_model_blob.h
+
+    Cabeçalho de 48 bytes seguido de scaler_mean, scaler_scale, protótipos
+    (float32) e rótulos (int32), cada seção alinhada a BLOB_ALIGN bytes.
+    O CRC-32 cobre todo o arquivo exceto o próprio campo (offset 40).
+    """
+    import struct
+    import zlib
+    print(f"Salvando modelo binário no arquivo {filename}...")
+
+    def align(offset):
+        return (offset + BLOB_ALIGN - 1) // BLOB_ALIGN * BLOB_ALIGN
+
+    n_prototypes, n_features = X_train_reduced.shape
+    header_size = 48
+    mean_offset = align(header_size)
+    scale_offset = align(mean_offset + 4 * n_features)
+    prototypes_offset = align(scale_offset + 4 * n_features)
+    labels_offset = align(prototypes_offset + 4 * n_prototypes * n_features)
+    total_size = labels_offset + 4 * n_prototypes
+
+    blob = bytearray(total_size)
+    struct.pack_into(f"<{n_features}f", blob, mean_offset, *scaler_mean)
+    struct.pack_into(f"<{n_features}f", blob, scale_offset, *scaler_scale)
+    struct.pack_into(f"<{n_prototypes * n_features}f", blob, prototypes_offset, *X_train_reduced.flatten())
+    struct.pack_into(f"<{n_prototypes}i", blob, labels_offset, *[int(v) for v in y_train_reduced])
+    struct.pack_into("<IHHHHHHIIIIIIII", blob, 0, 0x4E4E4B48, BLOB_VERSION, header_size,
+                     n_features, n_prototypes, K_NEIGHBORS, int(np.max(y_train_reduced)) + 1,
+                     mean_offset, scale_offset, prototypes_offset, labels_offset, total_size, 0, 0, 0)
+    crc = zlib.crc32(blob[44:], zlib.crc32(blob[:40]))
+    struct.pack_into("<I", blob, 40, crc)
+
+    with open(filename, "wb") as f:
+        f.write(blob)
+    print(f"Modelo binário salvo ({total_size} bytes, CRC-32 0x{crc:08x})")
+
 def load_dataset(filepath):
     """Carrega e limpa o dataset"""
     print(f"Carregando dataset {filepath}...")
@@ -178,14 +349,22 @@ def main():
     # Reduz os dados para uso no ESP32
     X_train_reduced, y_train_reduced = reduce_training_data(X_train_scaled, y_train, N_CLUSTERS)
     
+    calibration = None
+    if CONF_BINS > 0:
+        calibration = calibrate_confidence(X_train_reduced, y_train_reduced, X_test_scaled, y_test)
+        print("Calibração da confiança: " + " ".join(f"{v:.2f}" for v in calibration))
+    
     # Salva o modelo no formato C++
     save_model_to_header(
         X_train_reduced, 
         y_train_reduced, 
         scaler.mean_, 
         scaler.scale_, 
-        filename="model_data.h"
+        filename="model_data.h",
+        calibration=calibration
     )
+    if EXPORT_BLOB:
+        save_model_to_blob(X_train_reduced, y_train_reduced, scaler.mean_, scaler.scale_, filename="model.bin")
     
     print("\nProcesso concluído com sucesso!")
     print("Acurácia final: {accuracy:.2%}")
@@ -0,0 +1,213 @@
+/*
+    Leitor de CSV mapeado em memória (somente host)
+
+    Lê datasets no formato do TARP.csv sem copiar o arquivo e sem alocar
+    por linha:
+    - o arquivo é mapeado com mmap (MappedFile) e lido direto do mapeamento
+    - o cabeçalho é indexado uma vez, com os nomes sem espaços nas pontas
+      (o TARP.csv tem " Soil Humidity")
+    - as linhas são divididas entre threads em fronteiras de '\n' e cada
+      campo numérico é convertido no lugar com std::from_chars
+    - a saída fica em colunas contíguas (column-major), o layout de entrada
+      de knn_predict_batch()
+
+    Campos entre aspas não são suportados (o TARP.csv não usa). Linhas com
+    algum campo selecionado vazio, não numérico ou com categoria
+    desconhecida são descartadas, como o dropna do IA_simple.py.
+*/
+
+#ifndef CSV_MMAP_H
+#define CSV_MMAP_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Coluna a extrair: numérica, ou categórica (valor = posição em categories)
+struct CsvColumnSpec {
+    int index;                      // Posição no cabeçalho (CsvMmap::column)
+    const char *const *categories;  // NULL = numérica
+    int n_categories;
+};
+
+// Colunas extraídas: values[c * rows + i] = coluna c da linha válida i
+struct CsvTable {
+    std::vector<float> values;
+    size_t rows = 0;        // Linhas válidas
+    size_t totalRows = 0;   // Linhas de dados no arquivo
+    const float *column(int c) const { return &values[c * rows]; }
+};
+
+class CsvMmap {
+public:
+    bool open(const char *path) {
+        header_.clear();
+        if (!file_.open(path)) return false;
+
+        const char *begin = (const char *)file_.data();
+        const char *end = begin + file_.size();
+        const char *newline = (const char *)std::memchr(begin, '\n', file_.size());
+        const char *headerEnd = newline ? newline : end;
+        body_ = newline ? newline + 1 : end;
+
+        const char *field = begin;
+        for (const char *p = begin; p <= headerEnd; p++) {
+            if (p == headerEnd || *p == ',') {
+                const char *a = field, *b = p;
+                trim(a, b);
+                header_.emplace_back(a, b);
+                field = p + 1;
+            }
+        }
+        return true;
+    }
+
+    // Índice da coluna pelo nome (sem espaços nas pontas), ou -1
+    int column(const char *name) const {
+        for (size_t i = 0; i < header_.size(); i++) {
+            if (header_[i] == name) return (int)i;
+        }
+        return -1;
+    }
+
+    size_t columnCount() const { return header_.size(); }
+
+    // Extrai as colunas pedidas de todas as linhas. n_threads = 0 usa todos os núcleos.
+    // false sem colunas, com índice negativo ou com a mesma coluna pedida duas vezes
+    bool read(const CsvColumnSpec *specs, int n_specs, CsvTable &table, unsigned n_threads = 0) const {
+        if (n_specs <= 0) return false;
+        std::vector<int> slotOf;
+        for (int s = 0; s < n_specs; s++) {
+            if (specs[s].index < 0) return false;
+            if ((size_t)specs[s].index >= slotOf.size()) slotOf.resize(specs[s].index + 1, -1);
+            if (slotOf[specs[s].index] >= 0) return false;  // Repetida: nenhuma linha ficaria completa
+            slotOf[specs[s].index] = s;
+        }
+
+        const char *begin = body_;
+        const char *end = (const char *)file_.data() + file_.size();
+        const size_t bytes = (size_t)(end - begin);
+
+        // Blocos menores que 1 MB não compensam uma thread
+        if (n_threads == 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+        n_threads = (unsigned)std::min<size_t>(n_threads, std::max<size_t>(1, bytes >> 20));
+
+        // Fronteiras: cada bloco começa logo após um '\n'
+        std::vector<const char *> bounds(n_threads + 1, end);
+        bounds[0] = begin;
+        for (unsigned t = 1; t < n_threads; t++) {
+            const char *p = begin + bytes / n_threads * t;
+            if (p < bounds[t - 1]) p = bounds[t - 1];
+            const char *newline = (const char *)std::memchr(p, '\n', (size_t)(end - p));
+            bounds[t] = newline ? newline + 1 : end;
+        }
+
+        std::vector<Chunk> chunks(n_threads, Chunk(n_specs));
+        auto work = [&](unsigned t) {
+            parseChunk(bounds[t], bounds[t + 1], specs, n_specs, slotOf, chunks[t]);
+        };
+        std::vector<std::thread> workers;
+        for (unsigned t = 1; t < n_threads; t++) workers.emplace_back(work, t);
+        work(0);
+        for (size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+        // Junta os blocos na ordem do arquivo
+        table.rows = 0;
+        table.totalRows = 0;
+        for (unsigned t = 0; t < n_threads; t++) {
+            table.rows += chunks[t].columns[0].size();
+            table.totalRows += chunks[t].lines;
+        }
+        table.values.resize((size_t)n_specs * table.rows);
+        size_t offset = 0;
+        for (unsigned t = 0; t < n_threads; t++) {
+            const size_t n = chunks[t].columns[0].size();
+            for (int s = 0; s < n_specs; s++) {
+                std::memcpy(&table.values[s * table.rows + offset], chunks[t].columns[s].data(), n * sizeof(float));
+            }
+            offset += n;
+        }
+        return true;
+    }
+
+private:
+    struct Chunk {
+        explicit Chunk(int n_specs) : columns(n_specs), lines(0) {}
+        std::vector<std::vector<float>> columns;
+        size_t lines;
+    };
+
+    static void trim(const char *&a, const char *&b) {
+        while (a < b && (*a == ' ' || *a == '\t')) a++;
+        while (b > a && (b[-1] == ' ' || b[-1] == '\t' || b[-1] == '\r')) b--;
+    }
+
+    static bool parseField(const char *a, const char *b, const CsvColumnSpec &spec, float &value) {
+        trim(a, b);
+        if (a == b) return false;
+        if (spec.categories == NULL) {
+            if (*a == '+') a++;
+            std::from_chars_result result = std::from_chars(a, b, value);
+            return result.ec == std::errc() && result.ptr == b;
+        }
+        const size_t length = (size_t)(b - a);
+        for (int c = 0; c < spec.n_categories; c++) {
+            if (std::strlen(spec.categories[c]) == length && std::memcmp(a, spec.categories[c], length) == 0) {
+                value = (float)c;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void parseChunk(const char *p, const char *end, const CsvColumnSpec *specs, int n_specs,
+                           const std::vector<int> &slotOf, Chunk &chunk) {
+        const size_t expectedRows = (size_t)(end - p) / 64 + 1;
+        for (int s = 0; s < n_specs; s++) chunk.columns[s].reserve(expectedRows);
+
+        float row[16];
+        std::vector<float> wideRow(n_specs > 16 ? n_specs : 0);
+        float *values = n_specs > 16 ? wideRow.data() : row;
+        const int lastColumn = (int)slotOf.size() - 1;
+
+        while (p < end) {
+            const char *lineEnd = (const char *)std::memchr(p, '\n', (size_t)(end - p));
+            if (lineEnd == NULL) lineEnd = end;
+            if (lineEnd == p || (lineEnd == p + 1 && *p == '\r')) {  // Linha vazia
+                p = lineEnd + 1;
+                continue;
+            }
+            chunk.lines++;
+
+            int found = 0;
+            bool valid = true;
+            const char *field = p;
+            for (int column = 0; column <= lastColumn && valid; column++) {
+                const char *comma = (const char *)std::memchr(field, ',', (size_t)(lineEnd - field));
+                const char *fieldEnd = comma ? comma : lineEnd;
+                int slot = slotOf[column];
+                if (slot >= 0) {
+                    valid = parseField(field, fieldEnd, specs[slot], values[slot]);
+                    found++;
+                }
+                if (comma == NULL) break;
+                field = comma + 1;
+            }
+            if (valid && found == n_specs) {
+                for (int s = 0; s < n_specs; s++) chunk.columns[s].push_back(values[s]);
+            }
+            p = lineEnd + 1;
+        }
+    }
+
+    MappedFile file_;
+    const char *body_ = nullptr;
+    std::vector<std::string> header_;
+};
+
+#endif // CSV_MMAP_H
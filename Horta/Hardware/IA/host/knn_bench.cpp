@@ -0,0 +1,355 @@
+/*
+    Benchmark de host do KNN do firmware
+
+    Reproduz todas as linhas do TARP.csv através do mesmo código de
+    inferência usado no ESP32 (knn.h + model_data.h) e reporta:
+    - ns/predição e throughput (predições/s)
+    - concordância com a coluna Status do dataset
+    - a mesma reprodução pela interface InferenceEngine, com o KNN e com a
+      árvore de decisão de model_tree.h
+    - o KNN atrás do MemoizedEngine (taxa de acerto do cache) e a confiança
+      do KnnEngine comparada com a acurácia observada em cada faixa, só no
+      conjunto de teste do knn_train (mesma divisão, semente e proporção
+      padrão), que não participou do treino nem da calibração
+
+    Uso: knn_bench [caminho/TARP.csv] [repeticoes] [threads]
+
+    Sai com código 1 se um caminho que deve ser exato divergir do
+    knn_predict(): KD-tree, lote, template (float e int16), KnnEngine e
+    MemoizedEngine. O ctest roda com 1 repetição (knn_bench_exactness).
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "inference_engine.h"
+#include "knn.h"
+#include "knn_batch.h"
+#include "knn_classifier.h"
+#include "knn_online.h"
+#include "knn_train.h"
+#include "tarp_dataset.h"
+
+#ifndef HORTA_TARP_CSV
+#define HORTA_TARP_CSV "TARP.csv"
+#endif
+
+// ======= MEDIÇÃO =======
+struct BenchResult {
+    double nsPerPrediction;
+    size_t confusion[2][2];  // [real][previsto]
+    long long checksum;
+};
+
+// Mesmo caminho de shouldIrrigate(): copiar, padronizar e prever
+template <typename Predict>
+static BenchResult runBenchmark(const std::vector<Sample> &samples, int repeats, Predict predict,
+                                std::vector<int> &predictions) {
+    BenchResult result = {};
+    predictions.assign(samples.size(), 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            float input_scaled[N_FEATURES];
+            for (int f = 0; f < N_FEATURES; f++) {
+                input_scaled[f] = samples[i].features[f];
+            }
+            standardize(input_scaled, N_FEATURES);
+            predictions[i] = predict(input_scaled);
+            result.checksum += predictions[i];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    const double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+    result.nsPerPrediction = totalNs / ((double)samples.size() * repeats);
+    for (size_t i = 0; i < samples.size(); i++) {
+        result.confusion[samples[i].status][predictions[i]]++;
+    }
+    return result;
+}
+
+// Mesmo laço pela interface do firmware: leituras cruas, chamada virtual
+static BenchResult runEngine(const std::vector<Sample> &samples, int repeats, const InferenceEngine &engine,
+                             std::vector<int> &predictions) {
+    BenchResult result = {};
+    predictions.assign(samples.size(), 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < samples.size(); i++) {
+            predictions[i] = engine.predict(samples[i].features);
+            result.checksum += predictions[i];
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    const double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+    result.nsPerPrediction = totalNs / ((double)samples.size() * repeats);
+    for (size_t i = 0; i < samples.size(); i++) {
+        result.confusion[samples[i].status][predictions[i]]++;
+    }
+    return result;
+}
+
+static void printResult(const char *name, const BenchResult &result, size_t nSamples) {
+    const size_t hits = result.confusion[0][0] + result.confusion[1][1];
+    std::printf("%-14s %10.1f %14.0f %12.2f%%\n", name, result.nsPerPrediction,
+                1e9 / result.nsPerPrediction, 100.0 * hits / nSamples);
+}
+
+// ======= MAIN =======
+int main(int argc, char **argv) {
+    const char *csvPath = (argc > 1) ? argv[1] : HORTA_TARP_CSV;
+    const int repeats = (argc > 2) ? std::atoi(argv[2]) : 5;
+    const unsigned threads = (argc > 3) ? (unsigned)std::atoi(argv[3]) : 0;
+
+    CsvTable table;
+    if (!loadTarpColumns(csvPath, table, threads)) return 1;
+    const size_t totalRows = table.totalRows;
+    const std::vector<Sample> samples = tarpSamples(table);
+    if (samples.empty() || repeats <= 0) {
+        std::fprintf(stderr, "Erro: nenhuma amostra válida para avaliar\n");
+        return 1;
+    }
+
+    std::printf("Dataset: %s\n", csvPath);
+    std::printf("Amostras válidas: %zu de %zu linhas\n", samples.size(), totalRows);
+    std::printf("Modelo: %d protótipos, %d features, k=%d\n", N_TRAIN_REDUCED, N_FEATURES, N_NEIGHBORS);
+    std::printf("Repetições: %d\n", repeats);
+
+    std::vector<int> linearPredictions;
+    BenchResult linear = runBenchmark(samples, repeats, [](const float *input) {
+        float min_distances[N_NEIGHBORS];
+        int indices[N_NEIGHBORS];
+        knn_search_linear(input, X_train_reduced, N_TRAIN_REDUCED, min_distances, indices, N_NEIGHBORS);
+        return knn_vote(indices);
+    }, linearPredictions);
+
+    std::vector<int> kdtreePredictions;
+    BenchResult kdtree = runBenchmark(samples, repeats, [](const float *input) {
+        float min_distances[N_NEIGHBORS];
+        int indices[N_NEIGHBORS];
+        knn_search_kdtree(input, X_train_reduced, N_TRAIN_REDUCED, kd_index, kd_split_dim, KD_LEAF_SIZE,
+                          min_distances, indices, N_NEIGHBORS);
+        return knn_vote(indices);
+    }, kdtreePredictions);
+
+    std::vector<int> quantizedPredictions;
+    BenchResult quantized = runBenchmark(samples, repeats, [](const float *input) {
+        return knn_predict_quantized(input);
+    }, quantizedPredictions);
+
+    static const KnnClassifier<N_FEATURES, N_NEIGHBORS, N_CLASSES> templateKnn(
+        X_train_reduced, y_train_reduced, N_TRAIN_REDUCED, scaler_mean, scaler_scale);
+    std::vector<int> templatePredictions;
+    BenchResult templated = runBenchmark(samples, repeats, [](const float *input) {
+        return templateKnn.predict(input);
+    }, templatePredictions);
+
+    static const KnnClassifier<N_FEATURES, N_NEIGHBORS, N_CLASSES, short> templateKnnQ(
+        X_train_q, y_train_reduced, N_TRAIN_REDUCED, scaler_mean, scaler_scale);
+    std::vector<int> templateQPredictions;
+    BenchResult templatedQ = runBenchmark(samples, repeats, [](const float *input) {
+        short encoded[N_FEATURES];
+        for (int f = 0; f < N_FEATURES; f++) {
+            encoded[f] = KnnScalarTraits<short>::encode(input[f]);
+        }
+        return templateKnnQ.predict(encoded);
+    }, templateQPredictions);
+
+    size_t templateAgreement = 0;
+    size_t templateQAgreement = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (templatePredictions[i] == linearPredictions[i]) templateAgreement++;
+        if (templateQPredictions[i] == quantizedPredictions[i]) templateQAgreement++;
+    }
+
+    size_t quantizedAgreement = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (quantizedPredictions[i] == linearPredictions[i]) quantizedAgreement++;
+    }
+
+    // Lote: as colunas do CSV já estão no layout column-major, todos os núcleos
+    const size_t n = samples.size();
+    const float *columns = table.column(TARP_TEMPERATURE);
+    std::vector<int> batchLabels(n);
+    std::vector<float> batchDistances(n * N_NEIGHBORS);
+    auto batchStart = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        knn_predict_batch(columns, n, batchLabels.data(), batchDistances.data(), threads);
+    }
+    auto batchEnd = std::chrono::steady_clock::now();
+    BenchResult batch = {};
+    batch.nsPerPrediction = std::chrono::duration<double, std::nano>(batchEnd - batchStart).count() / ((double)n * repeats);
+    for (size_t i = 0; i < n; i++) {
+        batch.confusion[samples[i].status][batchLabels[i]]++;
+    }
+
+    // O lote precisa reproduzir knn_predict() bit a bit (rótulos e distâncias)
+    size_t batchMismatches = 0;
+    for (size_t i = 0; i < n; i++) {
+        float input_scaled[N_FEATURES];
+        for (int f = 0; f < N_FEATURES; f++) {
+            input_scaled[f] = samples[i].features[f];
+        }
+        standardize(input_scaled, N_FEATURES);
+        float min_distances[N_NEIGHBORS];
+        int indices[N_NEIGHBORS];
+        knn_neighbors(input_scaled, min_distances, indices);
+        if (batchLabels[i] != knn_predict(input_scaled) ||
+            std::memcmp(min_distances, &batchDistances[i * N_NEIGHBORS], sizeof(min_distances)) != 0) {
+            batchMismatches++;
+        }
+    }
+
+    // A KD-tree precisa devolver exatamente os mesmos k vizinhos da busca linear
+    size_t neighborMismatches = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        float input_scaled[N_FEATURES];
+        for (int f = 0; f < N_FEATURES; f++) {
+            input_scaled[f] = samples[i].features[f];
+        }
+        standardize(input_scaled, N_FEATURES);
+
+        float linearDistances[N_NEIGHBORS], kdtreeDistances[N_NEIGHBORS];
+        int linearIndices[N_NEIGHBORS], kdtreeIndices[N_NEIGHBORS];
+        knn_search_linear(input_scaled, X_train_reduced, N_TRAIN_REDUCED, linearDistances, linearIndices, N_NEIGHBORS);
+        knn_search_kdtree(input_scaled, X_train_reduced, N_TRAIN_REDUCED, kd_index, kd_split_dim, KD_LEAF_SIZE,
+                          kdtreeDistances, kdtreeIndices, N_NEIGHBORS);
+        for (int j = 0; j < N_NEIGHBORS; j++) {
+            if (linearIndices[j] != kdtreeIndices[j]) {
+                neighborMismatches++;
+                break;
+            }
+        }
+    }
+
+    // Motores de inferência: o KnnEngine precisa repetir knn_predict()
+    static const KnnEngine knnEngine;
+    static const TreeEngine treeEngine;
+    std::vector<int> knnEnginePredictions, treePredictions;
+    BenchResult knnEngineResult = runEngine(samples, repeats, knnEngine, knnEnginePredictions);
+    BenchResult treeResult = runEngine(samples, repeats, treeEngine, treePredictions);
+    static MemoizedEngine memoizedEngine(knnEngine);
+    std::vector<int> memoizedPredictions;
+    BenchResult memoizedResult = runEngine(samples, repeats, memoizedEngine, memoizedPredictions);
+    size_t engineMismatches = 0;
+    size_t memoizedMismatches = 0;
+    size_t treeAgreement = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (knnEnginePredictions[i] != linearPredictions[i]) engineMismatches++;
+        if (memoizedPredictions[i] != linearPredictions[i]) memoizedMismatches++;
+        if (treePredictions[i] == linearPredictions[i]) treeAgreement++;
+    }
+
+    // Confiabilidade: acurácia observada em cada faixa de confiança. Medida
+    // no teste do knn_train; no dataset inteiro a tabela seria conferida
+    // contra os próprios dados de onde saiu
+    KnnTrainData allRows, trainRows, testRows;
+    knn_train_from_columns(table.column(TARP_TEMPERATURE), table.column(TARP_STATUS), table.rows, allRows);
+    knn_train_split(allRows, KnnTrainConfig(), trainRows, testRows);
+    const int confBins = 10;
+    size_t confTotal[confBins] = {0};
+    size_t confHits[confBins] = {0};
+    size_t confCorrect = 0;
+    double confSum = 0;
+    for (size_t i = 0; i < testRows.size(); i++) {
+        float confidence;
+        int label = knnEngine.predict(&testRows.X[i * N_FEATURES], &confidence);
+        int bin = std::min(confBins - 1, std::max(0, (int)(confidence * confBins)));
+        confTotal[bin]++;
+        if (label == testRows.y[i]) {
+            confHits[bin]++;
+            confCorrect++;
+        }
+        confSum += confidence;
+    }
+
+    // Aprendizado online: a primeira metade do dataset faz o papel dos
+    // comandos manuais do operador; a acurácia é medida na segunda metade
+    static KnnOnlineModel onlineModel;
+    knn_online_reset(&onlineModel);
+    const size_t half = n / 2;
+    auto onlineAccuracy = [&]() {
+        size_t hits = 0;
+        for (size_t i = half; i < n; i++) {
+            float input_scaled[N_FEATURES];
+            for (int f = 0; f < N_FEATURES; f++) {
+                input_scaled[f] = samples[i].features[f];
+            }
+            standardize(input_scaled, N_FEATURES);
+            if (knn_online_predict(&onlineModel, input_scaled) == samples[i].status) hits++;
+        }
+        return 100.0 * hits / (n - half);
+    };
+    const double onlineBefore = onlineAccuracy();
+    auto onlineStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < half; i++) {
+        float input_scaled[N_FEATURES];
+        for (int f = 0; f < N_FEATURES; f++) {
+            input_scaled[f] = samples[i].features[f];
+        }
+        standardize(input_scaled, N_FEATURES);
+        knn_online_update(&onlineModel, input_scaled, samples[i].status);
+    }
+    auto onlineEnd = std::chrono::steady_clock::now();
+    const double onlineAfter = onlineAccuracy();
+    const double nsPerUpdate = std::chrono::duration<double, std::nano>(onlineEnd - onlineStart).count() / half;
+
+    std::printf("\n==================== RESULTADO ====================\n");
+    std::printf("%-14s %10s %14s %13s\n", "Busca", "ns/pred", "pred/s", "Status");
+    printResult("linear", linear, samples.size());
+    printResult("kd-tree", kdtree, samples.size());
+    printResult("int16", quantized, samples.size());
+    printResult("template", templated, samples.size());
+    printResult("template int16", templatedQ, samples.size());
+    printResult("lote", batch, samples.size());
+    printResult("motor knn", knnEngineResult, samples.size());
+    printResult("motor tree", treeResult, samples.size());
+    printResult("motor cache", memoizedResult, samples.size());
+    std::printf("\nMatriz de confusão (linhas = real OFF/ON, colunas = previsto OFF/ON):\n");
+    std::printf("    [%zu %zu]\n    [%zu %zu]\n", linear.confusion[0][0], linear.confusion[0][1],
+                linear.confusion[1][0], linear.confusion[1][1]);
+    std::printf("Checksum:         %lld\n", linear.checksum);
+    std::printf("KD-tree vs linear: %zu amostras com vizinhos diferentes\n", neighborMismatches);
+    std::printf("Lote vs knn_predict: %zu amostras diferentes (rótulo ou distâncias)\n", batchMismatches);
+    std::printf("KnnEngine vs knn_predict: %zu amostras diferentes\n", engineMismatches);
+    std::printf("Cache (%d entradas): %.2f%% de acertos, %zu decisões diferentes do knn_predict\n",
+                INFERENCE_CACHE_SLOTS,
+                100.0 * memoizedEngine.hits() / (memoizedEngine.hits() + memoizedEngine.misses()),
+                memoizedMismatches);
+    std::printf("Confiança do KNN:  média %.3f (%s), acurácia %.2f%% em %zu amostras de teste\n",
+                testRows.size() > 0 ? confSum / testRows.size() : 0.0,
+#ifdef KNN_CONF_BINS
+                "calibrada",
+#else
+                "bruta, model_data.h sem knn_conf_calibration",
+#endif
+                testRows.size() > 0 ? 100.0 * confCorrect / testRows.size() : 0.0, testRows.size());
+    for (int b = 0; b < confBins; b++) {
+        if (confTotal[b] == 0) continue;
+        std::printf("    [%.1f, %.1f): %6zu amostras, acurácia %.2f%%\n", (double)b / confBins,
+                    (double)(b + 1) / confBins, confTotal[b], 100.0 * confHits[b] / confTotal[b]);
+    }
+    std::printf("Árvore vs KNN:     %.2f%% das decisões iguais (profundidade %d, %d folhas)\n",
+                100.0 * treeAgreement / samples.size(), TREE_DEPTH, TREE_LEAVES);
+    std::printf("int16 vs float:    %.2f%% das decisões iguais\n", 100.0 * quantizedAgreement / samples.size());
+    std::printf("Template vs knn.h: %.2f%% (float) e %.2f%% (int16) das decisões iguais\n",
+                100.0 * templateAgreement / samples.size(), 100.0 * templateQAgreement / samples.size());
+    std::printf("LVQ online:        %.2f%% -> %.2f%% na 2a metade após %zu comandos, %lu ajustes "
+                "(%.1f ns/comando)\n",
+                onlineBefore, onlineAfter, half, (unsigned long)onlineModel.updates, nsPerUpdate);
+    std::printf("Flash protótipos:  float %zu bytes, int16 %zu bytes\n",
+                sizeof(X_train_reduced), sizeof(X_train_q));
+    std::printf("===================================================\n");
+    // Caminhos que devem ser exatos: qualquer divergência falha o ctest
+    const bool exact = neighborMismatches == 0 && batchMismatches == 0 && engineMismatches == 0 &&
+                       memoizedMismatches == 0 && templateAgreement == samples.size() &&
+                       templateQAgreement == samples.size();
+    return exact ? 0 : 1;
+}
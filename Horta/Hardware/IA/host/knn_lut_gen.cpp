@@ -0,0 +1,143 @@
+/*
+    Gerador da tabela de decisão do KNN (model_lut.h)
+
+    Percorre toda a grade de entradas inteiras (temperatura, umidade do ar,
+    umidade do solo), roda o knn_predict() de knn.h em cada ponto e grava a
+    decisão em 1 bit. Como usa o mesmo código e o mesmo model_data.h do
+    firmware, a tabela reproduz o KNN exato ponto a ponto.
+
+    Uso:
+        knn_lut_gen model_lut.h     gera a tabela
+        knn_lut_gen --verify        confere a tabela compilada contra o KNN
+                                    em toda a grade (código de saída != 0 se
+                                    houver divergência ou se a tabela for de
+                                    outro model_data.h)
+
+    A tabela leva N_TRAIN_REDUCED, N_NEIGHBORS e knn_model_fingerprint()
+    do modelo de origem, conferidos por knn_lut.h.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define KNN_USE_KDTREE  // Mesma configuração do esp32IA.cpp
+#include "knn.h"
+
+// Uma tabela de outro tamanho de modelo não passa pelo #error de knn_lut.h:
+// o gerador precisa compilar justamente para substituí-la
+#if __has_include("model_lut.h")
+#include "model_lut.h"
+#if defined(LUT_MODEL_FINGERPRINT) && LUT_N_TRAIN_REDUCED == N_TRAIN_REDUCED && LUT_N_NEIGHBORS == N_NEIGHBORS
+#include "knn_lut.h"
+#define HAS_MODEL_LUT 1
+#endif
+#endif
+
+// ======= GRADE =======
+// DHT11: 0-50 °C; umidades em % (map() do solo produz 0-100)
+static const int TEMP_MIN = 0, TEMP_MAX = 50;
+static const int AIR_MIN = 0, AIR_MAX = 100;
+static const int SOIL_MIN = 0, SOIL_MAX = 100;
+
+static int exactDecision(int temperature, int airHumidity, int soilMoisture) {
+    float input_scaled[N_FEATURES] = {(float)temperature, (float)airHumidity, (float)soilMoisture};
+    standardize(input_scaled, N_FEATURES);
+    return knn_predict(input_scaled);
+}
+
+static int generate(const char *path) {
+    const long nTemp = TEMP_MAX - TEMP_MIN + 1;
+    const long nAir = AIR_MAX - AIR_MIN + 1;
+    const long nSoil = SOIL_MAX - SOIL_MIN + 1;
+    const long nBits = nTemp * nAir * nSoil;
+    std::vector<unsigned char> table((nBits + 7) / 8, 0);
+
+    long bit = 0;
+    long onCount = 0;
+    for (int t = TEMP_MIN; t <= TEMP_MAX; t++) {
+        for (int a = AIR_MIN; a <= AIR_MAX; a++) {
+            for (int s = SOIL_MIN; s <= SOIL_MAX; s++, bit++) {
+                if (exactDecision(t, a, s)) {
+                    table[bit >> 3] |= (unsigned char)(1 << (bit & 7));
+                    onCount++;
+                }
+            }
+        }
+    }
+
+    FILE *out = std::fopen(path, "w");
+    if (!out) {
+        std::fprintf(stderr, "Erro: não foi possível criar %s\n", path);
+        return 1;
+    }
+    std::fprintf(out, "#ifndef MODEL_LUT_H\n");
+    std::fprintf(out, "#define MODEL_LUT_H\n\n");
+    std::fprintf(out, "// Gerado por host/knn_lut_gen a partir de model_data.h (%d protótipos, k=%d).\n",
+                 N_TRAIN_REDUCED, N_NEIGHBORS);
+    std::fprintf(out, "// Bit ((t - TEMP_MIN) * N_AIR + (a - AIR_MIN)) * N_SOIL + (s - SOIL_MIN), LSB primeiro.\n\n");
+    std::fprintf(out, "// Modelo de origem (conferido por knn_lut.h)\n");
+    std::fprintf(out, "#define LUT_N_TRAIN_REDUCED %d\n#define LUT_N_NEIGHBORS %d\n", N_TRAIN_REDUCED, N_NEIGHBORS);
+    std::fprintf(out, "#define LUT_MODEL_FINGERPRINT 0x%08xu\n\n", (unsigned)knn_model_fingerprint());
+    std::fprintf(out, "#define LUT_TEMP_MIN %d\n#define LUT_TEMP_MAX %d\n", TEMP_MIN, TEMP_MAX);
+    std::fprintf(out, "#define LUT_AIR_MIN %d\n#define LUT_AIR_MAX %d\n", AIR_MIN, AIR_MAX);
+    std::fprintf(out, "#define LUT_SOIL_MIN %d\n#define LUT_SOIL_MAX %d\n\n", SOIL_MIN, SOIL_MAX);
+    std::fprintf(out, "static const unsigned char knn_lut[] = {\n");
+    for (size_t i = 0; i < table.size(); i++) {
+        if (i % 16 == 0) std::fprintf(out, "    ");
+        std::fprintf(out, "0x%02x", table[i]);
+        if (i < table.size() - 1) std::fprintf(out, (i % 16 == 15) ? ",\n" : ", ");
+    }
+    std::fprintf(out, "\n};\n\n#endif // MODEL_LUT_H\n");
+    std::fclose(out);
+
+    std::printf("Tabela gravada em %s\n", path);
+    std::printf("Grade: %ld x %ld x %ld = %ld entradas (%zu bytes)\n", nTemp, nAir, nSoil, nBits, table.size());
+    std::printf("Decisões ON: %ld (%.2f%%)\n", onCount, 100.0 * onCount / nBits);
+    return 0;
+}
+
+static int verify() {
+#ifdef HAS_MODEL_LUT
+    if (!knn_lut_matches_model()) {
+        std::fprintf(stderr, "Erro: model_lut.h é de outro modelo (impressão digital 0x%08x, model_data.h 0x%08x); "
+                             "gere a tabela de novo\n",
+                     (unsigned)LUT_MODEL_FINGERPRINT, (unsigned)knn_model_fingerprint());
+        return 1;
+    }
+    long checked = 0;
+    long mismatches = 0;
+    for (int t = LUT_TEMP_MIN; t <= LUT_TEMP_MAX; t++) {
+        for (int a = LUT_AIR_MIN; a <= LUT_AIR_MAX; a++) {
+            for (int s = LUT_SOIL_MIN; s <= LUT_SOIL_MAX; s++) {
+                int tableDecision = -1;
+                if (!knn_lut_lookup((float)t, (float)a, (float)s, &tableDecision) ||
+                    tableDecision != exactDecision(t, a, s)) {
+                    if (mismatches < 10) {
+                        std::fprintf(stderr, "Divergência em T=%d Ar=%d Solo=%d\n", t, a, s);
+                    }
+                    mismatches++;
+                }
+                checked++;
+            }
+        }
+    }
+    std::printf("Tabela vs KNN exato: %ld pontos conferidos, %ld divergências\n", checked, mismatches);
+    return mismatches == 0 ? 0 : 1;
+#else
+    std::fprintf(stderr, "Erro: model_lut.h não encontrado ou de outro model_data.h; gere a tabela primeiro\n");
+    return 1;
+#endif
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 && std::strcmp(argv[1], "--verify") == 0) {
+        return verify();
+    }
+    // Opção desconhecida (ex.: --verfy) não vira nome de arquivo
+    if (argc == 2 && argv[1][0] != '-') {
+        return generate(argv[1]);
+    }
+    std::fprintf(stderr, "Uso: %s <model_lut.h> | --verify\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,117 @@
+/*
+    Ferramenta do modelo binário (model.bin)
+
+    Exporta o modelo compilado (model_data.h) no formato de knn_model_blob.h
+    e confere arquivos gerados por ela ou pelo IA_simple.py. O arquivo é
+    aberto com mmap e usado sem cópia, como o firmware faz com a partição.
+
+    Uso:
+        knn_model_tool export model.bin     grava o blob do model_data.h
+        knn_model_tool info model.bin       valida e mostra o cabeçalho
+        knn_model_tool verify model.bin     valida e compara as decisões com
+                                            knn_predict() em toda a grade de
+                                            entradas (código de saída != 0 se
+                                            houver divergência)
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "knn.h"
+#include "knn_model_blob.h"
+#include "mapped_file.h"
+
+// ======= GRADE =======
+// Mesma grade de entradas inteiras do knn_lut_gen
+static const int TEMP_MIN = 0, TEMP_MAX = 50;
+static const int AIR_MIN = 0, AIR_MAX = 100;
+static const int SOIL_MIN = 0, SOIL_MAX = 100;
+
+static int exportModel(const char *path) {
+    std::vector<unsigned char> blob(knn_blob_size(N_FEATURES, N_TRAIN_REDUCED));
+    size_t size = knn_blob_build(blob.data(), blob.size(), X_train_reduced, y_train_reduced, N_TRAIN_REDUCED,
+                                 N_FEATURES, scaler_mean, scaler_scale, N_NEIGHBORS, N_CLASSES);
+    if (size == 0) {
+        std::fprintf(stderr, "Erro: falha ao montar o blob\n");
+        return 1;
+    }
+
+    FILE *out = std::fopen(path, "wb");
+    if (!out || std::fwrite(blob.data(), 1, size, out) != size) {
+        std::fprintf(stderr, "Erro: não foi possível gravar %s\n", path);
+        if (out) std::fclose(out);
+        return 1;
+    }
+    std::fclose(out);
+    std::printf("Modelo gravado em %s (%zu bytes, %d protótipos, k=%d)\n", path, size, N_TRAIN_REDUCED, N_NEIGHBORS);
+    return 0;
+}
+
+static bool openModel(const char *path, MappedFile &file, KnnBlobModel &model) {
+    if (!file.open(path)) {
+        std::fprintf(stderr, "Erro: não foi possível mapear %s\n", path);
+        return false;
+    }
+    KnnBlobStatus status = knn_blob_open(file.data(), file.size(), &model);
+    if (status != KNN_BLOB_OK) {
+        std::fprintf(stderr, "Erro: %s inválido: %s\n", path, knn_blob_status_text(status));
+        return false;
+    }
+    return true;
+}
+
+static int info(const char *path) {
+    MappedFile file;
+    KnnBlobModel model;
+    if (!openModel(path, file, model)) return 1;
+
+    std::printf("Arquivo:     %s (%zu bytes)\n", path, file.size());
+    std::printf("Versão:      %d\n", KNN_BLOB_VERSION);
+    std::printf("Protótipos:  %d x %d features\n", model.n_prototypes, model.n_features);
+    std::printf("k:           %d\n", model.n_neighbors);
+    std::printf("Classes:     %d\n", model.n_classes);
+    std::printf("CRC-32:      0x%08x\n", model.crc32);
+    std::printf("Scaler:     ");
+    for (int f = 0; f < model.n_features; f++) {
+        std::printf(" %.6f/%.6f", model.mean[f], model.scale[f]);
+    }
+    std::printf("\n");
+    return 0;
+}
+
+static int verify(const char *path) {
+    MappedFile file;
+    KnnBlobModel model;
+    if (!openModel(path, file, model)) return 1;
+
+    long checked = 0;
+    long mismatches = 0;
+    for (int t = TEMP_MIN; t <= TEMP_MAX; t++) {
+        for (int a = AIR_MIN; a <= AIR_MAX; a++) {
+            for (int s = SOIL_MIN; s <= SOIL_MAX; s++) {
+                float compiled[N_FEATURES] = {(float)t, (float)a, (float)s};
+                float loaded[N_FEATURES] = {(float)t, (float)a, (float)s};
+                standardize(compiled, N_FEATURES);
+                knn_blob_standardize(&model, loaded);
+                if (knn_blob_predict(&model, loaded) != knn_predict(compiled)) {
+                    if (mismatches < 10) {
+                        std::fprintf(stderr, "Divergência em T=%d Ar=%d Solo=%d\n", t, a, s);
+                    }
+                    mismatches++;
+                }
+                checked++;
+            }
+        }
+    }
+    std::printf("model.bin vs model_data.h: %ld pontos conferidos, %ld divergências\n", checked, mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && std::strcmp(argv[1], "export") == 0) return exportModel(argv[2]);
+    if (argc == 3 && std::strcmp(argv[1], "info") == 0) return info(argv[2]);
+    if (argc == 3 && std::strcmp(argv[1], "verify") == 0) return verify(argv[2]);
+    std::fprintf(stderr, "Uso: %s export|info|verify <model.bin>\n", argv[0]);
+    return 2;
+}
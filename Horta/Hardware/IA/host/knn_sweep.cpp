@@ -0,0 +1,191 @@
+/*
+    Varredura de tamanho do modelo KNN (N_CLUSTERS x K_NEIGHBORS)
+
+    Para cada número de protótipos treina o modelo reduzido com knn_train.h
+    (o k-means e a rotulagem não dependem de k) e, para cada k, mede no
+    conjunto de teste:
+    - acurácia com a busca linear e a votação do firmware (knn.h)
+    - latência de uma predição (1 thread, padronização incluída)
+    - flash do modelo: protótipos float + rótulos + scaler, e o total com a
+      KD-tree e os protótipos int16 que o model_data.h também leva
+
+    Os pontos não dominados (nenhum outro tem acurácia >= com latência e
+    flash <=) formam a fronteira de Pareto e são marcados com '*'. A tabela
+    sai no terminal e, com --out, em Markdown.
+
+    Uso:
+        knn_sweep [--csv TARP.csv] [--clusters 25,50,100,200,400] [--k 1,3,5,7]
+                  [--init 10] [--threads 0] [--out sweep.md]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "knn_train.h"
+#include "tarp_dataset.h"
+
+#ifndef HORTA_TARP_CSV
+#define HORTA_TARP_CSV "TARP.csv"
+#endif
+
+struct SweepPoint {
+    int clusters;
+    int k;
+    double accuracy;
+    double nsPerPrediction;
+    size_t flashFloat;   // X_train_reduced + y_train_reduced + scaler
+    size_t flashTotal;   // + kd_index + kd_split_dim + X_train_q
+    bool pareto;
+};
+
+static std::vector<int> parseList(const char *text) {
+    std::vector<int> values;
+    const char *p = text;
+    while (*p) {
+        char *end;
+        long value = std::strtol(p, &end, 10);
+        if (end == p) break;
+        if (value > 0) values.push_back((int)value);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+// Mesmos tipos do model_data.h gerado
+static void flashBytes(int clusters, size_t &floatModel, size_t &total) {
+    floatModel = clusters * N_FEATURES * sizeof(float) + clusters * sizeof(int) + 2 * N_FEATURES * sizeof(float);
+    total = floatModel + clusters * sizeof(unsigned short) + clusters * sizeof(unsigned char) +
+            clusters * N_FEATURES * sizeof(short);
+}
+
+// Latência de uma predição isolada, repetindo o teste até somar ~50 ms
+static double measureLatency(const KnnTrainedModel &model, const KnnTrainData &test) {
+    long long checksum = 0;
+    size_t predictions = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        for (size_t i = 0; i < test.size(); i++) {
+            checksum += knn_train_predict(model, &test.X[i * N_FEATURES]);
+        }
+        predictions += test.size();
+        elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 50e6);
+    if (checksum < 0) std::printf(" ");  // Impede que o laço seja descartado
+    return elapsed / predictions;
+}
+
+static bool dominates(const SweepPoint &a, const SweepPoint &b) {
+    bool noWorse = a.accuracy >= b.accuracy && a.nsPerPrediction <= b.nsPerPrediction && a.flashTotal <= b.flashTotal;
+    bool better = a.accuracy > b.accuracy || a.nsPerPrediction < b.nsPerPrediction || a.flashTotal < b.flashTotal;
+    return noWorse && better;
+}
+
+static void usage(const char *program) {
+    std::fprintf(stderr,
+                 "Uso: %s [--csv TARP.csv] [--clusters 25,50,100,200,400] [--k 1,3,5,7]\n"
+                 "          [--init 10] [--threads 0] [--out sweep.md]\n",
+                 program);
+}
+
+int main(int argc, char **argv) {
+    const char *csvPath = HORTA_TARP_CSV;
+    const char *outPath = NULL;
+    std::vector<int> clusterGrid = {25, 50, 100, 200, 400};
+    std::vector<int> kGrid = {1, 3, 5, 7};
+    KnnTrainConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *option = argv[i];
+        const char *value = argv[++i];
+        if (std::strcmp(option, "--csv") == 0) csvPath = value;
+        else if (std::strcmp(option, "--out") == 0) outPath = value;
+        else if (std::strcmp(option, "--clusters") == 0) clusterGrid = parseList(value);
+        else if (std::strcmp(option, "--k") == 0) kGrid = parseList(value);
+        else if (std::strcmp(option, "--init") == 0) config.n_init = std::atoi(value);
+        else if (std::strcmp(option, "--threads") == 0) config.n_threads = (unsigned)std::atoi(value);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (clusterGrid.empty() || kGrid.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    CsvTable table;
+    if (!loadTarpColumns(csvPath, table, config.n_threads)) return 1;
+    KnnTrainData all, train, test;
+    knn_train_from_columns(table.column(TARP_TEMPERATURE), table.column(TARP_STATUS), table.rows, all);
+    knn_train_split(all, config, train, test);
+    std::printf("Dataset: %s (treino %zu, teste %zu)\n", csvPath, train.size(), test.size());
+
+    // ======= VARREDURA =======
+    std::vector<SweepPoint> points;
+    for (size_t c = 0; c < clusterGrid.size(); c++) {
+        KnnTrainConfig runConfig = config;
+        runConfig.n_clusters = clusterGrid[c];
+        runConfig.k_neighbors = 1;
+        KnnTrainedModel model;
+        if (!knn_train_fit(train, runConfig, model)) {
+            std::fprintf(stderr, "Aviso: %d clusters ignorado (treino insuficiente)\n", clusterGrid[c]);
+            continue;
+        }
+        for (size_t j = 0; j < kGrid.size(); j++) {
+            if (kGrid[j] > model.n_clusters || kGrid[j] > KNN_TRAIN_MAX_NEIGHBORS) continue;
+            model.k_neighbors = kGrid[j];
+
+            SweepPoint point = {};
+            point.clusters = model.n_clusters;
+            point.k = kGrid[j];
+            point.accuracy = knn_train_accuracy(model, test, config.n_threads);
+            point.nsPerPrediction = measureLatency(model, test);
+            flashBytes(model.n_clusters, point.flashFloat, point.flashTotal);
+            points.push_back(point);
+            std::printf("  clusters=%-4d k=%-2d acurácia %.2f%%  %.1f ns\n", point.clusters, point.k,
+                        100.0 * point.accuracy, point.nsPerPrediction);
+        }
+    }
+
+    for (size_t i = 0; i < points.size(); i++) {
+        points[i].pareto = true;
+        for (size_t j = 0; j < points.size() && points[i].pareto; j++) {
+            if (j != i && dominates(points[j], points[i])) points[i].pareto = false;
+        }
+    }
+
+    // ======= TABELA =======
+    std::printf("\n%-9s %-3s %10s %10s %12s %12s %7s\n", "Clusters", "k", "Acurácia", "ns/pred", "Flash float",
+                "Flash total", "Pareto");
+    for (size_t i = 0; i < points.size(); i++) {
+        const SweepPoint &p = points[i];
+        std::printf("%-9d %-3d %9.2f%% %10.1f %12zu %12zu %7s\n", p.clusters, p.k, 100.0 * p.accuracy,
+                    p.nsPerPrediction, p.flashFloat, p.flashTotal, p.pareto ? "*" : "");
+    }
+
+    if (outPath != NULL) {
+        FILE *out = std::fopen(outPath, "w");
+        if (!out) {
+            std::fprintf(stderr, "Erro: não foi possível gravar %s\n", outPath);
+            return 1;
+        }
+        std::fprintf(out, "| Clusters | k | Acurácia | ns/predição (host) | Flash float (bytes) | Flash total (bytes) | Pareto |\n");
+        std::fprintf(out, "|----------|---|----------|--------------------|---------------------|---------------------|--------|\n");
+        for (size_t i = 0; i < points.size(); i++) {
+            const SweepPoint &p = points[i];
+            std::fprintf(out, "| %d | %d | %.2f%% | %.1f | %zu | %zu | %s |\n", p.clusters, p.k, 100.0 * p.accuracy,
+                         p.nsPerPrediction, p.flashFloat, p.flashTotal, p.pareto ? "*" : "");
+        }
+        std::fclose(out);
+        std::printf("\nTabela gravada em %s\n", outPath);
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+/*
+    Treinador nativo do modelo KNN (substitui o IA_simple.py)
+
+    Lê o TARP.csv (ou outro CSV com as mesmas colunas), treina o modelo
+    reduzido com knn_train.h e grava model_data.h no mesmo layout do
+    IA_simple.py. Não precisa de Python/pandas/sklearn na máquina de build.
+
+    Uso:
+        knn_train [--csv TARP.csv] [--out model_data.h] [--blob model.bin]
+                  [--clusters 100] [--k 3] [--init 10] [--sample 100000]
+                  [--seed 42] [--threads 0]
+                  [--condense 0.645] [--pool 20000] [--edit-k 15]
+                  [--tree model_tree.h] [--tree-depth 4] [--tree-leaf 20]
+                  [--conf-bins 10] [--conf-min 50]
+
+    Com --condense, os protótipos são selecionados por ENN + CNN até a
+    acurácia de validação indicada, no lugar do k-means; --clusters passa a
+    ser o limite de protótipos.
+
+    A confiança dos votos ponderados é calibrada no conjunto de teste
+    (--conf-bins faixas, 0 desliga) e gravada como knn_conf_calibration.
+    Faixas com menos de --conf-min amostras se juntam às vizinhas e a
+    tabela é forçada a crescer com a fração bruta (PAV).
+
+    Com --tree, treina também a árvore de decisão (tree_train.h) na mesma
+    divisão e grava model_tree.h para o TreeEngine do firmware.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "knn_train.h"
+#include "tree_train.h"
+#include "tarp_dataset.h"
+
+#ifndef HORTA_TARP_CSV
+#define HORTA_TARP_CSV "TARP.csv"
+#endif
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void usage(const char *program) {
+    std::fprintf(stderr,
+                 "Uso: %s [--csv TARP.csv] [--out model_data.h] [--blob model.bin]\n"
+                 "          [--clusters 100] [--k 3] [--init 10] [--sample 100000]\n"
+                 "          [--seed 42] [--threads 0] [--condense 0.645] [--pool 20000] [--edit-k 15]\n"
+                 "          [--tree model_tree.h] [--tree-depth 4] [--tree-leaf 20] [--conf-bins 10]\n"
+                 "          [--conf-min 50]\n",
+                 program);
+}
+
+int main(int argc, char **argv) {
+    const char *csvPath = HORTA_TARP_CSV;
+    const char *headerPath = "model_data.h";
+    const char *blobPath = NULL;
+    const char *treePath = NULL;
+    KnnTrainConfig config;
+    TreeTrainConfig treeConfig;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return 2;
+        }
+        const char *option = argv[i];
+        const char *value = argv[++i];
+        if (std::strcmp(option, "--csv") == 0) csvPath = value;
+        else if (std::strcmp(option, "--out") == 0) headerPath = value;
+        else if (std::strcmp(option, "--blob") == 0) blobPath = value;
+        else if (std::strcmp(option, "--clusters") == 0) config.n_clusters = std::atoi(value);
+        else if (std::strcmp(option, "--k") == 0) config.k_neighbors = std::atoi(value);
+        else if (std::strcmp(option, "--init") == 0) config.n_init = std::atoi(value);
+        else if (std::strcmp(option, "--sample") == 0) config.sample_size = std::strtoul(value, NULL, 10);
+        else if (std::strcmp(option, "--seed") == 0) config.random_state = (unsigned)std::atoi(value);
+        else if (std::strcmp(option, "--threads") == 0) config.n_threads = (unsigned)std::atoi(value);
+        else if (std::strcmp(option, "--condense") == 0) config.condense_target = std::atof(value);
+        else if (std::strcmp(option, "--pool") == 0) config.condense_pool = std::strtoul(value, NULL, 10);
+        else if (std::strcmp(option, "--edit-k") == 0) config.condense_edit_k = std::atoi(value);
+        else if (std::strcmp(option, "--conf-bins") == 0) config.conf_bins = std::atoi(value);
+        else if (std::strcmp(option, "--conf-min") == 0) config.conf_min_count = std::strtoul(value, NULL, 10);
+        else if (std::strcmp(option, "--tree") == 0) treePath = value;
+        else if (std::strcmp(option, "--tree-depth") == 0) treeConfig.max_depth = std::atoi(value);
+        else if (std::strcmp(option, "--tree-leaf") == 0) treeConfig.min_samples_leaf = std::strtoul(value, NULL, 10);
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // ======= CARGA =======
+    auto start = std::chrono::steady_clock::now();
+    CsvTable table;
+    if (!loadTarpColumns(csvPath, table, config.n_threads)) return 1;
+
+    KnnTrainData all;
+    knn_train_from_columns(table.column(TARP_TEMPERATURE), table.column(TARP_STATUS), table.rows, all);
+    size_t on = 0;
+    for (size_t i = 0; i < all.size(); i++) on += all.y[i];
+    const size_t totalRows = table.totalRows;
+    std::vector<float>().swap(table.values);  // Libera o CSV antes do treino
+    std::printf("Dataset carregado: %zu amostras válidas de %zu totais (%.2f s)\n", all.size(), totalRows,
+                secondsSince(start));
+    std::printf("Distribuição das classes: ON=%zu, OFF=%zu\n", on, all.size() - on);
+
+    // ======= TREINO =======
+    start = std::chrono::steady_clock::now();
+    KnnTrainData train, test;
+    knn_train_split(all, config, train, test);
+    std::printf("Treino: %zu, teste: %zu\n", train.size(), test.size());
+
+    KnnTrainedModel model;
+    if (!knn_train_fit(train, config, model)) {
+        std::fprintf(stderr, "Erro: parâmetros inválidos para %zu amostras de treino\n", train.size());
+        return 1;
+    }
+    size_t centersOn = 0;
+    for (size_t c = 0; c < model.y.size(); c++) centersOn += model.y[c] == 1;
+    if (config.condense_target > 0) {
+        std::printf("Condensação: %zu candidatos após ENN, %d protótipos em %d passadas, validação %.2f%% "
+                    "(alvo %.2f%%) (%.2f s, %u threads)\n",
+                    model.edited_pool, model.n_clusters, model.iterations, 100.0 * model.validation_accuracy,
+                    100.0 * config.condense_target, secondsSince(start), knn_train_threads(config.n_threads));
+    } else {
+        std::printf("K-means: %d clusters, inércia %.1f, %d iterações (%.2f s, %u threads)\n", model.n_clusters,
+                    model.inertia, model.iterations, secondsSince(start), knn_train_threads(config.n_threads));
+    }
+    std::printf("Distribuição dos clusters: ON=%zu, OFF=%zu\n", centersOn, model.y.size() - centersOn);
+
+    start = std::chrono::steady_clock::now();
+    double accuracy = knn_train_accuracy(model, test, config.n_threads);
+    std::printf("Acurácia do modelo reduzido (k=%d): %.2f%% (%.2f s)\n", model.k_neighbors, 100.0 * accuracy,
+                secondsSince(start));
+    knn_train_calibrate(model, test, config.conf_bins, config.conf_min_count, config.n_threads);
+    if (!model.calibration.empty()) {
+        std::printf("Calibração da confiança (%zu faixas):", model.calibration.size());
+        for (size_t b = 0; b < model.calibration.size(); b++) std::printf(" %.2f", model.calibration[b]);
+        std::printf("\n");
+    }
+
+    // ======= EXPORTAÇÃO =======
+    if (!knn_train_write_header(headerPath, model, config)) {
+        std::fprintf(stderr, "Erro: não foi possível gravar %s\n", headerPath);
+        return 1;
+    }
+    std::printf("Modelo exportado para: %s\n", headerPath);
+    if (blobPath != NULL) {
+        if (!knn_train_write_blob(blobPath, model)) {
+            std::fprintf(stderr, "Erro: não foi possível gravar %s\n", blobPath);
+            return 1;
+        }
+        std::printf("Modelo binário exportado para: %s\n", blobPath);
+    }
+
+    // ======= ÁRVORE DE DECISÃO =======
+    if (treePath != NULL) {
+        treeConfig.n_threads = config.n_threads;
+        start = std::chrono::steady_clock::now();
+        TreeModel tree;
+        if (!tree_train_fit(train, treeConfig, tree)) {
+            std::fprintf(stderr, "Erro: parâmetros inválidos para a árvore\n");
+            return 1;
+        }
+        std::printf("Árvore: profundidade %d, %d folhas, acurácia %.2f%% (%.2f s)\n", tree.depth, tree.leaves,
+                    100.0 * tree_train_accuracy(tree, test), secondsSince(start));
+        if (!tree_train_write_header(treePath, tree)) {
+            std::fprintf(stderr, "Erro: não foi possível gravar %s\n", treePath);
+            return 1;
+        }
+        std::printf("Árvore exportada para: %s\n", treePath);
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+    Arquivo mapeado em memória (somente leitura, POSIX)
+
+    Usado pelas ferramentas de host para abrir model.bin como o firmware faz
+    com a partição de dados, e pelo csv_mmap.h para ler datasets: o conteúdo
+    é lido direto do mapeamento, sem cópia. O endereço devolvido por mmap é
+    alinhado à página.
+*/
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const char *path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void *mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // O mapeamento continua válido sem o descritor
+        if (mapped == MAP_FAILED) return false;
+
+        madvise(mapped, (size_t)info.st_size, MADV_SEQUENTIAL);  // Leitura antecipada do kernel
+
+        data_ = mapped;
+        size_ = (size_t)info.st_size;
+        return true;
+    }
+
+    void close() {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+            data_ = nullptr;
+            size_ = 0;
+        }
+    }
+
+    const void *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    void *data_;
+    size_t size_;
+};
+
+#endif // MAPPED_FILE_H
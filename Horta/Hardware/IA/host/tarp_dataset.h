@@ -0,0 +1,69 @@
+/*
+    Leitura do TARP.csv nas ferramentas de host
+
+    Extrai as 3 features do modelo e o Status com o csv_mmap.h, descartando
+    linhas incompletas (igual ao dropna do IA_simple.py). Compartilhado pelo
+    knn_bench e pelo knn_train.
+*/
+
+#ifndef TARP_DATASET_H
+#define TARP_DATASET_H
+
+#include <cstdio>
+#include <vector>
+
+#include "csv_mmap.h"
+#include "knn.h"
+
+// Colunas de loadTarpColumns(): as features primeiro, no layout de knn_predict_batch()
+enum TarpColumn {
+    TARP_TEMPERATURE,
+    TARP_AIR_HUMIDITY,
+    TARP_SOIL_MOISTURE,
+    TARP_STATUS,        // 0 = OFF, 1 = ON
+    TARP_COLUMNS
+};
+
+struct Sample {
+    float features[N_FEATURES];  // Temperatura, Umidade do Ar, Umidade do Solo
+    int status;                  // 1 = ON, 0 = OFF
+};
+
+// Carrega as colunas do modelo. table.values começa com as N_FEATURES
+// colunas de features contíguas, prontas para knn_predict_batch().
+inline bool loadTarpColumns(const char *path, CsvTable &table, unsigned n_threads = 0) {
+    CsvMmap csv;
+    if (!csv.open(path)) {
+        std::fprintf(stderr, "Erro: não foi possível abrir %s\n", path);
+        return false;
+    }
+
+    static const char *const status[] = {"OFF", "ON"};
+    const CsvColumnSpec specs[TARP_COLUMNS] = {
+        {csv.column("Air temperature (C)"), NULL, 0},
+        {csv.column("Air humidity (%)"), NULL, 0},
+        {csv.column("Soil Moisture"), NULL, 0},
+        {csv.column("Status"), status, 2},
+    };
+    for (int i = 0; i < TARP_COLUMNS; i++) {
+        if (specs[i].index < 0) {
+            std::fprintf(stderr, "Erro: colunas esperadas não encontradas no cabeçalho\n");
+            return false;
+        }
+    }
+    return csv.read(specs, TARP_COLUMNS, table, n_threads);
+}
+
+// Mesmas amostras em linhas (uma Sample por linha válida)
+inline std::vector<Sample> tarpSamples(const CsvTable &table) {
+    std::vector<Sample> samples(table.rows);
+    for (size_t i = 0; i < table.rows; i++) {
+        for (int f = 0; f < N_FEATURES; f++) {
+            samples[i].features[f] = table.column(TARP_TEMPERATURE + f)[i];
+        }
+        samples[i].status = (int)table.column(TARP_STATUS)[i];
+    }
+    return samples;
+}
+
+#endif // TARP_DATASET_H
@@ -0,0 +1,147 @@
+/*
+    Motor de inferência do sistema de irrigação
+
+    shouldIrrigate() só precisa de uma decisão a partir das leituras cruas
+    dos sensores. InferenceEngine isola essa chamada do modelo usado:
+
+        const InferenceEngine &engine = treeEngine;
+        float input[N_FEATURES] = {temperatura, umidadeAr, umidadeSolo};
+        float confidence;
+        int decision = engine.predict(input, &confidence);   // 1 = irrigar
+
+    - KnnEngine: padroniza e chama knn_predict_confidence() (model_data.h,
+      com o caminho escolhido no build: linear, KD-tree ou int16)
+    - TreeEngine: tree_predict_confidence() gerado em model_tree.h
+      (knn_train --tree), só comparações sobre as leituras cruas
+    - MemoizedEngine: guarda as últimas decisões de outro motor, indexadas
+      pela entrada quantizada, para leituras repetidas não refazerem a busca
+
+    A confiança vai de 0 a 1 (calibrada no KNN, pureza da folha na árvore).
+    O firmware pode derivar outros motores (ex.: KNN com tabela ou com o
+    modelo da partição de dados) sem mudar a lógica de decisão.
+*/
+
+#ifndef INFERENCE_ENGINE_H
+#define INFERENCE_ENGINE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "knn.h"
+#include "model_tree.h"
+
+// ======= CACHE DE DECISÕES =======
+#ifndef INFERENCE_CACHE_SLOTS
+#define INFERENCE_CACHE_SLOTS 8       // Entradas distintas lembradas (substituição circular)
+#endif
+#ifndef INFERENCE_CACHE_SCALE
+#define INFERENCE_CACHE_SCALE 10.0f   // Chave com resolução de 0.1 (°C, %)
+#endif
+
+class InferenceEngine {
+public:
+    virtual ~InferenceEngine() {}
+
+    // input: N_FEATURES leituras cruas, na ordem do model_data.h. Devolve a
+    // classe e, em *confidence, a confiança da decisão.
+    virtual int predict(const float *input, float *confidence) const = 0;
+    virtual const char *name() const = 0;
+
+    int predict(const float *input) const {
+        float confidence;
+        return predict(input, &confidence);
+    }
+};
+
+class KnnEngine : public InferenceEngine {
+public:
+    using InferenceEngine::predict;
+    int predict(const float *input, float *confidence) const override {
+        float input_scaled[N_FEATURES];
+        for (int i = 0; i < N_FEATURES; i++) {
+            input_scaled[i] = input[i];
+        }
+        standardize(input_scaled, N_FEATURES);
+        return knn_predict_confidence(input_scaled, confidence);
+    }
+    const char *name() const override { return "knn"; }
+};
+
+class TreeEngine : public InferenceEngine {
+public:
+    using InferenceEngine::predict;
+    int predict(const float *input, float *confidence) const override {
+        return tree_predict_confidence(input, confidence);
+    }
+    const char *name() const override { return "tree"; }
+};
+
+// Leituras que caem na mesma célula de 1/INFERENCE_CACHE_SCALE reaproveitam
+// a decisão (e a confiança) da primeira. O DHT11 e o map() da umidade do
+// solo entregam valores inteiros, então no firmware a chave é exata.
+// Chame clear() sempre que o modelo do motor envolvido mudar.
+class MemoizedEngine : public InferenceEngine {
+public:
+    using InferenceEngine::predict;
+
+    explicit MemoizedEngine(const InferenceEngine &engine) : engine_(engine) { clear(); }
+
+    int predict(const float *input, float *confidence) const override {
+        int32_t key[N_FEATURES];
+        if (!makeKey(input, key)) {
+            misses_++;
+            return engine_.predict(input, confidence);
+        }
+        for (int i = 0; i < INFERENCE_CACHE_SLOTS; i++) {
+            const Entry &entry = entries_[i];
+            if (entry.valid && memcmp(entry.key, key, sizeof(key)) == 0) {
+                hits_++;
+                *confidence = entry.confidence;
+                return entry.label;
+            }
+        }
+
+        misses_++;
+        Entry &entry = entries_[next_];
+        next_ = (next_ + 1) % INFERENCE_CACHE_SLOTS;
+        memcpy(entry.key, key, sizeof(key));
+        entry.label = engine_.predict(input, &entry.confidence);
+        entry.valid = true;
+        *confidence = entry.confidence;
+        return entry.label;
+    }
+    const char *name() const override { return engine_.name(); }
+
+    void clear() {
+        for (int i = 0; i < INFERENCE_CACHE_SLOTS; i++) entries_[i].valid = false;
+        next_ = 0;
+    }
+    uint32_t hits() const { return hits_; }
+    uint32_t misses() const { return misses_; }
+
+private:
+    struct Entry {
+        int32_t key[N_FEATURES];
+        int label;
+        float confidence;
+        bool valid;
+    };
+
+    // Entradas não finitas ou fora da faixa de int32 não entram no cache
+    static bool makeKey(const float *input, int32_t *key) {
+        for (int i = 0; i < N_FEATURES; i++) {
+            float q = input[i] * INFERENCE_CACHE_SCALE;
+            if (!(q > -2.0e9f && q < 2.0e9f)) return false;
+            key[i] = (int32_t)lrintf(q);
+        }
+        return true;
+    }
+
+    const InferenceEngine &engine_;
+    mutable Entry entries_[INFERENCE_CACHE_SLOTS];
+    mutable int next_;
+    mutable uint32_t hits_ = 0;
+    mutable uint32_t misses_ = 0;
+};
+
+#endif // INFERENCE_ENGINE_H
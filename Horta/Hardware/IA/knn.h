@@ -0,0 +1,338 @@
+/*
+    Inferência KNN do sistema de irrigação (header-only)
+
+    Mesmo código usado pelo firmware (esp32IA.cpp) e pelas ferramentas de
+    host (host/knn_bench.cpp). Não depende do Arduino: compila tanto no
+    ESP32 quanto no Linux, sempre contra os arrays gerados em model_data.h.
+*/
+
+#ifndef KNN_H
+#define KNN_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "model_data.h"  // Header com os dados do modelo KNN
+
+// ======= PARÂMETROS DO MODELO KNN =======
+// Normalmente gerados em model_data.h; os valores abaixo são os do modelo original
+#ifndef N_FEATURES
+#define N_FEATURES 3
+#endif
+#ifndef N_TRAIN_REDUCED
+#define N_TRAIN_REDUCED 100
+#endif
+#ifndef N_NEIGHBORS
+#define N_NEIGHBORS 3
+#endif
+#ifndef N_CLASSES
+#define N_CLASSES 2
+#endif
+
+// Defina KNN_USE_KDTREE antes de incluir este header para que knn_predict()
+// use a KD-tree exportada em model_data.h em vez da busca linear, ou
+// KNN_USE_QUANTIZED para usar os protótipos int16 (X_train_q).
+#if defined(KNN_USE_KDTREE) && !defined(KD_LEAF_SIZE)
+#error "KNN_USE_KDTREE requer um model_data.h exportado com a KD-tree"
+#endif
+#if defined(KNN_USE_QUANTIZED) && !defined(KNN_Q_SHIFT)
+#error "KNN_USE_QUANTIZED requer um model_data.h exportado com EXPORT_QUANTIZED"
+#endif
+#if defined(KNN_USE_QUANTIZED) && defined(KNN_USE_KDTREE)
+#error "KNN_USE_QUANTIZED e KNN_USE_KDTREE são caminhos alternativos"
+#endif
+
+// ======= FUNÇÕES DO MODELO KNN =======
+inline void standardize(float *input, int n_features) {
+    for (int i = 0; i < n_features; i++) {
+        input[i] = (input[i] - scaler_mean[i]) / scaler_scale[i];
+    }
+}
+
+inline float euclidean_distance(const float *a, const float *b, int n_features) {
+    float distance = 0.0;
+    for (int i = 0; i < n_features; i++) {
+        float diff = a[i] - b[i];
+        distance += diff * diff;
+    }
+    return sqrt(distance);
+}
+
+// Insere (distância, índice) na lista ordenada dos k vizinhos. Empates de
+// distância ficam com o menor índice, exatamente como na busca linear.
+template <typename Distance>
+inline void knn_insert_neighbor(Distance distance, int index, Distance *min_distances, int *indices, int k) {
+    for (int j = 0; j < k; j++) {
+        if (distance < min_distances[j] ||
+            (distance == min_distances[j] && indices[j] >= 0 && index < indices[j])) {
+            for (int m = k - 1; m > j; m--) {
+                min_distances[m] = min_distances[m - 1];
+                indices[m] = indices[m - 1];
+            }
+            min_distances[j] = distance;
+            indices[j] = index;
+            return;
+        }
+    }
+}
+
+inline void knn_reset_neighbors(float *min_distances, int *indices, int k) {
+    for (int i = 0; i < k; i++) {
+        min_distances[i] = INFINITY;
+        indices[i] = -1;
+    }
+}
+
+// Busca linear (força bruta) sobre todos os protótipos
+inline void knn_search_linear(const float *input, const float *X, int n_train,
+                              float *min_distances, int *indices, int k) {
+    knn_reset_neighbors(min_distances, indices, k);
+    for (int i = 0; i < n_train; i++) {
+        float distance = euclidean_distance(input, &X[i * N_FEATURES], N_FEATURES);
+        knn_insert_neighbor(distance, i, min_distances, indices, k);
+    }
+}
+
+// ======= BUSCA NA KD-TREE =======
+// Árvore implícita gerada pelo IA_simple.py (build_kdtree): o nó [lo, hi)
+// tem o pivô em kd_index[mid], mid = lo + (hi - lo) / 2, e corta na dimensão
+// kd_split_dim[mid]. Intervalos com até leaf_size protótipos são folhas.
+inline void knn_kdtree_visit(const float *input, const float *X,
+                             const unsigned short *kd_index, const unsigned char *kd_split_dim,
+                             int leaf_size, int lo, int hi,
+                             float *min_distances, int *indices, int k) {
+    if (hi - lo <= leaf_size) {
+        for (int p = lo; p < hi; p++) {
+            int i = kd_index[p];
+            float distance = euclidean_distance(input, &X[i * N_FEATURES], N_FEATURES);
+            knn_insert_neighbor(distance, i, min_distances, indices, k);
+        }
+        return;
+    }
+
+    int mid = lo + (hi - lo) / 2;
+    int pivot = kd_index[mid];
+    int dim = kd_split_dim[mid];
+    knn_insert_neighbor(euclidean_distance(input, &X[pivot * N_FEATURES], N_FEATURES),
+                        pivot, min_distances, indices, k);
+
+    // Desce primeiro pelo lado da consulta
+    float gap = input[dim] - X[pivot * N_FEATURES + dim];
+    bool goLeft = gap < 0;
+    if (goLeft) {
+        knn_kdtree_visit(input, X, kd_index, kd_split_dim, leaf_size, lo, mid, min_distances, indices, k);
+    } else {
+        knn_kdtree_visit(input, X, kd_index, kd_split_dim, leaf_size, mid + 1, hi, min_distances, indices, k);
+    }
+
+    // O outro lado só é visitado se puder conter alguém tão perto quanto o
+    // k-ésimo vizinho. A cota usa as mesmas operações de euclidean_distance(),
+    // então nunca é maior que a distância calculada de um ponto do outro lado
+    // e a poda não altera o resultado (empates também são visitados).
+    float bound = sqrt(gap * gap);
+    if (bound > min_distances[k - 1]) return;
+    if (goLeft) {
+        knn_kdtree_visit(input, X, kd_index, kd_split_dim, leaf_size, mid + 1, hi, min_distances, indices, k);
+    } else {
+        knn_kdtree_visit(input, X, kd_index, kd_split_dim, leaf_size, lo, mid, min_distances, indices, k);
+    }
+}
+
+inline void knn_search_kdtree(const float *input, const float *X, int n_train,
+                              const unsigned short *kd_index, const unsigned char *kd_split_dim, int leaf_size,
+                              float *min_distances, int *indices, int k) {
+    knn_reset_neighbors(min_distances, indices, k);
+    knn_kdtree_visit(input, X, kd_index, kd_split_dim, leaf_size, 0, n_train, min_distances, indices, k);
+}
+
+// ======= PROTÓTIPOS QUANTIZADOS (int16) =======
+// X_train_q guarda uma coluna int16 por feature (n_train valores cada), em
+// ponto fixo com KNN_Q_SHIFT bits fracionários sobre os valores padronizados.
+// A distância é a soma dos quadrados em int32, sem sqrt: a ordem dos
+// vizinhos é a mesma e a comparação fica mais barata.
+#ifdef KNN_Q_SHIFT
+inline void knn_quantize_input(const float *input_scaled, int16_t *q_input) {
+    for (int f = 0; f < N_FEATURES; f++) {
+        float q = input_scaled[f] * (float)(1 << KNN_Q_SHIFT);
+        if (q > KNN_Q_MAX) q = KNN_Q_MAX;
+        if (q < -KNN_Q_MAX) q = -KNN_Q_MAX;
+        q_input[f] = (int16_t)lrintf(q);
+    }
+}
+
+// Processa 4 protótipos por iteração: as colunas são lidas em sequência e
+// os 4 acumuladores são independentes (vetorizável no host, e no ESP32
+// mantém os operandos em registradores).
+inline void knn_search_quantized(const int16_t *q_input, const short *Xq, int n_train,
+                                 int32_t *min_distances, int *indices, int k) {
+    for (int i = 0; i < k; i++) {
+        min_distances[i] = INT32_MAX;
+        indices[i] = -1;
+    }
+
+    int i = 0;
+    for (; i + 4 <= n_train; i += 4) {
+        int32_t d[4] = {0, 0, 0, 0};
+        for (int f = 0; f < N_FEATURES; f++) {
+            const short *column = &Xq[f * n_train + i];
+            int32_t x = q_input[f];
+            int32_t a = x - column[0];
+            int32_t b = x - column[1];
+            int32_t c = x - column[2];
+            int32_t e = x - column[3];
+            d[0] += a * a;
+            d[1] += b * b;
+            d[2] += c * c;
+            d[3] += e * e;
+        }
+        for (int j = 0; j < 4; j++) {
+            // Índices crescentes: empate nunca troca o vizinho já escolhido
+            if (d[j] < min_distances[k - 1]) {
+                knn_insert_neighbor(d[j], i + j, min_distances, indices, k);
+            }
+        }
+    }
+    for (; i < n_train; i++) {
+        int32_t distance = 0;
+        for (int f = 0; f < N_FEATURES; f++) {
+            int32_t diff = (int32_t)q_input[f] - Xq[f * n_train + i];
+            distance += diff * diff;
+        }
+        if (distance < min_distances[k - 1]) {
+            knn_insert_neighbor(distance, i, min_distances, indices, k);
+        }
+    }
+}
+#endif
+
+// ======= PREDIÇÃO =======
+// Vizinhos do modelo compilado (model_data.h), pelo caminho escolhido no build
+inline void knn_neighbors(const float *input, float *min_distances, int *indices) {
+#ifdef KNN_USE_KDTREE
+    knn_search_kdtree(input, X_train_reduced, N_TRAIN_REDUCED, kd_index, kd_split_dim, KD_LEAF_SIZE,
+                      min_distances, indices, N_NEIGHBORS);
+#else
+    knn_search_linear(input, X_train_reduced, N_TRAIN_REDUCED, min_distances, indices, N_NEIGHBORS);
+#endif
+}
+
+// Votação majoritária; empate fica com a menor classe
+inline int knn_vote_labels(const int *indices, const int *labels) {
+    int votes[N_CLASSES] = {0};
+    for (int i = 0; i < N_NEIGHBORS; i++) {
+        if (indices[i] >= 0) {
+            votes[labels[indices[i]]]++;
+        }
+    }
+
+    int best = 0;
+    for (int c = 1; c < N_CLASSES; c++) {
+        if (votes[c] > votes[best]) best = c;
+    }
+    return best;
+}
+
+inline int knn_vote(const int *indices) {
+    return knn_vote_labels(indices, y_train_reduced);
+}
+
+#ifdef KNN_Q_SHIFT
+inline int knn_predict_quantized(const float *input_scaled) {
+    int16_t q_input[N_FEATURES];
+    int32_t min_distances[N_NEIGHBORS];
+    int indices[N_NEIGHBORS];
+    knn_quantize_input(input_scaled, q_input);
+    knn_search_quantized(q_input, X_train_q, N_TRAIN_REDUCED, min_distances, indices, N_NEIGHBORS);
+    return knn_vote(indices);
+}
+#endif
+
+inline int knn_predict(const float *input) {
+#ifdef KNN_USE_QUANTIZED
+    return knn_predict_quantized(input);
+#else
+    float min_distances[N_NEIGHBORS];
+    int indices[N_NEIGHBORS];
+    knn_neighbors(input, min_distances, indices);
+    return knn_vote(indices);
+#endif
+}
+
+// ======= IDENTIFICAÇÃO DO MODELO =======
+// FNV-1a dos protótipos e rótulos de model_data.h: muda a cada novo modelo.
+// Tabelas geradas a partir dele (model_lut.h) e cópias persistidas (NVS do
+// aprendizado online) guardam esse valor para detectar um modelo trocado
+inline uint32_t knn_model_fingerprint() {
+    uint32_t hash = 2166136261u;
+    const unsigned char *bytes = (const unsigned char *)X_train_reduced;
+    for (size_t i = 0; i < sizeof(X_train_reduced); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    bytes = (const unsigned char *)y_train_reduced;
+    for (size_t i = 0; i < sizeof(y_train_reduced); i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// ======= CONFIANÇA =======
+// Cada vizinho vota com peso 1 / (distância + KNN_CONF_EPSILON); a confiança
+// bruta é a fração do peso total que foi para a classe decidida. O rótulo
+// continua sendo o da votação majoritária, então a confiança pode ficar
+// abaixo de 0.5 quando o vizinho da outra classe está bem mais perto.
+#ifndef KNN_CONF_EPSILON
+#define KNN_CONF_EPSILON 1e-3f
+#endif
+
+template <typename Label>
+inline float knn_weighted_share(const float *min_distances, const int *indices, const Label *labels, int k,
+                                int label) {
+    float total = 0.0f;
+    float share = 0.0f;
+    for (int i = 0; i < k; i++) {
+        if (indices[i] < 0) continue;
+        float weight = 1.0f / (min_distances[i] + KNN_CONF_EPSILON);
+        total += weight;
+        if ((int)labels[indices[i]] == label) share += weight;
+    }
+    return total > 0.0f ? share / total : 0.0f;
+}
+
+// model_data.h traz knn_conf_calibration: a acurácia de cada faixa de
+// confiança bruta, medida pelo knn_train (ou IA_simple.py) nos 20% do
+// TARP.csv separados para teste, fora do treino dos protótipos. Faixas com
+// poucas amostras se juntam e a tabela só cresce com a fração bruta. Sem a
+// tabela, a confiança é a bruta.
+inline float knn_calibrate_confidence(float share) {
+#ifdef KNN_CONF_BINS
+    int bin = (int)(share * KNN_CONF_BINS);
+    if (bin < 0) bin = 0;
+    if (bin >= KNN_CONF_BINS) bin = KNN_CONF_BINS - 1;
+    return knn_conf_calibration[bin];
+#else
+    return share;
+#endif
+}
+
+// knn_predict() com a confiança calibrada da decisão (0 a 1)
+inline int knn_predict_confidence(const float *input, float *confidence) {
+    float min_distances[N_NEIGHBORS];
+    int indices[N_NEIGHBORS];
+#ifdef KNN_USE_QUANTIZED
+    int16_t q_input[N_FEATURES];
+    int32_t q_distances[N_NEIGHBORS];
+    knn_quantize_input(input, q_input);
+    knn_search_quantized(q_input, X_train_q, N_TRAIN_REDUCED, q_distances, indices, N_NEIGHBORS);
+    for (int i = 0; i < N_NEIGHBORS; i++) {
+        min_distances[i] = sqrtf((float)q_distances[i]) / (float)(1 << KNN_Q_SHIFT);
+    }
+#else
+    knn_neighbors(input, min_distances, indices);
+#endif
+    int label = knn_vote(indices);
+    *confidence = knn_calibrate_confidence(
+        knn_weighted_share(min_distances, indices, y_train_reduced, N_NEIGHBORS, label));
+    return label;
+}
+
+#endif // KNN_H
@@ -0,0 +1,81 @@
+/*
+    Predição KNN em lote (somente host)
+
+    Classifica um buffer inteiro de amostras distribuindo o trabalho entre
+    todos os núcleos. Cada amostra passa por standardize() + knn_neighbors()
+    + knn_vote() de knn.h, ou seja, exatamente o código do firmware: rótulos
+    e distâncias são idênticos bit a bit aos de knn_predict().
+
+    Layout das entradas (column-major, valores brutos dos sensores):
+        columns[f * n_samples + i] = feature f da amostra i
+    Saídas:
+        labels[i]                        = classe prevista
+        distances[i * N_NEIGHBORS + j]   = distância do j-ésimo vizinho (opcional)
+*/
+
+#ifndef KNN_BATCH_H
+#define KNN_BATCH_H
+
+#include <stddef.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "knn.h"
+
+// Processa o intervalo [begin, end) de amostras
+inline void knn_predict_range(const float *columns, size_t n_samples, size_t begin, size_t end,
+                              int *labels, float *distances) {
+    for (size_t i = begin; i < end; i++) {
+        float input_scaled[N_FEATURES];
+        for (int f = 0; f < N_FEATURES; f++) {
+            input_scaled[f] = columns[f * n_samples + i];
+        }
+        standardize(input_scaled, N_FEATURES);
+
+        float min_distances[N_NEIGHBORS];
+        int indices[N_NEIGHBORS];
+        knn_neighbors(input_scaled, min_distances, indices);
+        labels[i] = knn_vote(indices);
+
+        if (distances != NULL) {
+            for (int j = 0; j < N_NEIGHBORS; j++) {
+                distances[i * N_NEIGHBORS + j] = min_distances[j];
+            }
+        }
+    }
+}
+
+// n_threads = 0 usa todos os núcleos disponíveis
+inline void knn_predict_batch(const float *columns, size_t n_samples, int *labels,
+                              float *distances = NULL, unsigned n_threads = 0) {
+    if (n_threads == 0) {
+        n_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    // Blocos pequenos não compensam o custo de criar threads
+    const size_t minChunk = 4096;
+    n_threads = (unsigned)std::min<size_t>(n_threads, std::max<size_t>(1, n_samples / minChunk));
+
+    if (n_threads <= 1) {
+        knn_predict_range(columns, n_samples, 0, n_samples, labels, distances);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads - 1);
+    const size_t chunk = (n_samples + n_threads - 1) / n_threads;
+    for (unsigned t = 1; t < n_threads; t++) {
+        size_t begin = t * chunk;
+        size_t end = std::min(n_samples, begin + chunk);
+        if (begin >= end) break;
+        workers.emplace_back(knn_predict_range, columns, n_samples, begin, end, labels, distances);
+    }
+    // A thread chamadora processa o primeiro bloco
+    knn_predict_range(columns, n_samples, 0, std::min(n_samples, chunk), labels, distances);
+
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+}
+
+#endif // KNN_BATCH_H
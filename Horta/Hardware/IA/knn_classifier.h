@@ -0,0 +1,219 @@
+/*
+    KnnClassifier<Features, K, Classes, Scalar>
+
+    Versão em template do knn_predict() de knn.h. O número de features, de
+    vizinhos e de classes são parâmetros de compilação, então a distância,
+    a lista dos k vizinhos e a votação são totalmente desenroladas pelo
+    compilador, sem laços genéricos em tempo de execução.
+
+    Funciona direto com os arrays gerados em model_data.h:
+    - Scalar = float: X_train_reduced (protótipos intercalados)
+    - Scalar = short: X_train_q (colunas int16 por feature, KNN_Q_SHIFT)
+
+    Exemplo (3 features, k=3, 2 classes):
+        static const KnnClassifier<3, 3, 2> knn(X_train_reduced, y_train_reduced,
+                                                N_TRAIN_REDUCED, scaler_mean, scaler_scale);
+        float input[3] = {temperatura, umidadeAr, umidadeSolo};
+        int decision = knn.predictRaw(input);
+
+    Para acrescentar uma feature (ex.: temperatura do solo) basta exportar
+    o modelo com 4 colunas e trocar o primeiro parâmetro do template.
+*/
+
+#ifndef KNN_CLASSIFIER_H
+#define KNN_CLASSIFIER_H
+
+#include <math.h>
+#include <stdint.h>
+
+// ======= TIPOS DE ARMAZENAMENTO =======
+template <typename Scalar> struct KnnScalarTraits;
+
+// Protótipos float intercalados [p0f0, p0f1, ..., p1f0, ...]
+template <> struct KnnScalarTraits<float> {
+    typedef float Distance;
+    static const bool columnMajor = false;
+    static float maxDistance() { return INFINITY; }
+    static float encode(float standardized) { return standardized; }
+};
+
+// Protótipos int16 em colunas [f0: p0, p1, ...][f1: p0, p1, ...]
+template <> struct KnnScalarTraits<short> {
+    typedef int32_t Distance;
+    static const bool columnMajor = true;
+    static int32_t maxDistance() { return INT32_MAX; }
+#ifdef KNN_Q_SHIFT
+    static const int shift = KNN_Q_SHIFT;
+    static const int maxValue = KNN_Q_MAX;
+#else
+    static const int shift = 10;       // Mesmos padrões do IA_simple.py
+    static const int maxValue = 8191;
+#endif
+    static short encode(float standardized) {
+        float q = standardized * (float)(1 << shift);
+        if (q > maxValue) q = maxValue;
+        if (q < -maxValue) q = -maxValue;
+        return (short)lrintf(q);
+    }
+};
+
+// ======= DESENROLAMENTO =======
+// Soma dos quadrados na mesma ordem de euclidean_distance() (feature 0 primeiro)
+template <int F, typename Scalar, typename Distance>
+struct KnnSquaredDistance {
+    static Distance sum(const Scalar *input, const Scalar *prototype, int stride) {
+        Distance diff = (Distance)input[F - 1] - (Distance)prototype[(F - 1) * stride];
+        return KnnSquaredDistance<F - 1, Scalar, Distance>::sum(input, prototype, stride) + diff * diff;
+    }
+};
+
+template <typename Scalar, typename Distance>
+struct KnnSquaredDistance<1, Scalar, Distance> {
+    static Distance sum(const Scalar *input, const Scalar *prototype, int) {
+        Distance diff = (Distance)input[0] - (Distance)prototype[0];
+        return diff * diff;
+    }
+};
+
+// Leva o candidato recém-colocado na posição J até seu lugar na lista
+// ordenada. Empates não trocam: o protótipo de menor índice fica na frente.
+template <int J, typename Distance>
+struct KnnSiftDown {
+    static void apply(Distance *distances, int *indices) {
+        if (distances[J] < distances[J - 1]) {
+            Distance d = distances[J];
+            distances[J] = distances[J - 1];
+            distances[J - 1] = d;
+            int i = indices[J];
+            indices[J] = indices[J - 1];
+            indices[J - 1] = i;
+            KnnSiftDown<J - 1, Distance>::apply(distances, indices);
+        }
+    }
+};
+
+template <typename Distance>
+struct KnnSiftDown<0, Distance> {
+    static void apply(Distance *, int *) {}
+};
+
+// Inicialização, padronização e votação desenroladas por índice
+template <int N>
+struct KnnUnroll {
+    template <typename Body>
+    static void run(Body &body) {
+        KnnUnroll<N - 1>::run(body);
+        body(N - 1);
+    }
+};
+
+template <>
+struct KnnUnroll<0> {
+    template <typename Body>
+    static void run(Body &) {}
+};
+
+// ======= CLASSIFICADOR =======
+template <int Features, int K, int Classes, typename Scalar = float>
+class KnnClassifier {
+public:
+    typedef KnnScalarTraits<Scalar> Traits;
+    typedef typename Traits::Distance Distance;
+
+    KnnClassifier(const Scalar *prototypes, const int *labels, int nPrototypes,
+                  const float *mean, const float *scale)
+        : prototypes_(prototypes), labels_(labels), nPrototypes_(nPrototypes), mean_(mean), scale_(scale) {}
+
+    // Padroniza a leitura bruta dos sensores com scaler_mean/scaler_scale
+    void standardize(const float *raw, Scalar *encoded) const {
+        Encode body = {raw, encoded, mean_, scale_};
+        KnnUnroll<Features>::run(body);
+    }
+
+    // Busca os K vizinhos de uma entrada já padronizada/codificada
+    void neighbors(const Scalar *input, Distance *distances, int *indices) const {
+        Reset reset = {distances, indices};
+        KnnUnroll<K>::run(reset);
+
+        const int stride = Traits::columnMajor ? nPrototypes_ : 1;
+        for (int i = 0; i < nPrototypes_; i++) {
+            const Scalar *prototype = Traits::columnMajor ? &prototypes_[i] : &prototypes_[i * Features];
+            Distance d = KnnSquaredDistance<Features, Scalar, Distance>::sum(input, prototype, stride);
+            if (d < distances[K - 1]) {
+                distances[K - 1] = d;
+                indices[K - 1] = i;
+                KnnSiftDown<K - 1, Distance>::apply(distances, indices);
+            }
+        }
+    }
+
+    // Votação majoritária; empate fica com a menor classe (como knn_predict)
+    int vote(const int *indices) const {
+        int votes[Classes];
+        ClearVotes clear = {votes};
+        KnnUnroll<Classes>::run(clear);
+        CountVotes count = {votes, indices, labels_};
+        KnnUnroll<K>::run(count);
+
+        int best = 0;
+        for (int c = 1; c < Classes; c++) {
+            if (votes[c] > votes[best]) best = c;
+        }
+        return best;
+    }
+
+    int predict(const Scalar *input) const {
+        Distance distances[K];
+        int indices[K];
+        neighbors(input, distances, indices);
+        return vote(indices);
+    }
+
+    int predictRaw(const float *raw) const {
+        Scalar encoded[Features];
+        standardize(raw, encoded);
+        return predict(encoded);
+    }
+
+    int size() const { return nPrototypes_; }
+
+private:
+    struct Encode {
+        const float *raw;
+        Scalar *encoded;
+        const float *mean;
+        const float *scale;
+        void operator()(int f) { encoded[f] = Traits::encode((raw[f] - mean[f]) / scale[f]); }
+    };
+
+    struct Reset {
+        Distance *distances;
+        int *indices;
+        void operator()(int j) {
+            distances[j] = Traits::maxDistance();
+            indices[j] = -1;
+        }
+    };
+
+    struct ClearVotes {
+        int *votes;
+        void operator()(int c) { votes[c] = 0; }
+    };
+
+    struct CountVotes {
+        int *votes;
+        const int *indices;
+        const int *labels;
+        void operator()(int j) {
+            if (indices[j] >= 0) votes[labels[indices[j]]]++;
+        }
+    };
+
+    const Scalar *prototypes_;
+    const int *labels_;
+    int nPrototypes_;
+    const float *mean_;
+    const float *scale_;
+};
+
+#endif // KNN_CLASSIFIER_H
@@ -0,0 +1,66 @@
+/*
+    Tabela de decisão pré-calculada do KNN
+
+    O DHT11 entrega temperatura e umidade do ar inteiras e a umidade do solo
+    vem de map(), também inteira (0-100). O espaço de entradas é pequeno o
+    bastante para guardar a decisão do KNN de cada combinação em 1 bit.
+
+    model_lut.h é gerado por host/knn_lut_gen a partir de model_data.h,
+    rodando o próprio knn_predict() de knn.h em todos os pontos da grade.
+    Entradas fora da grade (ou não inteiras) devem cair no KNN exato.
+
+    model_lut.h guarda o tamanho e a impressão digital do modelo de origem.
+    Tamanho diferente do model_data.h não compila. Com a impressão digital
+    diferente (protótipos novos, mesmo tamanho), knn_lut_lookup() recusa
+    toda entrada e a decisão volta ao KNN exato; knn_lut_gen --verify
+    (ctest knn_lut_verify) acusa a tabela velha no host.
+*/
+
+#ifndef KNN_LUT_H
+#define KNN_LUT_H
+
+#include "knn.h"
+#include "model_lut.h"
+
+#ifndef LUT_MODEL_FINGERPRINT
+#error "model_lut.h sem impressão digital do modelo: gere de novo com host/knn_lut_gen"
+#endif
+#if LUT_N_TRAIN_REDUCED != N_TRAIN_REDUCED || LUT_N_NEIGHBORS != N_NEIGHBORS
+#error "model_lut.h foi gerado para outro model_data.h: gere de novo com host/knn_lut_gen"
+#endif
+
+// Grade de entradas coberta pela tabela
+#define LUT_N_TEMP (LUT_TEMP_MAX - LUT_TEMP_MIN + 1)
+#define LUT_N_AIR (LUT_AIR_MAX - LUT_AIR_MIN + 1)
+#define LUT_N_SOIL (LUT_SOIL_MAX - LUT_SOIL_MIN + 1)
+
+// Posição do bit de (temperatura, umidade do ar, umidade do solo) na tabela
+inline long knn_lut_index(int temperature, int airHumidity, int soilMoisture) {
+    return ((long)(temperature - LUT_TEMP_MIN) * LUT_N_AIR + (airHumidity - LUT_AIR_MIN)) * LUT_N_SOIL +
+           (soilMoisture - LUT_SOIL_MIN);
+}
+
+// A tabela foi gerada a partir do model_data.h compilado?
+inline bool knn_lut_matches_model() { return knn_model_fingerprint() == (uint32_t)LUT_MODEL_FINGERPRINT; }
+
+// Calculado uma vez, na inicialização estática
+static const bool knn_lut_model_ok = knn_lut_matches_model();
+
+inline bool knn_lut_in_grid(float value, int min, int max) {
+    return value >= min && value <= max && value == (float)(int)value;
+}
+
+// Retorna false se a entrada não está na grade (ou a tabela é de outro
+// modelo); nesse caso use knn_predict()
+inline bool knn_lut_lookup(float temperature, float airHumidity, float soilMoisture, int *decision) {
+    if (!knn_lut_model_ok || !knn_lut_in_grid(temperature, LUT_TEMP_MIN, LUT_TEMP_MAX) ||
+        !knn_lut_in_grid(airHumidity, LUT_AIR_MIN, LUT_AIR_MAX) ||
+        !knn_lut_in_grid(soilMoisture, LUT_SOIL_MIN, LUT_SOIL_MAX)) {
+        return false;
+    }
+    long bit = knn_lut_index((int)temperature, (int)airHumidity, (int)soilMoisture);
+    *decision = (knn_lut[bit >> 3] >> (bit & 7)) & 1;
+    return true;
+}
+
+#endif // KNN_LUT_H
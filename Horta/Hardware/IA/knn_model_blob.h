@@ -0,0 +1,259 @@
+/*
+    Modelo KNN em formato binário (model.bin)
+
+    Alternativa ao model_data.h compilado no firmware: o mesmo modelo
+    (protótipos, rótulos, scaler, k) em um blob versionado e com CRC que
+    pode ser gravado numa partição de dados do ESP32 e usado direto da flash
+    mapeada em memória, sem cópia. Trocar o modelo passa a ser uma escrita
+    de poucos KB na partição em vez de recompilar e regravar o firmware.
+
+    Layout (little-endian, como o ESP32 e o host x86/ARM):
+        [0, 48)                 KnnBlobHeader
+        mean_offset             float[n_features]               scaler_mean
+        scale_offset            float[n_features]               scaler_scale
+        prototypes_offset       float[n_prototypes * n_features] X_train_reduced
+        labels_offset           int32[n_prototypes]             y_train_reduced
+    Cada seção começa em múltiplo de KNN_BLOB_ALIGN; o espaço entre seções
+    é zerado. O CRC-32 (IEEE, o mesmo do zlib.crc32) cobre o blob inteiro,
+    exceto o próprio campo crc32.
+
+    Gerado por IA_simple.py (save_model_to_blob) ou por host/knn_model_tool.
+*/
+
+#ifndef KNN_MODEL_BLOB_H
+#define KNN_MODEL_BLOB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "knn.h"
+
+// ======= FORMATO =======
+#define KNN_BLOB_MAGIC 0x4E4E4B48u  // "HKNN"
+#define KNN_BLOB_VERSION 1
+#define KNN_BLOB_ALIGN 16
+#define KNN_BLOB_MAX_NEIGHBORS 15
+#define KNN_BLOB_MAX_CLASSES 8
+
+struct KnnBlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint16_t n_features;
+    uint16_t n_prototypes;
+    uint16_t n_neighbors;
+    uint16_t n_classes;
+    uint32_t mean_offset;
+    uint32_t scale_offset;
+    uint32_t prototypes_offset;
+    uint32_t labels_offset;
+    uint32_t total_size;    // Cabeçalho + seções (a partição pode ser maior)
+    uint32_t reserved;
+    uint32_t crc32;
+    uint32_t padding;
+};
+static_assert(sizeof(KnnBlobHeader) == 48, "KnnBlobHeader precisa ter 48 bytes sem padding");
+
+// Visão sobre um blob validado: os ponteiros apontam para dentro do blob
+struct KnnBlobModel {
+    const float *mean;
+    const float *scale;
+    const float *X;
+    const int32_t *y;
+    int n_features;
+    int n_prototypes;
+    int n_neighbors;
+    int n_classes;
+    uint32_t crc32;
+};
+
+enum KnnBlobStatus {
+    KNN_BLOB_OK = 0,
+    KNN_BLOB_TOO_SMALL,     // Menor que o cabeçalho ou que total_size
+    KNN_BLOB_MISALIGNED,    // Endereço base não alinhado a 4 bytes
+    KNN_BLOB_BAD_MAGIC,     // Partição apagada (0xFF) ou outro conteúdo
+    KNN_BLOB_BAD_VERSION,
+    KNN_BLOB_BAD_LAYOUT,    // Seção fora do blob ou desalinhada
+    KNN_BLOB_UNSUPPORTED,   // n_features/k/classes incompatíveis com este build
+    KNN_BLOB_BAD_CRC,
+    KNN_BLOB_BAD_LABEL
+};
+
+inline const char *knn_blob_status_text(KnnBlobStatus status) {
+    switch (status) {
+        case KNN_BLOB_OK: return "ok";
+        case KNN_BLOB_TOO_SMALL: return "blob truncado";
+        case KNN_BLOB_MISALIGNED: return "endereço desalinhado";
+        case KNN_BLOB_BAD_MAGIC: return "assinatura inválida (partição vazia?)";
+        case KNN_BLOB_BAD_VERSION: return "versão não suportada";
+        case KNN_BLOB_BAD_LAYOUT: return "seções inválidas";
+        case KNN_BLOB_UNSUPPORTED: return "parâmetros incompatíveis";
+        case KNN_BLOB_BAD_CRC: return "CRC inválido";
+        case KNN_BLOB_BAD_LABEL: return "rótulo fora do intervalo";
+    }
+    return "?";
+}
+
+// ======= CRC-32 =======
+// Bit a bit, sem tabela: o blob é pequeno e só é conferido na carga
+inline uint32_t knn_blob_crc32_update(uint32_t crc, const unsigned char *data, size_t size) {
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+inline uint32_t knn_blob_crc32(const unsigned char *blob, size_t total_size) {
+    const size_t crcField = offsetof(KnnBlobHeader, crc32);
+    uint32_t crc = knn_blob_crc32_update(0, blob, crcField);
+    return knn_blob_crc32_update(crc, blob + crcField + 4, total_size - crcField - 4);
+}
+
+inline uint32_t knn_blob_align(uint32_t offset) {
+    return (offset + KNN_BLOB_ALIGN - 1) & ~(uint32_t)(KNN_BLOB_ALIGN - 1);
+}
+
+inline bool knn_blob_section_ok(uint32_t offset, uint32_t bytes, const KnnBlobHeader *header) {
+    return offset % KNN_BLOB_ALIGN == 0 && offset >= header->header_size &&
+           offset <= header->total_size && bytes <= header->total_size - offset;
+}
+
+// ======= LEITURA =======
+// Valida o blob e preenche a visão. Nada é copiado: o blob precisa continuar
+// mapeado enquanto o modelo estiver em uso.
+inline KnnBlobStatus knn_blob_open(const void *data, size_t size, KnnBlobModel *model) {
+    if (((uintptr_t)data & 3) != 0) return KNN_BLOB_MISALIGNED;
+    if (size < sizeof(KnnBlobHeader)) return KNN_BLOB_TOO_SMALL;
+
+    const unsigned char *blob = (const unsigned char *)data;
+    const KnnBlobHeader *header = (const KnnBlobHeader *)data;
+    if (header->magic != KNN_BLOB_MAGIC) return KNN_BLOB_BAD_MAGIC;
+    if (header->version != KNN_BLOB_VERSION || header->header_size != sizeof(KnnBlobHeader)) {
+        return KNN_BLOB_BAD_VERSION;
+    }
+    if (header->total_size < sizeof(KnnBlobHeader) || header->total_size > size) return KNN_BLOB_TOO_SMALL;
+
+    // O firmware sempre mede as mesmas 3 grandezas (N_FEATURES)
+    if (header->n_features != N_FEATURES || header->n_prototypes == 0 ||
+        header->n_neighbors < 1 || header->n_neighbors > KNN_BLOB_MAX_NEIGHBORS ||
+        header->n_neighbors > header->n_prototypes ||
+        header->n_classes < 2 || header->n_classes > KNN_BLOB_MAX_CLASSES) {
+        return KNN_BLOB_UNSUPPORTED;
+    }
+
+    const uint32_t featureBytes = header->n_features * sizeof(float);
+    const uint32_t prototypeBytes = (uint32_t)header->n_prototypes * featureBytes;
+    const uint32_t labelBytes = header->n_prototypes * sizeof(int32_t);
+    if (!knn_blob_section_ok(header->mean_offset, featureBytes, header) ||
+        !knn_blob_section_ok(header->scale_offset, featureBytes, header) ||
+        !knn_blob_section_ok(header->prototypes_offset, prototypeBytes, header) ||
+        !knn_blob_section_ok(header->labels_offset, labelBytes, header)) {
+        return KNN_BLOB_BAD_LAYOUT;
+    }
+
+    if (knn_blob_crc32(blob, header->total_size) != header->crc32) return KNN_BLOB_BAD_CRC;
+
+    const int32_t *labels = (const int32_t *)(blob + header->labels_offset);
+    for (int i = 0; i < header->n_prototypes; i++) {
+        if (labels[i] < 0 || labels[i] >= header->n_classes) return KNN_BLOB_BAD_LABEL;
+    }
+
+    model->mean = (const float *)(blob + header->mean_offset);
+    model->scale = (const float *)(blob + header->scale_offset);
+    model->X = (const float *)(blob + header->prototypes_offset);
+    model->y = labels;
+    model->n_features = header->n_features;
+    model->n_prototypes = header->n_prototypes;
+    model->n_neighbors = header->n_neighbors;
+    model->n_classes = header->n_classes;
+    model->crc32 = header->crc32;
+    return KNN_BLOB_OK;
+}
+
+// ======= ESCRITA =======
+inline size_t knn_blob_size(int n_features, int n_prototypes) {
+    uint32_t offset = knn_blob_align(sizeof(KnnBlobHeader));
+    offset = knn_blob_align(offset + n_features * sizeof(float));                  // mean
+    offset = knn_blob_align(offset + n_features * sizeof(float));                  // scale
+    offset = knn_blob_align(offset + n_prototypes * n_features * sizeof(float));   // X
+    return offset + n_prototypes * sizeof(int32_t);                                 // y
+}
+
+// Monta o blob em out (capacity >= knn_blob_size()). Retorna o tamanho
+// escrito, ou 0 se a capacidade não basta.
+inline size_t knn_blob_build(void *out, size_t capacity,
+                             const float *X, const int *y, int n_prototypes, int n_features,
+                             const float *mean, const float *scale, int n_neighbors, int n_classes) {
+    const size_t total = knn_blob_size(n_features, n_prototypes);
+    if (capacity < total) return 0;
+
+    unsigned char *blob = (unsigned char *)out;
+    memset(blob, 0, total);
+
+    KnnBlobHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = KNN_BLOB_MAGIC;
+    header.version = KNN_BLOB_VERSION;
+    header.header_size = sizeof(KnnBlobHeader);
+    header.n_features = (uint16_t)n_features;
+    header.n_prototypes = (uint16_t)n_prototypes;
+    header.n_neighbors = (uint16_t)n_neighbors;
+    header.n_classes = (uint16_t)n_classes;
+    header.mean_offset = knn_blob_align(sizeof(KnnBlobHeader));
+    header.scale_offset = knn_blob_align(header.mean_offset + n_features * sizeof(float));
+    header.prototypes_offset = knn_blob_align(header.scale_offset + n_features * sizeof(float));
+    header.labels_offset = knn_blob_align(header.prototypes_offset + n_prototypes * n_features * sizeof(float));
+    header.total_size = (uint32_t)total;
+
+    memcpy(blob + header.mean_offset, mean, n_features * sizeof(float));
+    memcpy(blob + header.scale_offset, scale, n_features * sizeof(float));
+    memcpy(blob + header.prototypes_offset, X, n_prototypes * n_features * sizeof(float));
+    for (int i = 0; i < n_prototypes; i++) {
+        int32_t label = y[i];
+        memcpy(blob + header.labels_offset + i * sizeof(int32_t), &label, sizeof(label));
+    }
+
+    memcpy(blob, &header, sizeof(header));
+    header.crc32 = knn_blob_crc32(blob, total);
+    memcpy(blob + offsetof(KnnBlobHeader, crc32), &header.crc32, sizeof(header.crc32));
+    return total;
+}
+
+// ======= PREDIÇÃO =======
+inline void knn_blob_standardize(const KnnBlobModel *model, float *input) {
+    for (int i = 0; i < model->n_features; i++) {
+        input[i] = (input[i] - model->mean[i]) / model->scale[i];
+    }
+}
+
+// Entrada já padronizada com knn_blob_standardize(). Mesma busca linear e
+// mesmo critério de desempate de knn.h, com k e classes lidos do blob.
+// confidence (opcional): fração do peso dos vizinhos (o blob não traz
+// tabela de calibração).
+inline int knn_blob_predict(const KnnBlobModel *model, const float *input_scaled, float *confidence = NULL) {
+    float min_distances[KNN_BLOB_MAX_NEIGHBORS];
+    int indices[KNN_BLOB_MAX_NEIGHBORS];
+    knn_search_linear(input_scaled, model->X, model->n_prototypes, min_distances, indices, model->n_neighbors);
+
+    int votes[KNN_BLOB_MAX_CLASSES] = {0};
+    for (int i = 0; i < model->n_neighbors; i++) {
+        if (indices[i] >= 0) {
+            votes[model->y[indices[i]]]++;
+        }
+    }
+
+    int best = 0;
+    for (int c = 1; c < model->n_classes; c++) {
+        if (votes[c] > votes[best]) best = c;
+    }
+    if (confidence) {
+        *confidence = knn_weighted_share(min_distances, indices, model->y, model->n_neighbors, best);
+    }
+    return best;
+}
+
+#endif // KNN_MODEL_BLOB_H
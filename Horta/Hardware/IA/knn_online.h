@@ -0,0 +1,99 @@
+/*
+    Aprendizado online dos protótipos do KNN (LVQ1)
+
+    Cada comando manual do operador (RPC setManualIrrigation) é um exemplo
+    rotulado: ligar a irrigação diz "irrigar" (1) nas condições atuais,
+    desligar diz "não irrigar" (0). Em vez de retreinar no Python e
+    regravar o model_data.h, o firmware mantém uma cópia dos protótipos em
+    RAM e ajusta o protótipo mais próximo a cada exemplo:
+    - mesmo rótulo: aproxima o protótipo da amostra
+    - rótulo diferente: afasta o protótipo da amostra
+
+    Memória fixa (N_TRAIN_REDUCED protótipos) e custo O(protótipos) por
+    atualização. A persistência (NVS no ESP32) fica a cargo de quem usa.
+
+    Como os protótipos se movem, a predição usa a busca linear: a KD-tree,
+    os protótipos int16 e a tabela de model_lut.h valem só para o modelo
+    gravado na flash.
+*/
+
+#ifndef KNN_ONLINE_H
+#define KNN_ONLINE_H
+
+#include <stdint.h>
+#include <string.h>
+#include "knn.h"
+
+// ======= PARÂMETROS DO LVQ =======
+#define LVQ_LEARNING_RATE 0.05f     // Passo inicial
+#define LVQ_MIN_LEARNING_RATE 0.005f
+#define LVQ_DECAY_UPDATES 200       // Passo cai pela metade a cada 200 atualizações (exponencial)
+#define LVQ_MAX_COORDINATE 8.0f     // Limite em desvios padrão (evita divergência ao afastar)
+
+struct KnnOnlineModel {
+    float X[N_TRAIN_REDUCED * N_FEATURES];
+    int y[N_TRAIN_REDUCED];
+    uint32_t updates;       // Atualizações desde o modelo da flash
+    uint32_t fingerprint;   // Identifica o model_data.h de origem
+};
+
+// Impressão digital do modelo da flash: um novo model_data.h invalida
+// cópias persistidas de um modelo anterior
+inline uint32_t knn_online_fingerprint() { return knn_model_fingerprint(); }
+
+// Recomeça a partir do modelo gravado na flash
+inline void knn_online_reset(KnnOnlineModel *model) {
+    memcpy(model->X, X_train_reduced, sizeof(model->X));
+    memcpy(model->y, y_train_reduced, sizeof(model->y));
+    model->updates = 0;
+    model->fingerprint = knn_online_fingerprint();
+}
+
+// Uma cópia persistida só é aproveitada se veio do mesmo model_data.h
+inline bool knn_online_is_compatible(const KnnOnlineModel *model) {
+    return model->fingerprint == knn_online_fingerprint();
+}
+
+// confidence (opcional): como em knn_predict_confidence(), com a calibração
+// do modelo da flash
+inline int knn_online_predict(const KnnOnlineModel *model, const float *input_scaled, float *confidence = NULL) {
+    float min_distances[N_NEIGHBORS];
+    int indices[N_NEIGHBORS];
+    knn_search_linear(input_scaled, model->X, N_TRAIN_REDUCED, min_distances, indices, N_NEIGHBORS);
+    int label = knn_vote_labels(indices, model->y);
+    if (confidence) {
+        *confidence = knn_calibrate_confidence(
+            knn_weighted_share(min_distances, indices, model->y, N_NEIGHBORS, label));
+    }
+    return label;
+}
+
+// Atualização LVQ1 com uma amostra padronizada e seu rótulo, só quando a
+// votação do modelo erra: reforçar acertos num dataset ruidoso só empurra
+// os protótipos para a sobreposição entre ON e OFF.
+// Retorna o índice do protótipo ajustado (-1 se a entrada for inválida ou
+// se o modelo já decide como o rótulo).
+inline int knn_online_update(KnnOnlineModel *model, const float *input_scaled, int label) {
+    if (label < 0 || label >= N_CLASSES) return -1;
+    if (knn_online_predict(model, input_scaled) == label) return -1;
+
+    float min_distance[1];
+    int nearest[1];
+    knn_search_linear(input_scaled, model->X, N_TRAIN_REDUCED, min_distance, nearest, 1);
+    if (nearest[0] < 0) return -1;  // Entrada com NaN
+
+    float rate = LVQ_LEARNING_RATE * exp2f(-(float)model->updates / LVQ_DECAY_UPDATES);
+    if (rate < LVQ_MIN_LEARNING_RATE) rate = LVQ_MIN_LEARNING_RATE;
+    if (model->y[nearest[0]] != label) rate = -rate;
+
+    float *prototype = &model->X[nearest[0] * N_FEATURES];
+    for (int f = 0; f < N_FEATURES; f++) {
+        prototype[f] += rate * (input_scaled[f] - prototype[f]);
+        if (prototype[f] > LVQ_MAX_COORDINATE) prototype[f] = LVQ_MAX_COORDINATE;
+        if (prototype[f] < -LVQ_MAX_COORDINATE) prototype[f] = -LVQ_MAX_COORDINATE;
+    }
+    model->updates++;
+    return nearest[0];
+}
+
+#endif // KNN_ONLINE_H
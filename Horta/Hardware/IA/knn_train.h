@@ -0,0 +1,989 @@
+/*
+    Treinamento do modelo KNN reduzido (somente host)
+
+    Versão nativa do pipeline do IA_simple.py, sem pandas/sklearn:
+    1. divisão treino/teste estratificada
+    2. padronização (média e desvio padrão populacional, como o StandardScaler)
+    3. k-means (k-means++ com n_init inicializações) sobre o treino padronizado
+    4. rótulo de cada centro = classe majoritária dos 10 pontos mais próximos
+       (ou, no lugar de 3 e 4, condensação ENN + CNN até uma acurácia alvo)
+    5. acurácia no teste com a mesma busca linear do firmware (knn.h)
+    6. model_data.h no mesmo layout do save_model_to_header (KD-tree e int16
+       incluídos) e, opcionalmente, model.bin
+
+    As etapas O(N * clusters) (atribuição do k-means, rotulagem e avaliação)
+    rodam em todos os núcleos. Com mais de sample_size amostras, as n_init
+    inicializações competem numa amostra aleatória e só a melhor é refinada
+    no conjunto completo.
+
+    Os números aleatórios (divisão e inicialização) não são os do numpy, então
+    os protótipos não saem idênticos aos do IA_simple.py para o mesmo
+    RANDOM_STATE; o formato e o procedimento são os mesmos.
+*/
+
+#ifndef KNN_TRAIN_H
+#define KNN_TRAIN_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "knn.h"
+#include "knn_model_blob.h"
+
+#define KNN_TRAIN_MAX_NEIGHBORS 15
+#define KNN_TRAIN_MAX_CLASSES 8
+
+// ======= CONFIGURAÇÃO =======
+// Padrões iguais às constantes do IA_simple.py
+struct KnnTrainConfig {
+    double test_size = 0.2;
+    unsigned random_state = 42;
+    int n_clusters = 100;           // N_CLUSTERS
+    int k_neighbors = 3;            // K_NEIGHBORS
+    int n_init = 10;                // Inicializações do k-means (melhor inércia vence)
+    int max_iter = 300;
+    double tol = 1e-4;              // Soma dos deslocamentos^2 dos centros (dados padronizados)
+    int label_neighbors = 10;       // Pontos usados para rotular cada centro
+    size_t sample_size = 100000;    // Amostra usada para escolher a inicialização
+    int kd_leaf_size = 8;           // KD_LEAF_SIZE
+    int q_shift = 10;               // Q_SHIFT
+    int q_max = 8191;               // Q_MAX
+    int conf_bins = 10;             // Faixas da calibração da confiança (0 = não exporta)
+    size_t conf_min_count = 50;     // Amostras mínimas por faixa (faixas menores se juntam)
+    unsigned n_threads = 0;         // 0 = todos os núcleos
+
+    // Condensação (no lugar do k-means quando condense_target > 0).
+    // n_clusters passa a ser o limite de protótipos.
+    double condense_target = 0;     // Acurácia de validação em que a seleção para
+    size_t condense_pool = 20000;   // Candidatos sorteados do treino (a edição é O(pool^2))
+    int condense_check = 5;         // Protótipos adicionados entre avaliações
+    int condense_edit_k = 15;       // Vizinhos da edição (ENN); maior = fronteira mais suave
+};
+
+// Amostras em linhas (N_FEATURES floats) e rótulos separados
+struct KnnTrainData {
+    std::vector<float> X;
+    std::vector<int> y;
+    size_t size() const { return y.size(); }
+};
+
+struct KnnTrainedModel {
+    std::vector<double> centers;    // Centros do k-means (n_clusters x N_FEATURES)
+    std::vector<float> X;           // Centros como gravados no header (%.6f)
+    std::vector<int> y;
+    double mean[N_FEATURES];
+    double scale[N_FEATURES];
+    float mean_f[N_FEATURES];       // Scaler como gravado no header
+    float scale_f[N_FEATURES];
+    int n_clusters = 0;
+    int k_neighbors = 0;
+    int n_classes = 0;
+    double inertia = 0;
+    int iterations = 0;             // Iterações do k-means ou passadas do CNN
+    double validation_accuracy = 0; // Só na condensação
+    size_t edited_pool = 0;         // Candidatos que sobraram da edição (ENN)
+    std::vector<float> calibration; // Acurácia por faixa de confiança bruta (knn_conf_calibration)
+};
+
+// ======= PARALELISMO =======
+inline unsigned knn_train_threads(unsigned n_threads) {
+    return n_threads != 0 ? n_threads : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Divide [0, n) em blocos contíguos, um por thread: work(begin, end, thread)
+template <typename Work>
+inline void knn_train_parallel(size_t n, unsigned n_threads, Work work) {
+    n_threads = (unsigned)std::min<size_t>(knn_train_threads(n_threads), std::max<size_t>(1, n));
+    if (n_threads <= 1) {
+        work(0, n, 0u);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads - 1);
+    const size_t chunk = (n + n_threads - 1) / n_threads;
+    for (unsigned t = 1; t < n_threads; t++) {
+        size_t begin = std::min(n, t * chunk);
+        size_t end = std::min(n, begin + chunk);
+        workers.emplace_back(work, begin, end, t);
+    }
+    work(0, std::min(n, chunk), 0u);
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+}
+
+// ======= PREPARAÇÃO =======
+// Converte colunas contíguas (features[f * rows + i], como em CsvTable) em linhas
+inline void knn_train_from_columns(const float *features, const float *labels, size_t rows, KnnTrainData &out) {
+    out.X.resize(rows * N_FEATURES);
+    out.y.resize(rows);
+    for (int f = 0; f < N_FEATURES; f++) {
+        for (size_t i = 0; i < rows; i++) out.X[i * N_FEATURES + f] = features[f * rows + i];
+    }
+    for (size_t i = 0; i < rows; i++) out.y[i] = (int)labels[i];
+}
+
+// Divisão estratificada: test_size de cada classe vai para o teste
+inline void knn_train_split(const KnnTrainData &all, const KnnTrainConfig &config,
+                            KnnTrainData &train, KnnTrainData &test) {
+    std::mt19937_64 rng(config.random_state);
+    std::vector<std::vector<size_t>> byClass;
+    for (size_t i = 0; i < all.size(); i++) {
+        if ((size_t)all.y[i] >= byClass.size()) byClass.resize(all.y[i] + 1);
+        byClass[all.y[i]].push_back(i);
+    }
+
+    std::vector<size_t> trainRows, testRows;
+    for (size_t c = 0; c < byClass.size(); c++) {
+        std::shuffle(byClass[c].begin(), byClass[c].end(), rng);
+        size_t nTest = (size_t)llround(config.test_size * byClass[c].size());
+        testRows.insert(testRows.end(), byClass[c].begin(), byClass[c].begin() + nTest);
+        trainRows.insert(trainRows.end(), byClass[c].begin() + nTest, byClass[c].end());
+    }
+    std::shuffle(trainRows.begin(), trainRows.end(), rng);
+    std::shuffle(testRows.begin(), testRows.end(), rng);
+
+    auto gather = [&](const std::vector<size_t> &rows, KnnTrainData &out) {
+        out.X.resize(rows.size() * N_FEATURES);
+        out.y.resize(rows.size());
+        for (size_t r = 0; r < rows.size(); r++) {
+            for (int f = 0; f < N_FEATURES; f++) {
+                out.X[r * N_FEATURES + f] = all.X[rows[r] * N_FEATURES + f];
+            }
+            out.y[r] = all.y[rows[r]];
+        }
+    };
+    gather(trainRows, train);
+    gather(testRows, test);
+}
+
+// StandardScaler: média e desvio padrão populacional (ddof = 0)
+inline void knn_train_fit_scaler(const KnnTrainData &train, KnnTrainedModel &model) {
+    const size_t n = train.size();
+    for (int f = 0; f < N_FEATURES; f++) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) sum += train.X[i * N_FEATURES + f];
+        double mean = sum / n;
+        double squares = 0;
+        for (size_t i = 0; i < n; i++) {
+            double diff = train.X[i * N_FEATURES + f] - mean;
+            squares += diff * diff;
+        }
+        double scale = sqrt(squares / n);
+        model.mean[f] = mean;
+        model.scale[f] = scale > 0 ? scale : 1.0;  // Feature constante: sklearn usa escala 1
+    }
+}
+
+inline std::vector<float> knn_train_standardize(const KnnTrainData &data, const KnnTrainedModel &model) {
+    std::vector<float> scaled(data.X.size());
+    for (size_t i = 0; i < data.size(); i++) {
+        for (int f = 0; f < N_FEATURES; f++) {
+            scaled[i * N_FEATURES + f] =
+                (float)((data.X[i * N_FEATURES + f] - model.mean[f]) / model.scale[f]);
+        }
+    }
+    return scaled;
+}
+
+// ======= K-MEANS =======
+inline float knn_train_squared_distance(const float *a, const float *b) {
+    float distance = 0;
+    for (int f = 0; f < N_FEATURES; f++) {
+        float diff = a[f] - b[f];
+        distance += diff * diff;
+    }
+    return distance;
+}
+
+// k-means++: cada novo centro é sorteado com probabilidade proporcional à
+// distância^2 até o centro mais próximo já escolhido
+inline std::vector<double> knn_train_kmeans_pp(const float *X, size_t n, int n_clusters, std::mt19937_64 &rng) {
+    std::vector<double> centers((size_t)n_clusters * N_FEATURES);
+    std::vector<double> closest(n);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    size_t first = std::min(n - 1, (size_t)(uniform(rng) * n));
+    for (int f = 0; f < N_FEATURES; f++) centers[f] = X[first * N_FEATURES + f];
+    double total = 0;
+    for (size_t i = 0; i < n; i++) {
+        float center[N_FEATURES];
+        for (int f = 0; f < N_FEATURES; f++) center[f] = (float)centers[f];
+        closest[i] = knn_train_squared_distance(&X[i * N_FEATURES], center);
+        total += closest[i];
+    }
+
+    for (int c = 1; c < n_clusters; c++) {
+        double target = uniform(rng) * total;
+        size_t chosen = n - 1;
+        for (size_t i = 0; i < n; i++) {
+            target -= closest[i];
+            if (target <= 0) {
+                chosen = i;
+                break;
+            }
+        }
+        float center[N_FEATURES];
+        for (int f = 0; f < N_FEATURES; f++) {
+            centers[c * N_FEATURES + f] = X[chosen * N_FEATURES + f];
+            center[f] = X[chosen * N_FEATURES + f];
+        }
+        total = 0;
+        for (size_t i = 0; i < n; i++) {
+            double d = knn_train_squared_distance(&X[i * N_FEATURES], center);
+            if (d < closest[i]) closest[i] = d;
+            total += closest[i];
+        }
+    }
+    return centers;
+}
+
+inline double knn_train_center_distance(const float *point, const double *center) {
+    double distance = 0;
+    for (int f = 0; f < N_FEATURES; f++) {
+        double diff = point[f] - center[f];
+        distance += diff * diff;
+    }
+    return sqrt(distance);
+}
+
+// Lloyd a partir de centers (atualizado no lugar), acelerado pelas cotas de
+// Hamerly: cada ponto guarda uma cota superior da distância ao seu centro e
+// uma inferior até o segundo mais próximo. Quando a superior não passa da
+// inferior (nem da metade da distância do centro ao vizinho mais próximo),
+// o centro não pode ter mudado e as distâncias não são recalculadas. O
+// resultado é o mesmo do Lloyd convencional.
+//
+// A atribuição é paralela: cada thread acumula somas e contagens próprias,
+// reduzidas no final. Retorna a inércia da atribuição final.
+inline double knn_train_lloyd(const float *X, size_t n, std::vector<double> &centers, int n_clusters,
+                              const KnnTrainConfig &config, int *iterations) {
+    const unsigned n_threads = (unsigned)std::min<size_t>(knn_train_threads(config.n_threads),
+                                                          std::max<size_t>(1, n / 4096));
+    std::vector<int> assigned(n);
+    std::vector<double> upper(n), lower(n);
+    std::vector<double> delta(n_clusters, 0.0), halfGap(n_clusters);
+    double maxDelta = 0;
+    std::vector<std::vector<double>> sums(n_threads, std::vector<double>(centers.size()));
+    std::vector<std::vector<size_t>> counts(n_threads, std::vector<size_t>(n_clusters));
+    std::vector<double> farthestDistance(n_threads);
+    std::vector<size_t> farthestPoint(n_threads);
+
+    int iter = 0;
+    while (iter < config.max_iter) {
+        iter++;
+        const bool firstPass = (iter == 1);
+
+        // Metade da distância de cada centro até o centro mais próximo
+        for (int c = 0; c < n_clusters; c++) {
+            double nearest = INFINITY;
+            for (int o = 0; o < n_clusters; o++) {
+                if (o == c) continue;
+                double distance = 0;
+                for (int f = 0; f < N_FEATURES; f++) {
+                    double diff = centers[c * N_FEATURES + f] - centers[o * N_FEATURES + f];
+                    distance += diff * diff;
+                }
+                nearest = std::min(nearest, distance);
+            }
+            halfGap[c] = 0.5 * sqrt(nearest);
+        }
+
+        knn_train_parallel(n, n_threads, [&](size_t begin, size_t end, unsigned t) {
+            std::vector<double> &sum = sums[t];
+            std::vector<size_t> &count = counts[t];
+            std::fill(sum.begin(), sum.end(), 0.0);
+            std::fill(count.begin(), count.end(), 0);
+            double farthest = -1;
+            size_t farthestIndex = 0;
+            for (size_t i = begin; i < end; i++) {
+                const float *point = &X[i * N_FEATURES];
+                bool scan = firstPass;
+                if (!firstPass) {
+                    upper[i] += delta[assigned[i]];
+                    lower[i] -= maxDelta;
+                    double bound = std::max(halfGap[assigned[i]], lower[i]);
+                    if (upper[i] > bound) {
+                        upper[i] = knn_train_center_distance(point, &centers[assigned[i] * N_FEATURES]);
+                        scan = upper[i] > bound;
+                    }
+                }
+                if (scan) {
+                    // Varredura completa: mais próximo e segundo mais próximo
+                    int best = 0;
+                    double bestDistance = INFINITY, secondDistance = INFINITY;
+                    for (int c = 0; c < n_clusters; c++) {
+                        double d = knn_train_center_distance(point, &centers[c * N_FEATURES]);
+                        if (d < bestDistance) {
+                            secondDistance = bestDistance;
+                            bestDistance = d;
+                            best = c;
+                        } else if (d < secondDistance) {
+                            secondDistance = d;
+                        }
+                    }
+                    assigned[i] = best;
+                    upper[i] = bestDistance;
+                    lower[i] = secondDistance;
+                }
+                const int c = assigned[i];
+                for (int f = 0; f < N_FEATURES; f++) sum[c * N_FEATURES + f] += point[f];
+                count[c]++;
+                if (upper[i] > farthest) {
+                    farthest = upper[i];
+                    farthestIndex = i;
+                }
+            }
+            farthestDistance[t] = farthest;
+            farthestPoint[t] = farthestIndex;
+        });
+
+        // Redução e novos centros
+        double shift = 0;
+        maxDelta = 0;
+        for (int c = 0; c < n_clusters; c++) {
+            size_t count = 0;
+            double sum[N_FEATURES] = {0};
+            for (unsigned t = 0; t < n_threads; t++) {
+                count += counts[t][c];
+                for (int f = 0; f < N_FEATURES; f++) sum[f] += sums[t][c * N_FEATURES + f];
+            }
+            if (count == 0) {
+                // Cluster vazio: reposiciona no ponto mais distante do seu centro
+                unsigned worst = 0;
+                for (unsigned t = 1; t < n_threads; t++) {
+                    if (farthestDistance[t] > farthestDistance[worst]) worst = t;
+                }
+                for (int f = 0; f < N_FEATURES; f++) {
+                    sum[f] = X[farthestPoint[worst] * N_FEATURES + f];
+                }
+                farthestDistance[worst] = -1;
+                count = 1;
+            }
+            double moved = 0;
+            for (int f = 0; f < N_FEATURES; f++) {
+                double updated = sum[f] / count;
+                double diff = updated - centers[c * N_FEATURES + f];
+                moved += diff * diff;
+                centers[c * N_FEATURES + f] = updated;
+            }
+            shift += moved;
+            delta[c] = sqrt(moved);
+            maxDelta = std::max(maxDelta, delta[c]);
+        }
+        if (shift <= config.tol) break;
+    }
+
+    // Inércia exata em relação aos centros finais
+    std::vector<double> inertias(n_threads, 0.0);
+    knn_train_parallel(n, n_threads, [&](size_t begin, size_t end, unsigned t) {
+        double local = 0;
+        for (size_t i = begin; i < end; i++) {
+            double d = knn_train_center_distance(&X[i * N_FEATURES], &centers[assigned[i] * N_FEATURES]);
+            local += d * d;
+        }
+        inertias[t] = local;
+    });
+    double inertia = 0;
+    for (unsigned t = 0; t < n_threads; t++) inertia += inertias[t];
+
+    if (iterations != NULL) *iterations = iter;
+    return inertia;
+}
+
+// n_init execuções de k-means++ + Lloyd; vence a de menor inércia
+inline std::vector<double> knn_train_kmeans(const float *X, size_t n, const KnnTrainConfig &config,
+                                            double *inertia, int *iterations) {
+    std::mt19937_64 rng(config.random_state);
+
+    // Amostra para escolher a inicialização quando o conjunto é grande
+    const float *initX = X;
+    size_t initN = n;
+    std::vector<float> sample;
+    if (n > config.sample_size) {
+        std::vector<size_t> rows(n);
+        for (size_t i = 0; i < n; i++) rows[i] = i;
+        for (size_t i = 0; i < config.sample_size; i++) {
+            std::uniform_int_distribution<size_t> pick(i, n - 1);
+            std::swap(rows[i], rows[pick(rng)]);
+        }
+        sample.resize(config.sample_size * N_FEATURES);
+        for (size_t i = 0; i < config.sample_size; i++) {
+            for (int f = 0; f < N_FEATURES; f++) sample[i * N_FEATURES + f] = X[rows[i] * N_FEATURES + f];
+        }
+        initX = sample.data();
+        initN = config.sample_size;
+    }
+
+    std::vector<double> best;
+    double bestInertia = INFINITY;
+    int bestIterations = 0;
+    for (int run = 0; run < config.n_init; run++) {
+        std::vector<double> centers = knn_train_kmeans_pp(initX, initN, config.n_clusters, rng);
+        int runIterations = 0;
+        double runInertia = knn_train_lloyd(initX, initN, centers, config.n_clusters, config, &runIterations);
+        if (runInertia < bestInertia) {
+            bestInertia = runInertia;
+            best = centers;
+            bestIterations = runIterations;
+        }
+    }
+
+    if (initX != X) {
+        bestInertia = knn_train_lloyd(X, n, best, config.n_clusters, config, &bestIterations);
+    }
+    if (inertia != NULL) *inertia = bestInertia;
+    if (iterations != NULL) *iterations = bestIterations;
+    return best;
+}
+
+// ======= ROTULAGEM DOS CENTROS =======
+// Classe majoritária entre os label_neighbors pontos de treino mais próximos
+// de cada centro (np.bincount().argmax(): empate fica com a menor classe)
+inline std::vector<int> knn_train_label_centers(const float *X, const int *y, size_t n,
+                                                const std::vector<float> &centers, int n_clusters,
+                                                int n_classes, const KnnTrainConfig &config) {
+    std::vector<int> labels(n_clusters);
+    const int k = std::min<int>(config.label_neighbors, (int)n);
+    knn_train_parallel(n_clusters, config.n_threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<float> minDistances(k);
+        std::vector<int> indices(k);
+        for (size_t c = begin; c < end; c++) {
+            knn_search_linear(&centers[c * N_FEATURES], X, (int)n, minDistances.data(), indices.data(), k);
+            int votes[KNN_TRAIN_MAX_CLASSES] = {0};
+            for (int j = 0; j < k; j++) {
+                if (indices[j] >= 0) votes[y[indices[j]]]++;
+            }
+            int best = 0;
+            for (int cl = 1; cl < n_classes; cl++) {
+                if (votes[cl] > votes[best]) best = cl;
+            }
+            labels[c] = best;
+        }
+    });
+    return labels;
+}
+
+// ======= VOTAÇÃO =======
+// Busca linear de knn.h + votação majoritária (empate fica com a menor classe)
+inline int knn_train_vote(const float *X, const int *y, int n, const float *input_scaled, int k, int n_classes) {
+    float min_distances[KNN_TRAIN_MAX_NEIGHBORS];
+    int indices[KNN_TRAIN_MAX_NEIGHBORS];
+    knn_search_linear(input_scaled, X, n, min_distances, indices, k);
+
+    int votes[KNN_TRAIN_MAX_CLASSES] = {0};
+    for (int i = 0; i < k; i++) {
+        if (indices[i] >= 0) votes[y[indices[i]]]++;
+    }
+    int best = 0;
+    for (int c = 1; c < n_classes; c++) {
+        if (votes[c] > votes[best]) best = c;
+    }
+    return best;
+}
+
+// ======= CONDENSAÇÃO (ENN + CNN) =======
+// Edição de Wilson (ENN): descarta os pontos que os próprios k vizinhos
+// classificam errado. Remove o ruído do meio das classes, que o CNN
+// guardaria como protótipo.
+inline std::vector<size_t> knn_train_edit(const float *X, const int *y, size_t n, int k, int n_classes,
+                                          unsigned n_threads) {
+    std::vector<unsigned char> keep(n, 0);
+    knn_train_parallel(n, n_threads, [&](size_t begin, size_t end, unsigned) {
+        float min_distances[KNN_TRAIN_MAX_NEIGHBORS + 1];
+        int indices[KNN_TRAIN_MAX_NEIGHBORS + 1];
+        for (size_t i = begin; i < end; i++) {
+            // k + 1 vizinhos: o próprio ponto (distância 0) é ignorado
+            knn_search_linear(&X[i * N_FEATURES], X, (int)n, min_distances, indices, k + 1);
+            int votes[KNN_TRAIN_MAX_CLASSES] = {0};
+            int counted = 0;
+            for (int j = 0; j <= k && counted < k; j++) {
+                if (indices[j] < 0 || (size_t)indices[j] == i) continue;
+                votes[y[indices[j]]]++;
+                counted++;
+            }
+            int best = 0;
+            for (int c = 1; c < n_classes; c++) {
+                if (votes[c] > votes[best]) best = c;
+            }
+            keep[i] = best == y[i];
+        }
+    });
+
+    std::vector<size_t> kept;
+    for (size_t i = 0; i < n; i++) {
+        if (keep[i]) kept.push_back(i);
+    }
+    return kept;
+}
+
+// CNN de Hart: um protótipo por classe e, em passadas sobre os candidatos,
+// todo ponto que o 1-NN dos protótipos atuais erra vira protótipo. Os
+// pontos absorvidos são os de perto da fronteira entre as classes. A cada
+// condense_check protótipos a acurácia (com k vizinhos, como no firmware) é
+// medida na validação; a seleção para ao atingir condense_target ou
+// max_prototypes. Se o alvo não for atingido, fica o prefixo de melhor
+// acurácia (os protótipos só são acrescentados).
+inline size_t knn_train_condense(const float *X, const int *y, const std::vector<size_t> &candidates,
+                                 const float *validX, const int *validY, size_t n_valid,
+                                 int k, int n_classes, int max_prototypes, const KnnTrainConfig &config,
+                                 std::mt19937_64 &rng, std::vector<float> &protoX, std::vector<int> &protoY,
+                                 double *accuracy, int *passes) {
+    protoX.clear();
+    protoY.clear();
+    std::vector<size_t> order(candidates);
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<unsigned char> absorbed(order.size(), 0);
+
+    auto add = [&](size_t slot) {
+        size_t i = order[slot];
+        protoX.insert(protoX.end(), &X[i * N_FEATURES], &X[i * N_FEATURES] + N_FEATURES);
+        protoY.push_back(y[i]);
+        absorbed[slot] = 1;
+    };
+    auto evaluate = [&]() {
+        const int n = (int)protoY.size();
+        std::vector<size_t> hits(knn_train_threads(config.n_threads), 0);
+        knn_train_parallel(n_valid, config.n_threads, [&](size_t begin, size_t end, unsigned t) {
+            size_t local = 0;
+            for (size_t i = begin; i < end; i++) {
+                if (knn_train_vote(protoX.data(), protoY.data(), n, &validX[i * N_FEATURES], k, n_classes) ==
+                    validY[i]) {
+                    local++;
+                }
+            }
+            hits[t] = local;
+        });
+        size_t total = 0;
+        for (size_t t = 0; t < hits.size(); t++) total += hits[t];
+        return n_valid > 0 ? (double)total / n_valid : 0.0;
+    };
+
+    // Semente: o primeiro candidato de cada classe
+    for (int c = 0; c < n_classes; c++) {
+        for (size_t slot = 0; slot < order.size(); slot++) {
+            if (y[order[slot]] == c) {
+                add(slot);
+                break;
+            }
+        }
+    }
+
+    double bestAccuracy = evaluate();
+    size_t bestSize = protoY.size();
+    bool done = bestAccuracy >= config.condense_target;
+    int pass = 0;
+    size_t sinceCheck = 0;
+    while (!done) {
+        pass++;
+        bool changed = false;
+        for (size_t slot = 0; slot < order.size() && !done; slot++) {
+            if (absorbed[slot]) continue;
+            size_t i = order[slot];
+            if (knn_train_vote(protoX.data(), protoY.data(), (int)protoY.size(), &X[i * N_FEATURES], 1, n_classes) ==
+                y[i]) {
+                continue;
+            }
+            add(slot);
+            changed = true;
+            if (++sinceCheck >= (size_t)config.condense_check || (int)protoY.size() >= max_prototypes) {
+                sinceCheck = 0;
+                double current = evaluate();
+                if (current > bestAccuracy) {
+                    bestAccuracy = current;
+                    bestSize = protoY.size();
+                }
+                done = current >= config.condense_target || (int)protoY.size() >= max_prototypes;
+            }
+        }
+        if (!changed) break;  // Convergiu: o 1-NN acerta todos os candidatos
+    }
+    if (sinceCheck > 0) {
+        double current = evaluate();
+        if (current > bestAccuracy) {
+            bestAccuracy = current;
+            bestSize = protoY.size();
+        }
+    }
+
+    // Prefixo com a melhor acurácia (o último, se atingiu o alvo)
+    if (bestAccuracy < config.condense_target || protoY.size() > bestSize) {
+        protoX.resize(bestSize * N_FEATURES);
+        protoY.resize(bestSize);
+    }
+    if (accuracy != NULL) *accuracy = bestAccuracy;
+    if (passes != NULL) *passes = pass;
+    return protoY.size();
+}
+
+// Valor exato que o compilador lê de "%.6f" no model_data.h
+inline float knn_train_header_float(double value) {
+    char text[64];
+    snprintf(text, sizeof(text), "%.6f", value);
+    return strtof(text, NULL);
+}
+
+// ======= PIPELINE =======
+// Condensação: o treino é dividido de novo em candidatos e validação (o
+// teste fica intocado para a avaliação final)
+inline bool knn_train_fit_condensed(const KnnTrainData &train, const KnnTrainConfig &config, int n_classes,
+                                    KnnTrainedModel &model) {
+    KnnTrainConfig splitConfig = config;
+    splitConfig.random_state = config.random_state + 1;
+    KnnTrainData fitPart, validation;
+    knn_train_split(train, splitConfig, fitPart, validation);
+
+    std::vector<float> fitX = knn_train_standardize(fitPart, model);
+    std::vector<float> validX = knn_train_standardize(validation, model);
+
+    // Candidatos: amostra de até condense_pool pontos
+    std::mt19937_64 rng(config.random_state);
+    std::vector<size_t> pool(fitPart.size());
+    for (size_t i = 0; i < pool.size(); i++) pool[i] = i;
+    if (pool.size() > config.condense_pool) {
+        std::shuffle(pool.begin(), pool.end(), rng);
+        pool.resize(config.condense_pool);
+        std::sort(pool.begin(), pool.end());
+    }
+    std::vector<float> poolX(pool.size() * N_FEATURES);
+    std::vector<int> poolY(pool.size());
+    for (size_t p = 0; p < pool.size(); p++) {
+        for (int f = 0; f < N_FEATURES; f++) poolX[p * N_FEATURES + f] = fitX[pool[p] * N_FEATURES + f];
+        poolY[p] = fitPart.y[pool[p]];
+    }
+
+    std::vector<size_t> edited = knn_train_edit(poolX.data(), poolY.data(), pool.size(), config.condense_edit_k,
+                                                n_classes, config.n_threads);
+    model.edited_pool = edited.size();
+    if (edited.empty()) return false;
+
+    std::vector<float> protoX;
+    std::vector<int> protoY;
+    knn_train_condense(poolX.data(), poolY.data(), edited, validX.data(), validation.y.data(), validation.size(),
+                       config.k_neighbors, n_classes, config.n_clusters, config, rng, protoX, protoY,
+                       &model.validation_accuracy, &model.iterations);
+    if ((int)protoY.size() < config.k_neighbors) return false;
+
+    model.n_clusters = (int)protoY.size();
+    model.centers.assign(protoX.begin(), protoX.end());
+    model.X.resize(protoX.size());
+    for (size_t i = 0; i < protoX.size(); i++) model.X[i] = knn_train_header_float(protoX[i]);
+    model.y = protoY;
+    model.n_classes = std::max(2, n_classes);
+    model.inertia = 0;
+    return true;
+}
+
+inline bool knn_train_fit(const KnnTrainData &train, const KnnTrainConfig &config, KnnTrainedModel &model) {
+    if (train.size() < (size_t)config.n_clusters || config.n_clusters < 1 ||
+        config.k_neighbors < 1 || config.k_neighbors > KNN_TRAIN_MAX_NEIGHBORS ||
+        config.k_neighbors > config.n_clusters) {
+        return false;
+    }
+
+    int maxLabel = 0;
+    for (size_t i = 0; i < train.size(); i++) {
+        if (train.y[i] < 0 || train.y[i] >= KNN_TRAIN_MAX_CLASSES) return false;
+        maxLabel = std::max(maxLabel, train.y[i]);
+    }
+
+    knn_train_fit_scaler(train, model);
+    model.k_neighbors = config.k_neighbors;
+    for (int f = 0; f < N_FEATURES; f++) {
+        model.mean_f[f] = knn_train_header_float(model.mean[f]);
+        model.scale_f[f] = knn_train_header_float(model.scale[f]);
+    }
+
+    if (config.condense_target > 0) {
+        return knn_train_fit_condensed(train, config, maxLabel + 1, model);
+    }
+
+    std::vector<float> scaled = knn_train_standardize(train, model);
+    model.n_clusters = config.n_clusters;
+    model.centers = knn_train_kmeans(scaled.data(), train.size(), config, &model.inertia, &model.iterations);
+
+    model.X.resize(model.centers.size());
+    for (size_t i = 0; i < model.centers.size(); i++) {
+        model.X[i] = knn_train_header_float(model.centers[i]);
+    }
+
+    // Rotula a partir dos centros em float32, como o IA_simple.py faz com cluster_centers_
+    std::vector<float> centersF(model.centers.begin(), model.centers.end());
+    model.y = knn_train_label_centers(scaled.data(), train.y.data(), train.size(), centersF,
+                                      config.n_clusters, maxLabel + 1, config);
+    int maxCenterLabel = 0;
+    for (size_t c = 0; c < model.y.size(); c++) maxCenterLabel = std::max(maxCenterLabel, model.y[c]);
+    model.n_classes = maxCenterLabel + 1;  // Como o IA_simple.py: max(y_train_reduced) + 1
+    if (model.n_classes < 2) model.n_classes = 2;
+    return true;
+}
+
+// ======= AVALIAÇÃO =======
+// Mesmo caminho do firmware: standardize() com o scaler gravado e busca linear de knn.h
+inline int knn_train_predict(const KnnTrainedModel &model, const float *raw) {
+    float input_scaled[N_FEATURES];
+    for (int f = 0; f < N_FEATURES; f++) {
+        input_scaled[f] = (raw[f] - model.mean_f[f]) / model.scale_f[f];
+    }
+    return knn_train_vote(model.X.data(), model.y.data(), model.n_clusters, input_scaled, model.k_neighbors,
+                          model.n_classes);
+}
+
+inline double knn_train_accuracy(const KnnTrainedModel &model, const KnnTrainData &test, unsigned n_threads) {
+    if (test.size() == 0) return 0;
+    const unsigned threads = knn_train_threads(n_threads);
+    std::vector<size_t> hits(threads);
+    knn_train_parallel(test.size(), threads, [&](size_t begin, size_t end, unsigned t) {
+        size_t local = 0;
+        for (size_t i = begin; i < end; i++) {
+            if (knn_train_predict(model, &test.X[i * N_FEATURES]) == test.y[i]) local++;
+        }
+        hits[t] = local;
+    });
+    size_t total = 0;
+    for (size_t t = 0; t < hits.size(); t++) total += hits[t];
+    return (double)total / test.size();
+}
+
+// ======= CALIBRAÇÃO DA CONFIANÇA =======
+// Acurácia por faixa a partir das contagens: faixas vizinhas se juntam até
+// somar min_count amostras (uma faixa com 1 amostra não vira 0% ou 100%) e
+// os grupos passam pelo PAV (pool adjacent violators), para que a confiança
+// calibrada nunca caia quando a fração bruta sobe
+inline std::vector<float> knn_train_calibration_table(const std::vector<size_t> &totals,
+                                                      const std::vector<size_t> &hits, size_t min_count) {
+    struct Group {
+        int first, last;
+        size_t total, hits;
+    };
+    const int n_bins = (int)totals.size();
+    std::vector<Group> groups;
+    for (int b = 0; b < n_bins; b++) {
+        if (groups.empty() || groups.back().total >= std::max<size_t>(min_count, 1)) {
+            groups.push_back(Group{b, b, 0, 0});
+        }
+        groups.back().last = b;
+        groups.back().total += totals[b];
+        groups.back().hits += hits[b];
+    }
+    // Sobra no fim com poucas amostras: junta com o grupo anterior
+    if (groups.size() > 1 && groups.back().total < min_count) {
+        Group tail = groups.back();
+        groups.pop_back();
+        groups.back().last = tail.last;
+        groups.back().total += tail.total;
+        groups.back().hits += tail.hits;
+    }
+
+    // PAV: junta grupos vizinhos enquanto a acurácia cair. Com mais de um
+    // grupo, todos têm amostras
+    std::vector<Group> pooled;
+    for (const Group &group : groups) {
+        pooled.push_back(group);
+        while (pooled.size() > 1) {
+            const Group &right = pooled[pooled.size() - 1];
+            const Group &left = pooled[pooled.size() - 2];
+            if ((double)left.hits * right.total <= (double)right.hits * left.total) break;
+            Group merged{left.first, right.last, left.total + right.total, left.hits + right.hits};
+            pooled.pop_back();
+            pooled.back() = merged;
+        }
+    }
+
+    std::vector<float> table(n_bins);
+    for (const Group &group : pooled) {
+        for (int b = group.first; b <= group.last; b++) {
+            // Sem nenhuma amostra de teste: fica a própria fração bruta (centro da faixa)
+            table[b] = group.total > 0 ? (float)group.hits / group.total : (b + 0.5f) / n_bins;
+        }
+    }
+    return table;
+}
+
+// Divide a confiança bruta de knn_weighted_share() em n_bins faixas e guarda
+// a acurácia observada em cada uma, medida em `test` (dados fora do treino)
+inline void knn_train_calibrate(KnnTrainedModel &model, const KnnTrainData &test, int n_bins, size_t min_count,
+                                unsigned n_threads) {
+    model.calibration.clear();
+    if (n_bins <= 0 || test.size() == 0) return;
+
+    const unsigned threads = knn_train_threads(n_threads);
+    std::vector<size_t> counts((size_t)threads * n_bins * 2, 0);  // [thread][faixa][total, acertos]
+    knn_train_parallel(test.size(), threads, [&](size_t begin, size_t end, unsigned t) {
+        size_t *local = &counts[(size_t)t * n_bins * 2];
+        for (size_t i = begin; i < end; i++) {
+            float input_scaled[N_FEATURES];
+            for (int f = 0; f < N_FEATURES; f++) {
+                input_scaled[f] = (test.X[i * N_FEATURES + f] - model.mean_f[f]) / model.scale_f[f];
+            }
+            float min_distances[KNN_TRAIN_MAX_NEIGHBORS];
+            int indices[KNN_TRAIN_MAX_NEIGHBORS];
+            knn_search_linear(input_scaled, model.X.data(), model.n_clusters, min_distances, indices,
+                              model.k_neighbors);
+            int votes[KNN_TRAIN_MAX_CLASSES] = {0};
+            for (int j = 0; j < model.k_neighbors; j++) {
+                if (indices[j] >= 0) votes[model.y[indices[j]]]++;
+            }
+            int label = 0;
+            for (int c = 1; c < model.n_classes; c++) {
+                if (votes[c] > votes[label]) label = c;
+            }
+            float share = knn_weighted_share(min_distances, indices, model.y.data(), model.k_neighbors, label);
+            int bin = std::min(n_bins - 1, std::max(0, (int)(share * n_bins)));
+            local[bin * 2]++;
+            if (label == test.y[i]) local[bin * 2 + 1]++;
+        }
+    });
+
+    std::vector<size_t> totals(n_bins, 0), hits(n_bins, 0);
+    for (int b = 0; b < n_bins; b++) {
+        for (unsigned t = 0; t < threads; t++) {
+            totals[b] += counts[((size_t)t * n_bins + b) * 2];
+            hits[b] += counts[((size_t)t * n_bins + b) * 2 + 1];
+        }
+    }
+    model.calibration = knn_train_calibration_table(totals, hits, min_count);
+}
+
+// ======= EXPORTAÇÃO =======
+// KD-tree implícita, idêntica ao build_kdtree() do IA_simple.py
+inline void knn_train_build_kdtree(const std::vector<double> &points, int n_points, int leaf_size,
+                                   std::vector<int> &kd_index, std::vector<int> &kd_split_dim) {
+    kd_index.resize(n_points);
+    kd_split_dim.assign(n_points, 0);
+    for (int i = 0; i < n_points; i++) kd_index[i] = i;
+
+    struct Builder {
+        const std::vector<double> &points;
+        std::vector<int> &index;
+        std::vector<int> &split;
+        int leaf;
+        void build(int lo, int hi) {
+            if (hi - lo <= leaf) return;
+            int dim = 0;
+            double bestSpread = -1;
+            for (int d = 0; d < N_FEATURES; d++) {
+                double lowest = INFINITY, highest = -INFINITY;
+                for (int p = lo; p < hi; p++) {
+                    double v = points[index[p] * N_FEATURES + d];
+                    lowest = std::min(lowest, v);
+                    highest = std::max(highest, v);
+                }
+                if (highest - lowest > bestSpread) {
+                    bestSpread = highest - lowest;
+                    dim = d;
+                }
+            }
+            std::sort(index.begin() + lo, index.begin() + hi, [&](int a, int b) {
+                double va = points[a * N_FEATURES + dim], vb = points[b * N_FEATURES + dim];
+                return va < vb || (va == vb && a < b);
+            });
+            int mid = lo + (hi - lo) / 2;
+            split[mid] = dim;
+            build(lo, mid);
+            build(mid + 1, hi);
+        }
+    };
+    Builder builder = {points, kd_index, kd_split_dim, leaf_size};
+    builder.build(0, n_points);
+}
+
+// Mesma formatação do write_int_array() do IA_simple.py
+inline void knn_train_write_int_array(FILE *out, const char *ctype, const char *name, const std::vector<int> &values) {
+    fprintf(out, "static const %s %s[] = {\n    ", ctype, name);
+    for (size_t i = 0; i < values.size(); i++) {
+        fprintf(out, "%d", values[i]);
+        if (i < values.size() - 1) {
+            fprintf(out, ", ");
+            if ((i + 1) % 15 == 0) fprintf(out, "\n    ");
+        }
+    }
+    fprintf(out, "\n};\n\n");
+}
+
+// model_data.h no layout do save_model_to_header() (com KD-tree e int16)
+inline bool knn_train_write_header(const char *path, const KnnTrainedModel &model, const KnnTrainConfig &config) {
+    FILE *out = fopen(path, "w");
+    if (!out) return false;
+
+    fprintf(out, "#ifndef MODEL_DATA_H\n");
+    fprintf(out, "#define MODEL_DATA_H\n\n");
+    fprintf(out, "#define N_FEATURES %d\n", N_FEATURES);
+    fprintf(out, "#define N_TRAIN_REDUCED %d\n", model.n_clusters);
+    fprintf(out, "#define N_NEIGHBORS %d\n", model.k_neighbors);
+    fprintf(out, "#define N_CLASSES %d\n\n", model.n_classes);
+
+    fprintf(out, "static const float X_train_reduced[] = {\n");
+    const size_t nValues = model.centers.size();
+    for (size_t i = 0; i < nValues; i++) {
+        if (i % N_FEATURES == 0) fprintf(out, "    ");
+        fprintf(out, "%.6f", model.centers[i]);
+        if (i < nValues - 1) {
+            fprintf(out, ",");
+            fprintf(out, (i + 1) % N_FEATURES == 0 ? "\n" : "    ");
+        }
+    }
+    fprintf(out, "\n};\n\n");
+
+    knn_train_write_int_array(out, "int", "y_train_reduced", model.y);
+
+    const double *scalers[2] = {model.mean, model.scale};
+    const char *scalerNames[2] = {"scaler_mean", "scaler_scale"};
+    for (int s = 0; s < 2; s++) {
+        fprintf(out, "static const float %s[] = {\n    ", scalerNames[s]);
+        for (int f = 0; f < N_FEATURES; f++) {
+            fprintf(out, "%.6f", scalers[s][f]);
+            if (f < N_FEATURES - 1) fprintf(out, ", ");
+        }
+        fprintf(out, "\n};\n\n");
+    }
+
+    std::vector<int> kd_index, kd_split_dim;
+    knn_train_build_kdtree(model.centers, model.n_clusters, config.kd_leaf_size, kd_index, kd_split_dim);
+    fprintf(out, "#define KD_LEAF_SIZE %d\n\n", config.kd_leaf_size);
+    knn_train_write_int_array(out, "unsigned short", "kd_index", kd_index);
+    knn_train_write_int_array(out, "unsigned char", "kd_split_dim", kd_split_dim);
+
+    // Protótipos int16 por coluna; nearbyint arredonda meio para par, como o round() do Python
+    std::vector<int> quantized;
+    quantized.reserve(nValues);
+    for (int f = 0; f < N_FEATURES; f++) {
+        for (int c = 0; c < model.n_clusters; c++) {
+            double q = nearbyint(model.centers[c * N_FEATURES + f] * (1 << config.q_shift));
+            quantized.push_back((int)std::max<double>(-config.q_max, std::min<double>(config.q_max, q)));
+        }
+    }
+    fprintf(out, "#define KNN_Q_SHIFT %d\n", config.q_shift);
+    fprintf(out, "#define KNN_Q_MAX %d\n\n", config.q_max);
+    knn_train_write_int_array(out, "short", "X_train_q", quantized);
+
+    if (!model.calibration.empty()) {
+        fprintf(out, "#define KNN_CONF_BINS %zu\n\n", model.calibration.size());
+        fprintf(out, "static const float knn_conf_calibration[] = {\n    ");
+        for (size_t b = 0; b < model.calibration.size(); b++) {
+            fprintf(out, "%.4f", model.calibration[b]);
+            if (b < model.calibration.size() - 1) fprintf(out, ", ");
+        }
+        fprintf(out, "\n};\n\n");
+    }
+
+    fprintf(out, "#endif // MODEL_DATA_H\n");
+    return fclose(out) == 0;
+}
+
+inline bool knn_train_write_blob(const char *path, const KnnTrainedModel &model) {
+    std::vector<unsigned char> blob(knn_blob_size(N_FEATURES, model.n_clusters));
+    size_t size = knn_blob_build(blob.data(), blob.size(), model.X.data(), model.y.data(), model.n_clusters,
+                                 N_FEATURES, model.mean_f, model.scale_f, model.k_neighbors, model.n_classes);
+    FILE *out = fopen(path, "wb");
+    if (!out) return false;
+    bool ok = size > 0 && fwrite(blob.data(), 1, size, out) == size;
+    return (fclose(out) == 0) && ok;
+}
+
+#endif // KNN_TRAIN_H
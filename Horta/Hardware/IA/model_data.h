@@ -1,125 +1,184 @@
 #ifndef MODEL_DATA_H
 #define MODEL_DATA_H
 
+#define N_FEATURES 3
+#define N_TRAIN_REDUCED 100
+#define N_NEIGHBORS 3
+#define N_CLASSES 2
+
 static const float X_train_reduced[] = {
-    -0.202309,    -1.320898,    0.879164,
-    -0.682291,    0.723587,    -0.056073,
-    0.409998,    -0.074046,    -1.479613,
-    1.129307,    -1.737193,    -1.448392,
-    -0.955501,    1.224367,    -1.027258,
-    -0.869033,    0.728862,    0.366400,
-    1.367304,    -0.887674,    0.161180,
-    0.387683,    -0.062161,    1.093895,
-    1.120255,    -1.727577,    1.459542,
-    -0.733384,    -1.150643,    -1.399532,
-    -1.306266,    1.127158,    1.327439,
-    0.088295,    0.137141,    -0.296494,
-    1.172439,    -1.725470,    0.045343,
-    -0.422590,    0.095649,    1.289995,
-    -0.414349,    0.586398,    -1.031655,
-    0.435893,    -1.622638,    -0.413339,
-    0.757557,    -0.372358,    0.924203,
-    1.063812,    -1.025074,    -1.375789,
-    -0.186802,    -1.342322,    0.066203,
-    1.753958,    -1.718301,    1.292585,
-    -0.885071,    1.213043,    -0.200177,
-    -0.920449,    1.202433,    1.583792,
-    0.393840,    -0.767390,    0.148526,
-    1.832365,    -1.722738,    -0.219322,
-    -0.927515,    -1.089135,    0.885656,
-    1.244548,    -0.570865,    0.772937,
-    -0.333603,    -0.369863,    -1.355265,
-    -0.319246,    0.516214,    -0.367447,
-    1.919953,    -0.997793,    0.781910,
-    -0.655909,    1.017040,    -1.108868,
-    -0.322212,    0.558630,    1.353070,
-    1.622081,    -0.893605,    -1.481383,
-    -0.272630,    -0.383153,    0.422854,
-    0.993266,    -0.406121,    -0.660476,
-    -1.348134,    1.158185,    -1.451693,
-    -0.749687,    0.527365,    -0.521563,
-    -0.258414,    -1.241477,    -0.758636,
-    1.801097,    -1.757241,    0.500818,
-    2.598794,    -1.335063,    0.481024,
-    -0.103842,    -1.283236,    -1.395097,
-    -0.951406,    1.211296,    0.908232,
-    1.031015,    -0.472504,    1.427051,
-    1.731676,    -0.998036,    -0.796643,
-    0.888795,    -0.389718,    -1.481765,
-    -0.934150,    0.711136,    -1.004229,
-    -0.218087,    0.448831,    0.227394,
-    0.140132,    -1.473214,    1.431226,
-    1.809289,    -1.758603,    -0.827782,
-    -0.690390,    0.920417,    -0.543260,
-    1.026995,    -1.769068,    0.802468,
-    -0.797230,    0.295323,    -1.429653,
-    0.497061,    -1.646190,    -1.257238,
-    1.782226,    -1.703083,    -1.465557,
-    -0.875450,    1.201600,    0.208615,
-    2.343865,    -1.319865,    1.400491,
-    -0.312006,    -0.491918,    -0.365212,
-    -1.419646,    1.159219,    0.555889,
-    0.014135,    0.163694,    -0.859376,
-    0.596836,    -0.247916,    -0.350130,
-    -0.865705,    -1.176978,    -0.365092,
-    1.521812,    -0.856446,    1.412875,
-    0.844455,    -0.333871,    0.377491,
-    -0.778876,    -1.098988,    1.479204,
-    0.082213,    0.190291,    1.488755,
-    -0.770429,    0.658829,    1.510939,
-    0.387064,    -0.059170,    0.071663,
-    1.351407,    -0.806440,    -0.452773,
-    2.498558,    -1.335704,    -0.613032,
-    -1.210730,    -0.058395,    1.076176,
-    -0.957849,    -1.038191,    0.242193,
-    -0.850949,    0.582096,    1.031224,
-    0.381987,    -0.641351,    -1.037705,
-    0.468807,    -1.598765,    0.457019,
-    -0.707143,    0.751120,    -1.533848,
-    1.107829,    -0.441702,    -0.040726,
-    2.007565,    -1.065839,    0.004987,
-    1.194168,    -1.720429,    -0.727532,
-    -1.403310,    1.160972,    -0.704283,
-    -1.224634,    1.189355,    -0.004918,
-    -1.174578,    0.666337,    -0.280585,
-    -0.878345,    1.200568,    0.566206,
-    1.396815,    -1.291240,    0.695865,
-    -0.001616,    0.221894,    0.761511,
-    -0.548993,    0.460760,    0.640928,
-    0.567516,    -0.205415,    1.499223,
-    0.522879,    -0.102288,    -0.917800,
-    1.202244,    -0.525555,    -1.111682,
-    -0.854786,    1.181512,    1.260142,
-    -0.220956,    -0.521159,    1.280936,
-    -0.691154,    0.147411,    0.076654,
-    2.412853,    -1.249532,    -1.369766,
-    -0.096255,    0.266820,    -1.453506,
-    -0.635507,    0.096953,    -0.781418,
-    -0.604524,    0.894238,    0.905272,
-    -1.042885,    -0.976454,    -0.995257,
-    -0.916585,    1.216426,    -0.600110,
-    -0.887006,    1.209790,    -1.495109,
-    0.768028,    -0.986330,    1.257443,
-    0.756528,    -0.945465,    -0.497461,
-    0.436107,    -0.125079,    0.560010
+    1.051464,    -1.719185,    0.783900,
+    -0.959961,    1.215169,    1.550044,
+    -0.911331,    1.202415,    -0.092093,
+    -0.672381,    0.709656,    1.517232,
+    0.767430,    -0.333969,    -1.433442,
+    1.801399,    -1.734068,    -0.835160,
+    1.778191,    -1.014395,    0.771372,
+    0.334886,    -0.037983,    0.265213,
+    -0.932695,    0.739347,    -0.952459,
+    -0.199245,    -0.523493,    -1.073626,
+    -0.120197,    -1.336533,    0.860008,
+    -0.598862,    -0.088043,    -1.404418,
+    -0.740376,    0.807827,    0.762123,
+    0.416487,    -0.681554,    -0.578308,
+    -0.786728,    0.774413,    0.242776,
+    1.041563,    -0.415891,    -0.545996,
+    0.498135,    -1.632001,    -1.227137,
+    1.689239,    -1.716569,    0.353726,
+    -0.296691,    0.451202,    0.398944,
+    0.473314,    -0.091308,    0.883610,
+    1.207130,    -0.544042,    0.789765,
+    -1.294936,    -0.862890,    1.084997,
+    -0.383738,    -0.366142,    -0.210767,
+    0.090194,    0.138181,    -0.939806,
+    -0.715749,    -1.170972,    -0.688931,
+    -0.751788,    0.684822,    -1.525021,
+    0.794895,    -0.951991,    -1.288421,
+    -1.362827,    1.171524,    -0.628928,
+    -0.910315,    1.202732,    -1.553383,
+    -1.397279,    1.187806,    1.098493,
+    0.599887,    -0.183610,    -0.905512,
+    -0.138604,    0.320844,    -1.463851,
+    -1.135332,    -0.914887,    -1.108506,
+    -1.096227,    0.689361,    1.371869,
+    -0.908334,    1.204743,    -1.203074,
+    -0.587856,    0.486474,    -0.091036,
+    0.337784,    -1.600839,    0.360745,
+    -0.157419,    -0.539428,    1.380992,
+    -0.149371,    -1.322223,    -0.732729,
+    1.189552,    -1.728386,    1.452851,
+    1.851952,    -1.726684,    -1.468140,
+    -0.053068,    0.187469,    0.854903,
+    -0.854947,    1.203646,    -0.467700,
+    1.745963,    -1.703349,    0.947973,
+    -0.132034,    -1.290000,    -1.386189,
+    -0.893171,    1.209566,    0.325858,
+    2.523288,    -1.391011,    1.346675,
+    -1.450452,    1.128090,    -1.453733,
+    1.192015,    -1.712189,    -0.652185,
+    -0.488272,    0.626523,    -1.097262,
+    -1.055430,    0.710361,    -0.257920,
+    1.835931,    -1.101654,    1.433296,
+    0.963561,    -0.423218,    1.427559,
+    -0.764125,    -1.123403,    1.370969,
+    0.364941,    -0.720509,    0.253747,
+    1.157399,    -1.718310,    -1.388227,
+    -0.364060,    -0.405041,    0.586769,
+    1.199792,    -0.947282,    -0.474811,
+    0.466834,    -1.608777,    -0.371538,
+    2.368115,    -1.191163,    -1.406593,
+    -1.065409,    -1.078968,    -0.123134,
+    1.108385,    -1.095024,    0.261038,
+    0.393122,    -1.571681,    1.403090,
+    1.653722,    -0.929450,    0.079146,
+    1.836145,    -1.748140,    1.468524,
+    0.808015,    -0.296733,    0.491675,
+    0.408593,    -0.039548,    -0.376804,
+    -0.868085,    1.183082,    1.174984,
+    2.556034,    -1.324481,    -0.623735,
+    -0.317198,    -1.251964,    0.003302,
+    -0.746396,    0.134150,    -0.655349,
+    -0.588157,    0.583343,    1.077994,
+    -0.849112,    0.363255,    0.559788,
+    1.772731,    -0.956565,    -0.741137,
+    -0.740562,    -1.152482,    -1.438068,
+    -0.903738,    1.216870,    -0.861226,
+    -0.637607,    0.709892,    -0.520001,
+    -0.599374,    0.006084,    1.336399,
+    0.548977,    -0.200185,    1.497042,
+    1.569532,    -1.037087,    -1.402498,
+    -1.390690,    1.162864,    0.229201,
+    1.093533,    -1.741239,    0.030380,
+    1.207128,    -0.542753,    0.076171,
+    0.772027,    -0.322497,    -0.091892,
+    0.910100,    -1.056161,    1.270283,
+    -0.191226,    0.375054,    -0.593917,
+    2.191696,    -1.161167,    0.021031,
+    2.499033,    -1.368037,    0.582858,
+    0.368434,    -0.063383,    -1.453424,
+    -0.938682,    1.219279,    0.743326,
+    0.165899,    0.098920,    1.420532,
+    1.877879,    -1.723302,    -0.207626,
+    -0.806654,    -1.152572,    0.567016,
+    1.193183,    -0.537662,    -1.002787,
+    -0.009241,    0.283837,    -0.083520,
+    -0.219172,    0.432746,    1.465391,
+    -0.272430,    -1.324083,    1.520617,
+    1.391158,    -0.703687,    1.427308,
+    1.197129,    -0.529837,    -1.498914,
+    0.680209,    -0.487463,    0.996526
 };
 
 static const int y_train_reduced[] = {
-    1, 1, 1, 1, 1, 0, 1, 0, 0, 1, 0, 0, 1, 0, 1, 
-    1, 0, 1, 0, 0, 1, 1, 0, 1, 0, 0, 0, 1, 0, 1, 
-    0, 1, 0, 0, 1, 0, 1, 0, 0, 1, 0, 0, 1, 1, 1, 
-    0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1, 0, 1, 1, 1, 
-    0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 
-    1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 
-    1, 1, 1, 0, 1, 0, 1, 0, 1, 0
+    0, 0, 1, 0, 1, 1, 0, 1, 1, 0, 0, 0, 0, 1, 0, 
+    0, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 0, 
+    1, 1, 1, 0, 1, 1, 0, 0, 0, 0, 1, 0, 1, 1, 1, 
+    1, 0, 1, 1, 1, 0, 0, 0, 0, 1, 1, 0, 1, 1, 1, 
+    1, 0, 0, 1, 0, 1, 1, 0, 1, 0, 0, 0, 1, 1, 1, 
+    1, 1, 0, 0, 1, 1, 1, 0, 1, 0, 0, 1, 0, 1, 0, 
+    0, 1, 0, 1, 1, 0, 0, 0, 0, 0
 };
 
 static const float scaler_mean[] = {
-    24.282041, 58.454632, 45.330381
+    24.274019, 58.340806, 45.335799
 };
 
 static const float scaler_scale[] = {
-    6.754801, 30.041003, 26.026996
+    6.756390, 30.014966, 25.950985
+};
+
+#define KD_LEAF_SIZE 8
+
+static const unsigned short kd_index[] = {
+    38, 44, 24, 74, 60, 32, 9, 22, 11, 70, 31, 85, 35, 28, 25, 
+    47, 34, 49, 8, 75, 27, 76, 42, 50, 2, 94, 10, 96, 69, 92, 
+    53, 21, 37, 56, 77, 41, 72, 95, 18, 80, 14, 45, 89, 12, 71, 
+    29, 67, 33, 3, 1, 23, 81, 55, 16, 58, 26, 13, 15, 4, 83, 
+    30, 88, 66, 48, 98, 40, 59, 79, 93, 5, 73, 68, 57, 91, 86, 
+    82, 0, 36, 62, 84, 54, 99, 52, 65, 78, 19, 7, 90, 61, 63, 
+    17, 87, 6, 20, 43, 46, 97, 51, 39, 64
+};
+
+static const unsigned char kd_split_dim[] = {
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 
+    0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 
+    0, 0, 1, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 2, 
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 
+    2, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 
+    0, 0, 0, 0, 2, 0, 0, 0, 0, 0
+};
+
+#define KNN_Q_SHIFT 10
+#define KNN_Q_MAX 8191
+
+static const short X_train_q[] = {
+    1077, -983, -933, -689, 786, 1845, 1821, 343, -955, -204, -123, -613, -758, 426, -806, 
+    1067, 510, 1730, -304, 485, 1236, -1326, -393, 92, -733, -770, 814, -1396, -932, -1431, 
+    614, -142, -1163, -1123, -930, -602, 346, -161, -153, 1218, 1896, -54, -875, 1788, -135, 
+    -915, 2584, -1485, 1221, -500, -1081, 1880, 987, -782, 374, 1185, -373, 1229, 478, 2425, 
+    -1091, 1135, 403, 1693, 1880, 827, 418, -889, 2617, -325, -764, -602, -869, 1815, -758, 
+    -925, -653, -614, 562, 1607, -1424, 1120, 1236, 791, 932, -196, 2244, 2559, 377, -961, 
+    170, 1923, -826, 1222, -9, -224, -279, 1425, 1226, 697, -1760, 1244, 1231, 727, -342, 
+    -1776, -1039, -39, 757, -536, -1369, -90, 827, -698, 793, -426, -1671, -1758, 462, -93, 
+    -557, -884, -375, 141, -1199, 701, -975, 1200, 1232, 1216, -188, 329, -937, 706, 1234, 
+    498, -1639, -552, -1354, -1770, -1768, 192, 1233, -1744, -1321, 1239, -1424, 1155, -1753, 642, 
+    727, -1128, -433, -1150, -738, -1760, -415, -970, -1647, -1220, -1105, -1121, -1609, -952, -1790, 
+    -304, -40, 1211, -1356, -1282, 137, 597, 372, -980, -1180, 1246, 727, 6, -205, -1062, 
+    1191, -1783, -556, -330, -1082, 384, -1189, -1401, -65, 1249, 101, -1765, -1180, -551, 291, 
+    443, -1356, -721, -543, -499, 803, 1587, -94, 1554, -1468, -855, 790, 272, -975, -1099, 
+    881, -1438, 780, -592, 249, -559, -1257, 362, 409, 905, 809, 1111, -216, -962, -705, 
+    -1562, -1319, -644, -1591, 1125, -927, -1499, -1135, 1405, -1232, -93, 369, 1414, -750, 1488, 
+    -1503, 875, -479, 971, -1419, 334, 1379, -1489, -668, -1124, -264, 1468, 1462, 1404, 260, 
+    -1422, 601, -486, -380, -1440, -126, 267, 1437, 81, 1504, 503, -386, 1203, -639, 3, 
+    -671, 1104, 573, -759, -1473, -882, -532, 1368, 1533, -1436, 235, 31, 78, -94, 1301, 
+    -608, 22, 597, -1488, 761, 1455, -213, 581, -1027, -86, 1501, 1557, 1462, -1535, 1020
+};
+
+#define KNN_CONF_BINS 10
+
+static const float knn_conf_calibration[] = {
+    0.5000, 0.5000, 0.5000, 0.5000, 0.5862, 0.5974, 0.5974, 0.5974, 0.5974, 0.6784
 };
 
 #endif // MODEL_DATA_H
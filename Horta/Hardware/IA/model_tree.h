@@ -0,0 +1,47 @@
+#ifndef MODEL_TREE_H
+#define MODEL_TREE_H
+
+// Gerado por host/knn_train --tree (árvore de decisão CART, Gini).
+// Entrada crua, sem padronização: temperatura, umidade do ar, umidade do solo.
+
+#define TREE_DEPTH 4
+#define TREE_LEAVES 6
+#define TREE_CLASSES 2
+
+// confidence: fração das amostras de treino da folha com o rótulo devolvido
+inline int tree_predict_confidence(const float *input, float *confidence) {
+    if (input[2] <= 59.5f) {
+        if (input[2] <= 20.5f) {
+            *confidence = 0.7533f;
+            return 1;
+        } else {
+            if (input[0] <= 37.8250008f) {
+                if (input[0] <= 37.4749985f) {
+                    *confidence = 0.6053f;
+                    return 1;
+                } else {
+                    *confidence = 0.6452f;
+                    return 0;
+                }
+            } else {
+                if (input[1] <= 3.19500017f) {
+                    *confidence = 0.5833f;
+                    return 0;
+                } else {
+                    *confidence = 0.6792f;
+                    return 1;
+                }
+            }
+        }
+    } else {
+        *confidence = 0.6828f;
+        return 0;
+    }
+}
+
+inline int tree_predict(const float *input) {
+    float confidence;
+    return tree_predict_confidence(input, &confidence);
+}
+
+#endif // MODEL_TREE_H
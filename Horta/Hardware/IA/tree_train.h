@@ -0,0 +1,265 @@
+/*
+    Treinamento da árvore de decisão (somente host)
+
+    Alternativa ao KNN para o firmware: uma árvore CART (índice de Gini)
+    treinada sobre as leituras cruas, sem padronização, e exportada como
+    código C++ só com desvios (model_tree.h):
+
+        inline int tree_predict_confidence(const float *input, float *confidence) {
+            if (input[2] <= 512.5f) {
+                ...
+
+    Cada folha devolve também a fração das amostras de treino que caíram nela
+    com o rótulo escolhido, que o TreeEngine publica como confiança.
+
+    A inferência custa no máximo max_depth comparações de float, sem
+    distâncias, sqrt ou tabelas. Os limiares são floats exatos (%.9g): a
+    predição de tree_train_predict() é bit a bit a do código gerado.
+
+    Usa a mesma divisão treino/teste do knn_train.h (KnnTrainData com as
+    features em linhas, antes da padronização).
+*/
+
+#ifndef TREE_TRAIN_H
+#define TREE_TRAIN_H
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "knn_train.h"
+
+// ======= CONFIGURAÇÃO =======
+struct TreeTrainConfig {
+    int max_depth = 4;              // Comparações por predição, no máximo
+    size_t min_samples_leaf = 20;   // Amostras de treino mínimas em cada folha
+    unsigned n_threads = 0;         // 0 = todos os núcleos (busca do corte por feature)
+};
+
+// Nó interno: input[feature] <= threshold vai para left. Folha: feature = -1.
+struct TreeNode {
+    int feature;
+    float threshold;
+    int left;
+    int right;
+    int label;
+    size_t samples;
+    float confidence;               // Fração das amostras de treino do nó com o rótulo
+};
+
+struct TreeModel {
+    std::vector<TreeNode> nodes;    // nodes[0] = raiz
+    int depth = 0;
+    int leaves = 0;
+    int n_classes = 0;
+};
+
+// ======= BUSCA DO CORTE =======
+struct TreeSplit {
+    int feature = -1;
+    float threshold = 0;
+    double impurity = 0;            // Gini ponderado pelo número de amostras
+};
+
+inline double tree_train_gini(const size_t *counts, int n_classes, size_t total) {
+    if (total == 0) return 0;
+    double sum = 0;
+    for (int c = 0; c < n_classes; c++) {
+        double p = (double)counts[c] / total;
+        sum += p * p;
+    }
+    return (1.0 - sum) * total;
+}
+
+// Limiar entre dois valores consecutivos distintos: a <= limiar < b
+inline float tree_train_threshold(float a, float b) {
+    float middle = (float)(((double)a + (double)b) / 2);
+    return (middle >= a && middle < b) ? middle : a;
+}
+
+// Melhor corte de uma feature para as amostras idx[0, n)
+inline TreeSplit tree_train_best_split(const KnnTrainData &data, const unsigned *idx, size_t n, int feature,
+                                       int n_classes, size_t min_leaf,
+                                       std::vector<std::pair<float, int>> &sorted) {
+    sorted.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        sorted[i] = std::make_pair(data.X[(size_t)idx[i] * N_FEATURES + feature], data.y[idx[i]]);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t total[KNN_TRAIN_MAX_CLASSES] = {0};
+    for (size_t i = 0; i < n; i++) total[sorted[i].second]++;
+
+    TreeSplit best;
+    size_t left[KNN_TRAIN_MAX_CLASSES] = {0};
+    size_t right[KNN_TRAIN_MAX_CLASSES];
+    for (size_t i = 0; i + 1 < n; i++) {
+        left[sorted[i].second]++;
+        if (sorted[i].first == sorted[i + 1].first) continue;
+        const size_t nLeft = i + 1;
+        if (nLeft < min_leaf || n - nLeft < min_leaf) continue;
+
+        for (int c = 0; c < n_classes; c++) right[c] = total[c] - left[c];
+        double impurity = tree_train_gini(left, n_classes, nLeft) + tree_train_gini(right, n_classes, n - nLeft);
+        if (best.feature < 0 || impurity < best.impurity) {
+            best.feature = feature;
+            best.threshold = tree_train_threshold(sorted[i].first, sorted[i + 1].first);
+            best.impurity = impurity;
+        }
+    }
+    return best;
+}
+
+// ======= CONSTRUÇÃO =======
+// Constrói o nó das amostras idx[lo, hi) e devolve seu índice em model.nodes
+inline int tree_train_build(const KnnTrainData &data, std::vector<unsigned> &idx, size_t lo, size_t hi, int depth,
+                            const TreeTrainConfig &config, TreeModel &model) {
+    const size_t n = hi - lo;
+    size_t counts[KNN_TRAIN_MAX_CLASSES] = {0};
+    for (size_t i = lo; i < hi; i++) counts[data.y[idx[i]]]++;
+    int label = 0;
+    for (int c = 1; c < model.n_classes; c++) {
+        if (counts[c] > counts[label]) label = c;  // Empate fica com a menor classe
+    }
+
+    const int node = (int)model.nodes.size();
+    model.nodes.push_back(TreeNode{-1, 0.0f, -1, -1, label, n, n > 0 ? (float)counts[label] / n : 0.0f});
+    model.depth = std::max(model.depth, depth);
+    if (depth >= config.max_depth || counts[label] == n || n < 2 * config.min_samples_leaf) {
+        model.leaves++;
+        return node;
+    }
+
+    // Uma feature por thread; nós pequenos ficam numa thread só
+    TreeSplit splits[N_FEATURES];
+    const unsigned threads = n >= 50000 ? config.n_threads : 1u;
+    knn_train_parallel(N_FEATURES, threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<std::pair<float, int>> sorted;
+        for (size_t f = begin; f < end; f++) {
+            splits[f] = tree_train_best_split(data, &idx[lo], n, (int)f, model.n_classes,
+                                              config.min_samples_leaf, sorted);
+        }
+    });
+    TreeSplit best;
+    for (int f = 0; f < N_FEATURES; f++) {
+        if (splits[f].feature >= 0 && (best.feature < 0 || splits[f].impurity < best.impurity)) best = splits[f];
+    }
+    if (best.feature < 0 || best.impurity >= tree_train_gini(counts, model.n_classes, n)) {
+        model.leaves++;
+        return node;
+    }
+
+    const float *X = data.X.data();
+    size_t mid = (size_t)(std::partition(idx.begin() + lo, idx.begin() + hi, [&](unsigned i) {
+        return X[(size_t)i * N_FEATURES + best.feature] <= best.threshold;
+    }) - idx.begin());
+
+    int left = tree_train_build(data, idx, lo, mid, depth + 1, config, model);
+    int right = tree_train_build(data, idx, mid, hi, depth + 1, config, model);
+
+    // Dois filhos folha com o mesmo rótulo não mudam nenhuma predição: o nó vira folha
+    const TreeNode &l = model.nodes[left];
+    const TreeNode &r = model.nodes[right];
+    if (l.feature < 0 && r.feature < 0 && l.label == r.label) {
+        const int merged = l.label;
+        const float confidence = (l.confidence * l.samples + r.confidence * r.samples) / n;
+        model.nodes.resize(left);  // Os filhos são os últimos nós criados
+        model.leaves -= 1;
+        model.nodes[node].label = merged;
+        model.nodes[node].confidence = confidence;
+        return node;
+    }
+    TreeNode &current = model.nodes[node];
+    current.feature = best.feature;
+    current.threshold = best.threshold;
+    current.left = left;
+    current.right = right;
+    return node;
+}
+
+inline int tree_train_node_depth(const TreeModel &model, int node) {
+    const TreeNode &n = model.nodes[node];
+    if (n.feature < 0) return 0;
+    return 1 + std::max(tree_train_node_depth(model, n.left), tree_train_node_depth(model, n.right));
+}
+
+inline bool tree_train_fit(const KnnTrainData &train, const TreeTrainConfig &config, TreeModel &model) {
+    if (train.size() == 0 || config.max_depth < 0 || config.min_samples_leaf < 1) return false;
+    int maxLabel = 0;
+    for (size_t i = 0; i < train.size(); i++) {
+        if (train.y[i] < 0 || train.y[i] >= KNN_TRAIN_MAX_CLASSES) return false;
+        maxLabel = std::max(maxLabel, train.y[i]);
+    }
+
+    model = TreeModel();
+    model.n_classes = std::max(2, maxLabel + 1);
+    std::vector<unsigned> idx(train.size());
+    for (size_t i = 0; i < idx.size(); i++) idx[i] = (unsigned)i;
+    tree_train_build(train, idx, 0, idx.size(), 0, config, model);
+    model.depth = tree_train_node_depth(model, 0);  // Profundidade depois da poda
+    return true;
+}
+
+// ======= AVALIAÇÃO =======
+// Mesmas comparações do tree_predict() gerado
+inline int tree_train_predict(const TreeModel &model, const float *input) {
+    int node = 0;
+    while (model.nodes[node].feature >= 0) {
+        const TreeNode &n = model.nodes[node];
+        node = input[n.feature] <= n.threshold ? n.left : n.right;
+    }
+    return model.nodes[node].label;
+}
+
+inline double tree_train_accuracy(const TreeModel &model, const KnnTrainData &test) {
+    size_t hits = 0;
+    for (size_t i = 0; i < test.size(); i++) {
+        if (tree_train_predict(model, &test.X[i * N_FEATURES]) == test.y[i]) hits++;
+    }
+    return test.size() > 0 ? (double)hits / test.size() : 0.0;
+}
+
+// ======= EXPORTAÇÃO =======
+inline void tree_train_write_node(FILE *out, const TreeModel &model, int node, int indent) {
+    const TreeNode &n = model.nodes[node];
+    if (n.feature < 0) {
+        fprintf(out, "%*s*confidence = %.4ff;\n", indent, "", n.confidence);
+        fprintf(out, "%*sreturn %d;\n", indent, "", n.label);
+        return;
+    }
+    char threshold[32];
+    snprintf(threshold, sizeof(threshold), "%.9g", n.threshold);
+    if (strpbrk(threshold, ".e") == NULL) strcat(threshold, ".0");  // "60f" não é literal válido
+    fprintf(out, "%*sif (input[%d] <= %sf) {\n", indent, "", n.feature, threshold);
+    tree_train_write_node(out, model, n.left, indent + 4);
+    fprintf(out, "%*s} else {\n", indent, "");
+    tree_train_write_node(out, model, n.right, indent + 4);
+    fprintf(out, "%*s}\n", indent, "");
+}
+
+inline bool tree_train_write_header(const char *path, const TreeModel &model) {
+    FILE *out = fopen(path, "w");
+    if (!out) return false;
+
+    fprintf(out, "#ifndef MODEL_TREE_H\n");
+    fprintf(out, "#define MODEL_TREE_H\n\n");
+    fprintf(out, "// Gerado por host/knn_train --tree (árvore de decisão CART, Gini).\n");
+    fprintf(out, "// Entrada crua, sem padronização: temperatura, umidade do ar, umidade do solo.\n\n");
+    fprintf(out, "#define TREE_DEPTH %d\n", model.depth);
+    fprintf(out, "#define TREE_LEAVES %d\n", model.leaves);
+    fprintf(out, "#define TREE_CLASSES %d\n\n", model.n_classes);
+    fprintf(out, "// confidence: fração das amostras de treino da folha com o rótulo devolvido\n");
+    fprintf(out, "inline int tree_predict_confidence(const float *input, float *confidence) {\n");
+    tree_train_write_node(out, model, 0, 4);
+    fprintf(out, "}\n\n");
+    fprintf(out, "inline int tree_predict(const float *input) {\n");
+    fprintf(out, "    float confidence;\n");
+    fprintf(out, "    return tree_predict_confidence(input, &confidence);\n");
+    fprintf(out, "}\n\n");
+    fprintf(out, "#endif // MODEL_TREE_H\n");
+    return fclose(out) == 0;
+}
+
+#endif // TREE_TRAIN_H